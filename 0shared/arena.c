@@ -0,0 +1,154 @@
+/*--------------------------------------------------------------------*/
+/* arena.c                                                            */
+/* Author: Maxwell Lloyd and Venus Dinari                             */
+/*--------------------------------------------------------------------*/
+
+#ifdef THREADSAFE
+#define _POSIX_C_SOURCE 200112L
+#include <sched.h>
+#endif
+#include <assert.h>
+#include <stdlib.h>
+
+#include "arena.h"
+
+/*
+  The number of bytes requested for each block. A block this large is
+  mapped by malloc on its own, so releasing it is a single munmap. An
+  object too large to leave most of a block for others gets a block
+  of its own. Each block begins with a header of ARENA_ALIGN bytes
+  holding the link to the block before it.
+*/
+enum { BLOCK_SIZE = 1024 * 1024, LARGE_OBJECT = BLOCK_SIZE / 4 };
+
+/* Acquires psArena, in the THREADSAFE build, as Slab_lock does. */
+static void Arena_lock(struct Arena *psArena) {
+   assert(psArena != NULL);
+#ifdef THREADSAFE
+   while(__atomic_exchange_n(&psArena->iLocked, 1, __ATOMIC_ACQUIRE))
+      (void) sched_yield();
+#endif
+}
+
+/* Releases psArena, in the THREADSAFE build. */
+static void Arena_unlock(struct Arena *psArena) {
+   assert(psArena != NULL);
+#ifdef THREADSAFE
+   __atomic_store_n(&psArena->iLocked, 0, __ATOMIC_RELEASE);
+#endif
+}
+
+/*
+  Returns the size class of an object of ulSize bytes, and stores in
+  *pulClassSize the size of every object of that class.
+*/
+static size_t Arena_class(size_t ulSize, size_t *pulClassSize) {
+   size_t ulClass;
+
+   assert(pulClassSize != NULL);
+
+   if(ulSize <= ARENA_SMALL) {
+      ulClass = ulSize == 0 ? 0 : (ulSize - 1) / ARENA_ALIGN;
+      *pulClassSize = (ulClass + 1) * ARENA_ALIGN;
+      return ulClass;
+   }
+
+   ulClass = ARENA_SMALL / ARENA_ALIGN;
+   for(*pulClassSize = 2 * ARENA_SMALL; *pulClassSize < ulSize;
+       *pulClassSize *= 2)
+      ulClass++;
+   return ulClass;
+}
+
+/*
+  Allocates a block with room for ulSize bytes after its header and
+  links it into psArena's list. Returns the room, or NULL if the block
+  could not be allocated.
+*/
+static char *Arena_addBlock(struct Arena *psArena, size_t ulSize) {
+   void **ppvBlock;
+
+   assert(psArena != NULL);
+
+   ppvBlock = malloc(ARENA_ALIGN + ulSize);
+   if(ppvBlock == NULL)
+      return NULL;
+   *ppvBlock = psArena->pvBlocks;
+   psArena->pvBlocks = ppvBlock;
+   return (char *) ppvBlock + ARENA_ALIGN;
+}
+
+void *Arena_alloc(struct Arena *psArena, size_t ulSize) {
+   void *pvObject;
+   size_t ulClass;
+   size_t ulClassSize;
+
+   assert(psArena != NULL);
+
+   ulClass = Arena_class(ulSize, &ulClassSize);
+
+   Arena_lock(psArena);
+
+   /* reuse the object of this class freed most recently */
+   pvObject = psArena->apvFree[ulClass];
+   if(pvObject != NULL) {
+      psArena->apvFree[ulClass] = *(void **) pvObject;
+      Arena_unlock(psArena);
+      return pvObject;
+   }
+
+   if(ulClassSize > LARGE_OBJECT)
+      pvObject = Arena_addBlock(psArena, ulClassSize);
+   else {
+      /* carve from the newest block, starting one if need be; what
+         is left of the old one is not used again */
+      if((size_t) (psArena->pcEnd - psArena->pcNext) < ulClassSize) {
+         psArena->pcNext = Arena_addBlock(psArena,
+                                          BLOCK_SIZE - ARENA_ALIGN);
+         psArena->pcEnd = psArena->pcNext == NULL ? NULL :
+            psArena->pcNext + BLOCK_SIZE - ARENA_ALIGN;
+      }
+      pvObject = psArena->pcNext;
+      if(pvObject != NULL)
+         psArena->pcNext += ulClassSize;
+   }
+
+   Arena_unlock(psArena);
+   return pvObject;
+}
+
+void Arena_free(struct Arena *psArena, void *pvObject, size_t ulSize) {
+   size_t ulClass;
+   size_t ulClassSize;
+
+   assert(psArena != NULL);
+
+   if(pvObject == NULL)
+      return;
+
+   ulClass = Arena_class(ulSize, &ulClassSize);
+
+   /* the object's first bytes link it into the free list */
+   Arena_lock(psArena);
+   *(void **) pvObject = psArena->apvFree[ulClass];
+   psArena->apvFree[ulClass] = pvObject;
+   Arena_unlock(psArena);
+}
+
+void Arena_release(struct Arena *psArena) {
+   void *pvBlock;
+   void *pvPrev;
+   size_t ulClass;
+
+   assert(psArena != NULL);
+
+   for(pvBlock = psArena->pvBlocks; pvBlock != NULL; pvBlock = pvPrev) {
+      pvPrev = *(void **) pvBlock;
+      free(pvBlock);
+   }
+   psArena->pvBlocks = NULL;
+   psArena->pcNext = NULL;
+   psArena->pcEnd = NULL;
+   for(ulClass = 0; ulClass < ARENA_CLASSES; ulClass++)
+      psArena->apvFree[ulClass] = NULL;
+}
@@ -0,0 +1,86 @@
+/*--------------------------------------------------------------------*/
+/* atom.h                                                             */
+/* Author: Maxwell Lloyd and Venus Dinari                             */
+/*--------------------------------------------------------------------*/
+
+#ifndef ATOM_INCLUDED
+#define ATOM_INCLUDED
+
+#include <stddef.h>
+#include "a4def.h"
+
+/*
+  An atom is a unique, immutable, '\0'-terminated copy of a string
+  held in a process-wide table. There is only ever one atom for a
+  given sequence of characters, so two atoms are equal exactly when
+  they are the same pointer, and comparing them for equality is a
+  single integer comparison.
+
+  Atoms are reference counted: each successful Atom_new or
+  Atom_retain must be balanced by an Atom_free, and the atom's memory
+  is reclaimed when its last reference is freed.
+
+  When compiled with THREADSAFE defined, the table is guarded by a
+  reader-writer lock, so any of these functions may be called from
+  any thread.
+*/
+
+/*
+  Interns the ulLength characters at pcStr, which need not be
+  '\0'-terminated and must not contain '\0'. Returns an int SUCCESS
+  status and sets *ppcResult to the atom for those characters, adding
+  a reference to it. Otherwise, sets *ppcResult to NULL and returns
+  status:
+  * MEMORY_ERROR if memory could not be allocated to complete request
+*/
+int Atom_new(const char *pcStr, size_t ulLength,
+             const char **ppcResult);
+
+/*
+  Returns the atom for the ulLength characters at pcStr if one
+  exists, or NULL if no atom has those characters. Adds no reference
+  and does not allocate memory.
+*/
+const char *Atom_find(const char *pcStr, size_t ulLength);
+
+/* Adds a reference to atom pcAtom and returns pcAtom. */
+const char *Atom_retain(const char *pcAtom);
+
+/*
+  Removes a reference to atom pcAtom, reclaiming its memory if that
+  was the last one. Does nothing if pcAtom is NULL.
+*/
+void Atom_free(const char *pcAtom);
+
+/* Returns the length (not including trailing '\0') of atom pcAtom. */
+size_t Atom_getLength(const char *pcAtom);
+
+/*
+  Returns the hash of atom pcAtom's characters, as computed when it
+  was interned, so tables keyed by atoms need not rehash strings.
+*/
+size_t Atom_getHash(const char *pcAtom);
+
+/*
+  Returns the hash Atom_getHash would give an atom of the ulLength
+  characters at pcStr, whether or not such an atom exists. Does not
+  use the table, so no lock is taken in the THREADSAFE build.
+*/
+size_t Atom_hash(const char *pcStr, size_t ulLength);
+
+/*
+  Returns the number of bytes Atom_copy needs to copy atom pcAtom.
+*/
+size_t Atom_copySize(const char *pcAtom);
+
+/*
+  Writes into pvDest, which must have room for Atom_copySize(pcAtom)
+  bytes and be aligned for a size_t, an unshared copy of atom pcAtom,
+  and returns the copy. Atom_getLength and Atom_getHash accept the
+  copy as they do pcAtom, but it is not in the table: it is never the
+  same pointer as an atom, holds no reference, and must not be passed
+  to Atom_retain or Atom_free. Its memory belongs to the caller.
+*/
+const char *Atom_copy(const char *pcAtom, void *pvDest);
+
+#endif
@@ -7,8 +7,10 @@
 #include <stdlib.h>
 #include <string.h>
 
+#include "atom.h"
 #include "dynarray.h"
 #include "path.h"
+#include "slab.h"
 
 /* An absolute path */
 struct path {
@@ -17,22 +19,43 @@ struct path {
    const char *pcPath;
    /* The string length of pcPath */
    size_t ulLength;
-   /* The ordered collection of component strings in the path */
+   /* The ordered collection of component atoms in the path */
    DynArray_T oDComponents;
 };
 
+/* Path objects are allocated from a slab */
+static struct Slab sPathSlab = SLAB_INITIALIZER(sizeof(struct path));
+
+/*
+  Returns a new path with every field NULL or 0, or NULL if memory
+  could not be allocated.
+*/
+static struct path *Path_alloc(void) {
+   struct path *psNew;
+
+   psNew = Slab_alloc(&sPathSlab);
+   if(psNew != NULL) {
+      psNew->pcPath = NULL;
+      psNew->ulLength = 0;
+      psNew->oDComponents = NULL;
+   }
+   return psNew;
+}
+
 /*
-  Frees pcStr. This wrapper is used to match the requirements of the
-  callback function pointer passed to DynArray_map. pvExtra is unused.
+  Releases the reference held on atom pcAtom. This wrapper is used to
+  match the requirements of the callback function pointer passed to
+  DynArray_map. pvExtra is unused.
 */
-static void Path_freeString(char *pcStr, void *pvExtra) {
-   /* pcStr may be NULL, as this is a no-op to free.
+static void Path_freeAtom(const char *pcAtom, void *pvExtra) {
+   /* pcAtom may be NULL, as this is a no-op to free.
       pvExtra may be NULL, as it is unused. */
-   free(pcStr);
+   (void) pvExtra;
+   Atom_free(pcAtom);
 }
 
 /*
-  Sets *poDComponents to be an ordered collection of component strings
+  Sets *poDComponents to be an ordered collection of component atoms
   in pcPath, or NULL if an error occurs.
   Returns one of the following statuses:
   * SUCCESS if no error occurrs
@@ -44,7 +67,7 @@ static void Path_freeString(char *pcStr, void *pvExtra) {
 static int Path_split(const char *pcPath, DynArray_T *poDComponents) {
    const char *pcStart = pcPath;
    const char *pcEnd = pcPath;
-   char *pcCopy;
+   const char *pcAtom;
    DynArray_T oDSubstrings;
 
    assert(pcPath != NULL);
@@ -68,7 +91,7 @@ static int Path_split(const char *pcPath, DynArray_T *poDComponents) {
       /* component can't start with delimiter */
       if(*pcEnd == '/') {
          DynArray_map(oDSubstrings,
-                      (void (*)(void*, void*)) Path_freeString, NULL);
+                      (void (*)(void*, void*)) Path_freeAtom, NULL);
          DynArray_free(oDSubstrings);
          *poDComponents = NULL;
          return BAD_PATH;
@@ -81,36 +104,31 @@ static int Path_split(const char *pcPath, DynArray_T *poDComponents) {
       /* final component can't end with slash */
       if(*pcEnd == '\0' && *(pcEnd-1) == '/') {
          DynArray_map(oDSubstrings,
-                      (void (*)(void*, void*)) Path_freeString, NULL);
+                      (void (*)(void*, void*)) Path_freeAtom, NULL);
          DynArray_free(oDSubstrings);
          *poDComponents = NULL;
          return BAD_PATH;
       }
 
-      pcCopy = calloc((size_t)(pcEnd-pcStart+1), sizeof(char));
-      if(pcCopy == NULL) {
+      if(Atom_new(pcStart, (size_t)(pcEnd-pcStart),
+                  &pcAtom) != SUCCESS) {
          DynArray_map(oDSubstrings,
-                      (void (*)(void*, void*)) Path_freeString, NULL);
+                      (void (*)(void*, void*)) Path_freeAtom, NULL);
          DynArray_free(oDSubstrings);
          *poDComponents = NULL;
          return MEMORY_ERROR;
       }
 
-      if( DynArray_add(oDSubstrings, pcCopy) == 0) {
+      if( DynArray_add(oDSubstrings, pcAtom) == 0) {
+         Atom_free(pcAtom);
          DynArray_map(oDSubstrings,
-                      (void (*)(void*, void*)) Path_freeString, NULL);
+                      (void (*)(void*, void*)) Path_freeAtom, NULL);
          DynArray_free(oDSubstrings);
          *poDComponents = NULL;
          return MEMORY_ERROR;
       }
 
-      while(pcStart != pcEnd) {
-         *pcCopy = *pcStart;
-         pcCopy++;
-         pcStart++;
-      }
-
-      pcStart++;
+      pcStart = pcEnd + 1;
    }
 
    *poDComponents = oDSubstrings;
@@ -125,7 +143,7 @@ int Path_new(const char *pcPath, Path_T *poPResult) {
    assert(pcPath != NULL);
    assert(poPResult != NULL);
 
-   psNew = calloc(1, sizeof(struct path));
+   psNew = Path_alloc();
    if(psNew == NULL) {
       *poPResult = NULL;
       return MEMORY_ERROR;
@@ -156,7 +174,6 @@ int Path_prefix(Path_T oPPath, size_t ulDepth, Path_T *poPResult) {
    struct path *psNew;
    size_t ulIndex, ulLength, ulSum;
    const char *pcComponent;
-   char *pcCopy;
    char *pcBuild;
    char *pcInsert;
 
@@ -175,7 +192,7 @@ int Path_prefix(Path_T oPPath, size_t ulDepth, Path_T *poPResult) {
       return NO_SUCH_PATH;
    }
 
-   psNew = calloc(1, sizeof(struct path));
+   psNew = Path_alloc();
    if(psNew == NULL) {
       *poPResult = NULL;
       return MEMORY_ERROR;
@@ -199,18 +216,11 @@ int Path_prefix(Path_T oPPath, size_t ulDepth, Path_T *poPResult) {
    ulSum = 0;
 
    for(ulIndex = 0; ulIndex < ulDepth; ulIndex++) {
-      /* deep copy each component to new DynArray */
+      /* share each component's atom with the new DynArray */
       pcComponent = Path_getComponent(oPPath, ulIndex);
-      ulLength = strlen(pcComponent);
-      pcCopy = calloc(ulLength + 1, sizeof(char));
-      if(pcCopy == NULL) {
-         free(pcBuild);
-         Path_free(psNew);
-         *poPResult = NULL;
-         return MEMORY_ERROR;
-      }
-      strcpy(pcCopy, pcComponent);
-      (void) DynArray_set(psNew->oDComponents, ulIndex, pcCopy);
+      ulLength = Atom_getLength(pcComponent);
+      (void) DynArray_set(psNew->oDComponents, ulIndex,
+                          Atom_retain(pcComponent));
       /* construct prefix's pathname string */
       strcpy(pcInsert, pcComponent);
       pcInsert[ulLength] = '/';
@@ -247,11 +257,11 @@ void Path_free(Path_T oPPath) {
 
       if(oPPath->oDComponents != NULL) {
          DynArray_map(oPPath->oDComponents,
-                      (void (*)(void*, void*)) Path_freeString, NULL);
+                      (void (*)(void*, void*)) Path_freeAtom, NULL);
          DynArray_free(oPPath->oDComponents);
       }
    }
-   free((struct path*) oPPath);
+   Slab_free(&sPathSlab, (struct path*) oPPath);
 }
 
 const char *Path_getPathname(Path_T oPPath) {
@@ -298,9 +308,9 @@ size_t Path_getSharedPrefixDepth(Path_T oPPath1, Path_T oPPath2) {
       ulMin = ulDepth1;
    else
       ulMin = ulDepth2;
+   /* components are atoms, so equal components are equal pointers */
    for(i = 0; i < ulMin; i++) {
-      if(strcmp(Path_getComponent(oPPath1, i),
-                Path_getComponent(oPPath2, i)))
+      if(Path_getComponent(oPPath1, i) != Path_getComponent(oPPath2, i))
          return i;
    }
    return ulMin;
@@ -314,3 +324,71 @@ const char *Path_getComponent(Path_T oPPath, size_t ulLevel) {
 
    return DynArray_get(oPPath->oDComponents, ulLevel);
 }
+
+int PathView_init(struct PathView *psView, const char *pcPath) {
+   const char *pcCurr;
+   size_t ulDepth = 1;
+
+   assert(psView != NULL);
+   assert(pcPath != NULL);
+
+   /* path cannot be empty string or begin with a delimiter */
+   if(*pcPath == '\0' || *pcPath == '/')
+      return BAD_PATH;
+
+   for(pcCurr = pcPath; *pcCurr != '\0'; pcCurr++) {
+      if(*pcCurr == '/') {
+         /* each delimiter must be followed by a non-empty component */
+         if(*(pcCurr+1) == '/' || *(pcCurr+1) == '\0')
+            return BAD_PATH;
+         ulDepth++;
+      }
+   }
+
+   psView->pcPath = pcPath;
+   psView->ulLength = (size_t)(pcCurr - pcPath);
+   psView->ulDepth = ulDepth;
+   return SUCCESS;
+}
+
+const char *PathView_getPathname(const struct PathView *psView) {
+   assert(psView != NULL);
+
+   return psView->pcPath;
+}
+
+size_t PathView_getStrLength(const struct PathView *psView) {
+   assert(psView != NULL);
+
+   return psView->ulLength;
+}
+
+size_t PathView_getDepth(const struct PathView *psView) {
+   assert(psView != NULL);
+
+   return psView->ulDepth;
+}
+
+const char *PathView_nextComponent(const struct PathView *psView,
+                                   size_t *pulOffset,
+                                   size_t *pulLength) {
+   const char *pcStart;
+   const char *pcEnd;
+
+   assert(psView != NULL);
+   assert(pulOffset != NULL);
+   assert(pulLength != NULL);
+
+   if(*pulOffset >= psView->ulLength)
+      return NULL;
+
+   pcStart = psView->pcPath + *pulOffset;
+   pcEnd = pcStart;
+   while(*pcEnd != '/' && *pcEnd != '\0')
+      pcEnd++;
+
+   *pulLength = (size_t)(pcEnd - pcStart);
+   /* skip the component and the delimiter that follows it */
+   *pulOffset += *pulLength + 1;
+   return pcStart;
+}
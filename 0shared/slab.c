@@ -0,0 +1,112 @@
+/*--------------------------------------------------------------------*/
+/* slab.c                                                             */
+/* Author: Maxwell Lloyd and Venus Dinari                             */
+/*--------------------------------------------------------------------*/
+
+#ifdef THREADSAFE
+#define _POSIX_C_SOURCE 200112L
+#include <sched.h>
+#endif
+#include <assert.h>
+#include <stdlib.h>
+
+#include "slab.h"
+
+#ifndef SLAB_MALLOC
+
+/*
+  The number of bytes requested for each block, unless one object is
+  larger. malloc aligns a block for any type, and objects are carved
+  from it at multiples of their size, which is a multiple of
+  SLAB_ALIGN.
+*/
+enum { BLOCK_SIZE = 16384 };
+
+/*
+  Acquires psSlab, in the THREADSAFE build. The lock is held only for
+  a few pointer operations, or for one malloc, so a thread that finds
+  it taken yields rather than sleeping.
+*/
+static void Slab_lock(struct Slab *psSlab) {
+   assert(psSlab != NULL);
+#ifdef THREADSAFE
+   while(__atomic_exchange_n(&psSlab->iLocked, 1, __ATOMIC_ACQUIRE))
+      (void) sched_yield();
+#endif
+}
+
+/* Releases psSlab, in the THREADSAFE build. */
+static void Slab_unlock(struct Slab *psSlab) {
+   assert(psSlab != NULL);
+#ifdef THREADSAFE
+   __atomic_store_n(&psSlab->iLocked, 0, __ATOMIC_RELEASE);
+#endif
+}
+
+void *Slab_alloc(struct Slab *psSlab) {
+   void *pvObject;
+   size_t ulBlock;
+
+   assert(psSlab != NULL);
+   assert(psSlab->ulSize % SLAB_ALIGN == 0);
+
+   Slab_lock(psSlab);
+
+   /* reuse the object freed most recently */
+   pvObject = psSlab->pvFree;
+   if(pvObject != NULL) {
+      psSlab->pvFree = *(void **) pvObject;
+      Slab_unlock(psSlab);
+      return pvObject;
+   }
+
+   /* otherwise carve a new one, starting a block if need be */
+   if((size_t) (psSlab->pcEnd - psSlab->pcNext) < psSlab->ulSize) {
+      ulBlock = BLOCK_SIZE / psSlab->ulSize * psSlab->ulSize;
+      if(ulBlock == 0)
+         ulBlock = psSlab->ulSize;
+      psSlab->pcNext = malloc(ulBlock);
+      if(psSlab->pcNext == NULL) {
+         psSlab->pcEnd = NULL;
+         Slab_unlock(psSlab);
+         return NULL;
+      }
+      psSlab->pcEnd = psSlab->pcNext + ulBlock;
+   }
+   pvObject = psSlab->pcNext;
+   psSlab->pcNext += psSlab->ulSize;
+
+   Slab_unlock(psSlab);
+   return pvObject;
+}
+
+void Slab_free(struct Slab *psSlab, void *pvObject) {
+   assert(psSlab != NULL);
+
+   if(pvObject == NULL)
+      return;
+
+   /* the object's first bytes link it into the free list */
+   Slab_lock(psSlab);
+   *(void **) pvObject = psSlab->pvFree;
+   psSlab->pvFree = pvObject;
+   Slab_unlock(psSlab);
+}
+
+#else
+
+/* With SLAB_MALLOC defined, each object comes from malloc itself. */
+
+void *Slab_alloc(struct Slab *psSlab) {
+   assert(psSlab != NULL);
+
+   return malloc(psSlab->ulSize);
+}
+
+void Slab_free(struct Slab *psSlab, void *pvObject) {
+   assert(psSlab != NULL);
+
+   free(pvObject);
+}
+
+#endif
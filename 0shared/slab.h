@@ -0,0 +1,64 @@
+/*--------------------------------------------------------------------*/
+/* slab.h                                                             */
+/* Author: Maxwell Lloyd and Venus Dinari                             */
+/*--------------------------------------------------------------------*/
+
+#ifndef SLAB_INCLUDED
+#define SLAB_INCLUDED
+
+#include <stddef.h>
+
+/*
+  A slab hands out objects of one fixed size, carved from blocks that
+  each hold many of them, and keeps the objects freed back to it on a
+  free list for reuse. Allocating and freeing are a few pointer
+  operations, with no per-object header; a block is requested from
+  malloc only once every object carved so far is in use. Blocks are
+  never returned to the system, so a slab holds on to as much memory
+  as it ever had in use at once.
+
+  A module keeps one slab per object type, as a static struct Slab
+  initialized with SLAB_INITIALIZER. The fields belong to this module.
+
+  When slab.c is compiled with THREADSAFE defined, each slab is
+  guarded by a spin lock of its own, so any of these functions may be
+  called from any thread. The struct is the same in either build, so
+  modules that use a slab need not be compiled differently.
+
+  When slab.c is compiled with SLAB_MALLOC defined, every object comes
+  straight from malloc and goes back to free, for comparison.
+*/
+
+/* Every object is aligned to SLAB_ALIGN bytes, enough for any type */
+enum { SLAB_ALIGN = 16 };
+
+struct Slab {
+   /* the size of each object, a multiple of SLAB_ALIGN */
+   size_t ulSize;
+   /* the most recently freed object, which links to the next one */
+   void *pvFree;
+   /* the part of the newest block not yet carved into objects */
+   char *pcNext;
+   char *pcEnd;
+   /* nonzero while a thread holds the slab, in the THREADSAFE build */
+   int iLocked;
+};
+
+/* The initial value of a slab of objects of ulSize bytes each */
+#define SLAB_INITIALIZER(ulSize) \
+   { ((ulSize) + SLAB_ALIGN - 1) / SLAB_ALIGN * SLAB_ALIGN, \
+     NULL, NULL, NULL, 0 }
+
+/*
+  Returns an uninitialized object from psSlab, or NULL if a new block
+  was needed and could not be allocated.
+*/
+void *Slab_alloc(struct Slab *psSlab);
+
+/*
+  Returns pvObject, which must have come from Slab_alloc on psSlab, to
+  psSlab for reuse. Does nothing if pvObject is NULL.
+*/
+void Slab_free(struct Slab *psSlab, void *pvObject);
+
+#endif
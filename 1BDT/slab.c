@@ -0,0 +1 @@
+../0shared/slab.c
\ No newline at end of file
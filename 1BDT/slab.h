@@ -0,0 +1 @@
+../0shared/slab.h
\ No newline at end of file
@@ -0,0 +1,74 @@
+/*--------------------------------------------------------------------*/
+/* arena.h                                                            */
+/* Author: Maxwell Lloyd and Venus Dinari                             */
+/*--------------------------------------------------------------------*/
+
+#ifndef ARENA_INCLUDED
+#define ARENA_INCLUDED
+
+#include <stddef.h>
+
+/*
+  An arena is a region from which one data structure allocates all of
+  its memory, so that the whole structure can be released at once,
+  without visiting its parts. The region is a list of large blocks,
+  and objects are carved from the newest block in order. An object
+  freed back to the arena goes on a free list for its size class and
+  is reused by the next request of that class; its memory returns to
+  the system only when the arena is released.
+
+  An arena needs no allocation until its first object is requested,
+  so it may be embedded in the structure that uses it, initialized
+  with ARENA_INITIALIZER. The fields belong to this module.
+
+  When arena.c is compiled with THREADSAFE defined, each arena is
+  guarded by a spin lock of its own, so any of these functions but
+  Arena_release may be called from any thread. The struct is the same
+  in either build.
+*/
+
+/* Objects up to this size are grouped into classes ARENA_ALIGN bytes
+   apart; larger objects into classes a power of 2 apart */
+enum { ARENA_ALIGN = 16, ARENA_SMALL = 1024 };
+/* The number of size classes, enough for any size_t */
+enum { ARENA_CLASSES = ARENA_SMALL / ARENA_ALIGN + 8 * sizeof(size_t) };
+
+struct Arena {
+   /* the newest block, which links to the one before it */
+   void *pvBlocks;
+   /* the part of the newest block not yet carved into objects */
+   char *pcNext;
+   char *pcEnd;
+   /* the most recently freed object of each class, which links to the
+      next one */
+   void *apvFree[ARENA_CLASSES];
+   /* nonzero while a thread holds the arena, in the THREADSAFE build */
+   int iLocked;
+};
+
+/* The initial value of an empty arena */
+#define ARENA_INITIALIZER { NULL, NULL, NULL, { NULL }, 0 }
+
+/*
+  Returns an uninitialized object of ulSize bytes from psArena,
+  aligned to ARENA_ALIGN bytes, or NULL if a new block was needed and
+  could not be allocated.
+*/
+void *Arena_alloc(struct Arena *psArena, size_t ulSize);
+
+/*
+  Returns pvObject, which must have come from Arena_alloc on psArena
+  with size ulSize, to psArena for reuse. Does nothing if pvObject is
+  NULL.
+*/
+void Arena_free(struct Arena *psArena, void *pvObject, size_t ulSize);
+
+/*
+  Returns every block of psArena to the system, in time proportional
+  to the number of blocks, and leaves psArena empty. Every object
+  allocated from it is freed at once. Must not run concurrently with
+  another call on psArena.
+*/
+void Arena_release(struct Arena *psArena);
+
+#endif
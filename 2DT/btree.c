@@ -0,0 +1,839 @@
+/*--------------------------------------------------------------------*/
+/* btree.c                                                            */
+/* Author: Maxwell Lloyd and Venus Dinari                             */
+/*--------------------------------------------------------------------*/
+
+#include "btree.h"
+#include "arena.h"
+#include "slab.h"
+#include <assert.h>
+#include <stdlib.h>
+#include <string.h>
+
+/*--------------------------------------------------------------------*/
+
+/* The maximum number of entries in a node. */
+
+enum { MAX_ENTRIES = 32 };
+
+/* The minimum number of entries in a node other than the root. */
+
+enum { MIN_ENTRIES = MAX_ENTRIES / 2 };
+
+/* An upper bound on the number of levels in a BTree: every node but
+   the root has at least MIN_ENTRIES entries, so this many levels
+   could hold more elements than memory can address. */
+
+enum { MAX_LEVELS = 8 * sizeof(size_t) / 4 + 2 };
+
+/*--------------------------------------------------------------------*/
+
+/* A leaf holds a run of consecutive elements, and links to the leaf
+   holding the next run so that the elements can be walked in order. */
+
+struct BTreeLeaf
+{
+   /* The number of elements in the leaf. */
+   size_t uCount;
+
+   /* The next leaf in order, or NULL if this is the last. */
+   struct BTreeLeaf *psNext;
+
+   /* The elements themselves. */
+   const void *apvElements[MAX_ENTRIES];
+};
+
+/* An inner node holds the roots of consecutive subtrees, along with
+   the number of elements in each and the first element of each. The
+   counts locate an index, and the first elements guide a search,
+   without visiting the subtrees. */
+
+struct BTreeInner
+{
+   /* The number of subtrees. */
+   size_t uCount;
+
+   /* The number of elements in each subtree. */
+   size_t auSizes[MAX_ENTRIES];
+
+   /* The first element of each subtree. */
+   const void *apvFirsts[MAX_ENTRIES];
+
+   /* The root of each subtree: a struct BTreeInner if this node is
+      above level 1, and a struct BTreeLeaf otherwise. */
+   void *apvChildren[MAX_ENTRIES];
+};
+
+/* A BTree consists of its root, which is a leaf if uHeight is 0 and
+   an inner node otherwise, along with its height and length, and the
+   arena its memory comes from, if any. */
+
+struct BTree
+{
+   /* The number of elements in the BTree. */
+   size_t uLength;
+
+   /* The number of levels of inner nodes above the leaves. */
+   size_t uHeight;
+
+   /* The root node, which is never NULL. */
+   void *pvRoot;
+
+   /* The arena holding the BTree and its nodes, or NULL if they are
+      allocated from the slabs below. */
+   struct Arena *psArena;
+};
+
+/*--------------------------------------------------------------------*/
+
+/* Return the number of entries in pvNode, which is at level uLevel
+   (0 for a leaf). */
+
+static size_t BTree_count(void *pvNode, size_t uLevel)
+{
+   assert(pvNode != NULL);
+
+   if (uLevel == 0)
+      return ((struct BTreeLeaf*)pvNode)->uCount;
+   return ((struct BTreeInner*)pvNode)->uCount;
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Return the number of elements in the subtree rooted at pvNode,
+   which is at level uLevel. */
+
+static size_t BTree_size(void *pvNode, size_t uLevel)
+{
+   struct BTreeInner *psInner;
+   size_t uSize = 0;
+   size_t u;
+
+   assert(pvNode != NULL);
+
+   if (uLevel == 0)
+      return ((struct BTreeLeaf*)pvNode)->uCount;
+
+   psInner = pvNode;
+   for (u = 0; u < psInner->uCount; u++)
+      uSize += psInner->auSizes[u];
+   return uSize;
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Return the first element of the non-empty subtree rooted at
+   pvNode, which is at level uLevel. */
+
+static const void *BTree_first(void *pvNode, size_t uLevel)
+{
+   assert(pvNode != NULL);
+   assert(BTree_count(pvNode, uLevel) != 0);
+
+   if (uLevel == 0)
+      return ((struct BTreeLeaf*)pvNode)->apvElements[0];
+   return ((struct BTreeInner*)pvNode)->apvFirsts[0];
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Unless a BTree is given an arena, its header, leaves and inner
+   nodes are each allocated from a slab of their own, since every
+   BTree has a header and a root leaf. */
+
+static struct Slab sTreeSlab = SLAB_INITIALIZER(sizeof(struct BTree));
+static struct Slab sLeafSlab =
+   SLAB_INITIALIZER(sizeof(struct BTreeLeaf));
+static struct Slab sInnerSlab =
+   SLAB_INITIALIZER(sizeof(struct BTreeInner));
+
+/* Return a new, uninitialized node of oBTree at level uLevel, or
+   NULL if insufficient memory is available. */
+
+static void *BTree_allocNode(BTree_T oBTree, size_t uLevel)
+{
+   if (oBTree->psArena != NULL)
+      return Arena_alloc(oBTree->psArena,
+                         uLevel == 0 ? sizeof(struct BTreeLeaf)
+                                     : sizeof(struct BTreeInner));
+   return Slab_alloc(uLevel == 0 ? &sLeafSlab : &sInnerSlab);
+}
+
+/* Release pvNode, a node of oBTree at level uLevel, but not the
+   nodes below it. */
+
+static void BTree_releaseNode(BTree_T oBTree, void *pvNode,
+                              size_t uLevel)
+{
+   if (oBTree->psArena != NULL)
+      Arena_free(oBTree->psArena, pvNode,
+                 uLevel == 0 ? sizeof(struct BTreeLeaf)
+                             : sizeof(struct BTreeInner));
+   else
+      Slab_free(uLevel == 0 ? &sLeafSlab : &sInnerSlab, pvNode);
+}
+
+/*--------------------------------------------------------------------*/
+
+#ifndef NDEBUG
+
+/* Check the invariants of oBTree that can be checked without walking
+   it.  Return 1 (TRUE) iff oBTree is in a valid state. */
+
+static int BTree_isValid(BTree_T oBTree)
+{
+   if (oBTree->pvRoot == NULL) return 0;
+   if (oBTree->uHeight >= MAX_LEVELS) return 0;
+   if (BTree_size(oBTree->pvRoot, oBTree->uHeight) !=
+       oBTree->uLength) return 0;
+   if (oBTree->uHeight != 0 &&
+       BTree_count(oBTree->pvRoot, oBTree->uHeight) < 2) return 0;
+   return 1;
+}
+
+#endif
+
+/*--------------------------------------------------------------------*/
+
+/* Free the subtree of oBTree rooted at pvNode, which is at level
+   uLevel. */
+
+static void BTree_freeNode(BTree_T oBTree, void *pvNode, size_t uLevel)
+{
+   struct BTreeInner *psInner;
+   size_t u;
+
+   assert(pvNode != NULL);
+
+   if (uLevel != 0)
+   {
+      psInner = pvNode;
+      for (u = 0; u < psInner->uCount; u++)
+         BTree_freeNode(oBTree, psInner->apvChildren[u], uLevel - 1);
+   }
+   BTree_releaseNode(oBTree, pvNode, uLevel);
+}
+
+/*--------------------------------------------------------------------*/
+
+
+/* Insert the entry of uSize bytes at pvNew into the array of uCount
+   such entries at pvArray, which has room for one more, so that it
+   is the uPos'th entry. */
+
+static void BTree_insertEntry(void *pvArray, size_t uCount,
+                              size_t uPos, const void *pvNew,
+                              size_t uSize)
+{
+   char *pcArray = pvArray;
+
+   assert(pvArray != NULL);
+   assert(uPos <= uCount);
+
+   memmove(pcArray + (uPos + 1) * uSize, pcArray + uPos * uSize,
+           (uCount - uPos) * uSize);
+   memcpy(pcArray + uPos * uSize, pvNew, uSize);
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Remove the uPos'th entry from the array of uCount entries of uSize
+   bytes at pvArray. */
+
+static void BTree_removeEntry(void *pvArray, size_t uCount,
+                              size_t uPos, size_t uSize)
+{
+   char *pcArray = pvArray;
+
+   assert(pvArray != NULL);
+   assert(uPos < uCount);
+
+   memmove(pcArray + uPos * uSize, pcArray + (uPos + 1) * uSize,
+           (uCount - uPos - 1) * uSize);
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Insert pvElement into psLeaf so that it is the uPos'th element.  If
+   psLeaf is full, split it with psSpare, an unused leaf, which then
+   follows psLeaf and holds the upper half of the elements. */
+
+static void BTree_leafInsert(struct BTreeLeaf *psLeaf, size_t uPos,
+                             const void *pvElement,
+                             struct BTreeLeaf *psSpare)
+{
+   const void *apvAll[MAX_ENTRIES + 1];
+   size_t uLeft;
+
+   assert(psLeaf != NULL);
+
+   if (psLeaf->uCount < MAX_ENTRIES)
+   {
+      BTree_insertEntry(psLeaf->apvElements, psLeaf->uCount, uPos,
+                        &pvElement, sizeof(void*));
+      psLeaf->uCount++;
+      return;
+   }
+
+   assert(psSpare != NULL);
+
+   memcpy(apvAll, psLeaf->apvElements, sizeof(psLeaf->apvElements));
+   BTree_insertEntry(apvAll, MAX_ENTRIES, uPos, &pvElement,
+                     sizeof(void*));
+
+   uLeft = (MAX_ENTRIES + 1) / 2;
+   psLeaf->uCount = uLeft;
+   psSpare->uCount = MAX_ENTRIES + 1 - uLeft;
+   memcpy(psLeaf->apvElements, apvAll, uLeft * sizeof(void*));
+   memcpy(psSpare->apvElements, &apvAll[uLeft],
+          psSpare->uCount * sizeof(void*));
+
+   psSpare->psNext = psLeaf->psNext;
+   psLeaf->psNext = psSpare;
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Insert the subtree pvChild, at level uLevel - 1, into psInner, at
+   level uLevel, so that it is the uPos'th subtree.  If psInner is
+   full, split it with psSpare, an unused inner node, which then holds
+   the upper half of the subtrees. */
+
+static void BTree_innerInsert(struct BTreeInner *psInner, size_t uPos,
+                              void *pvChild, size_t uLevel,
+                              struct BTreeInner *psSpare)
+{
+   size_t auSizes[MAX_ENTRIES + 1];
+   const void *apvFirsts[MAX_ENTRIES + 1];
+   void *apvChildren[MAX_ENTRIES + 1];
+   size_t uSize;
+   const void *pvFirst;
+   size_t uLeft;
+
+   assert(psInner != NULL);
+   assert(pvChild != NULL);
+   assert(uLevel > 0);
+
+   uSize = BTree_size(pvChild, uLevel - 1);
+   pvFirst = BTree_first(pvChild, uLevel - 1);
+
+   if (psInner->uCount < MAX_ENTRIES)
+   {
+      BTree_insertEntry(psInner->auSizes, psInner->uCount, uPos,
+                        &uSize, sizeof(size_t));
+      BTree_insertEntry(psInner->apvFirsts, psInner->uCount, uPos,
+                        &pvFirst, sizeof(void*));
+      BTree_insertEntry(psInner->apvChildren, psInner->uCount, uPos,
+                        &pvChild, sizeof(void*));
+      psInner->uCount++;
+      return;
+   }
+
+   assert(psSpare != NULL);
+
+   memcpy(auSizes, psInner->auSizes, sizeof(psInner->auSizes));
+   memcpy(apvFirsts, psInner->apvFirsts, sizeof(psInner->apvFirsts));
+   memcpy(apvChildren, psInner->apvChildren,
+          sizeof(psInner->apvChildren));
+   BTree_insertEntry(auSizes, MAX_ENTRIES, uPos, &uSize,
+                     sizeof(size_t));
+   BTree_insertEntry(apvFirsts, MAX_ENTRIES, uPos, &pvFirst,
+                     sizeof(void*));
+   BTree_insertEntry(apvChildren, MAX_ENTRIES, uPos, &pvChild,
+                     sizeof(void*));
+
+   uLeft = (MAX_ENTRIES + 1) / 2;
+   psInner->uCount = uLeft;
+   psSpare->uCount = MAX_ENTRIES + 1 - uLeft;
+   memcpy(psInner->auSizes, auSizes, uLeft * sizeof(size_t));
+   memcpy(psInner->apvFirsts, apvFirsts, uLeft * sizeof(void*));
+   memcpy(psInner->apvChildren, apvChildren, uLeft * sizeof(void*));
+   memcpy(psSpare->auSizes, &auSizes[uLeft],
+          psSpare->uCount * sizeof(size_t));
+   memcpy(psSpare->apvFirsts, &apvFirsts[uLeft],
+          psSpare->uCount * sizeof(void*));
+   memcpy(psSpare->apvChildren, &apvChildren[uLeft],
+          psSpare->uCount * sizeof(void*));
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Move elements between the adjacent leaves psLeft and psRight so
+   that both are at least half full, or, if they fit in one leaf, move
+   them all into psLeft.  Return 1 (TRUE) if psRight was emptied and
+   unlinked, or 0 (FALSE) otherwise. */
+
+static int BTree_leafShare(struct BTreeLeaf *psLeft,
+                           struct BTreeLeaf *psRight)
+{
+   const void *apvAll[2 * MAX_ENTRIES];
+   size_t uTotal;
+
+   assert(psLeft != NULL);
+   assert(psRight != NULL);
+
+   uTotal = psLeft->uCount + psRight->uCount;
+   memcpy(apvAll, psLeft->apvElements, psLeft->uCount * sizeof(void*));
+   memcpy(&apvAll[psLeft->uCount], psRight->apvElements,
+          psRight->uCount * sizeof(void*));
+
+   if (uTotal <= MAX_ENTRIES)
+   {
+      memcpy(psLeft->apvElements, apvAll, uTotal * sizeof(void*));
+      psLeft->uCount = uTotal;
+      psRight->uCount = 0;
+      psLeft->psNext = psRight->psNext;
+      return 1;
+   }
+
+   psLeft->uCount = uTotal / 2;
+   psRight->uCount = uTotal - psLeft->uCount;
+   memcpy(psLeft->apvElements, apvAll, psLeft->uCount * sizeof(void*));
+   memcpy(psRight->apvElements, &apvAll[psLeft->uCount],
+          psRight->uCount * sizeof(void*));
+   return 0;
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Move subtrees between the adjacent inner nodes psLeft and psRight
+   so that both are at least half full, or, if they fit in one node,
+   move them all into psLeft.  Return 1 (TRUE) if psRight was emptied,
+   or 0 (FALSE) otherwise. */
+
+static int BTree_innerShare(struct BTreeInner *psLeft,
+                            struct BTreeInner *psRight)
+{
+   size_t auSizes[2 * MAX_ENTRIES];
+   const void *apvFirsts[2 * MAX_ENTRIES];
+   void *apvChildren[2 * MAX_ENTRIES];
+   size_t uTotal;
+   size_t uLeft;
+
+   assert(psLeft != NULL);
+   assert(psRight != NULL);
+
+   uTotal = psLeft->uCount + psRight->uCount;
+   uLeft = psLeft->uCount;
+   memcpy(auSizes, psLeft->auSizes, uLeft * sizeof(size_t));
+   memcpy(apvFirsts, psLeft->apvFirsts, uLeft * sizeof(void*));
+   memcpy(apvChildren, psLeft->apvChildren, uLeft * sizeof(void*));
+   memcpy(&auSizes[uLeft], psRight->auSizes,
+          psRight->uCount * sizeof(size_t));
+   memcpy(&apvFirsts[uLeft], psRight->apvFirsts,
+          psRight->uCount * sizeof(void*));
+   memcpy(&apvChildren[uLeft], psRight->apvChildren,
+          psRight->uCount * sizeof(void*));
+
+   uLeft = uTotal <= MAX_ENTRIES ? uTotal : uTotal / 2;
+   psLeft->uCount = uLeft;
+   psRight->uCount = uTotal - uLeft;
+   memcpy(psLeft->auSizes, auSizes, uLeft * sizeof(size_t));
+   memcpy(psLeft->apvFirsts, apvFirsts, uLeft * sizeof(void*));
+   memcpy(psLeft->apvChildren, apvChildren, uLeft * sizeof(void*));
+   memcpy(psRight->auSizes, &auSizes[uLeft],
+          psRight->uCount * sizeof(size_t));
+   memcpy(psRight->apvFirsts, &apvFirsts[uLeft],
+          psRight->uCount * sizeof(void*));
+   memcpy(psRight->apvChildren, &apvChildren[uLeft],
+          psRight->uCount * sizeof(void*));
+   return psRight->uCount == 0;
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Restore the fill of the uPos'th subtree of psParent, a node of
+   oBTree, whose root is at level uLevel and has fallen below
+   MIN_ENTRIES entries, by sharing with or merging into a neighbouring
+   subtree. */
+
+static void BTree_rebalance(BTree_T oBTree, struct BTreeInner *psParent,
+                            size_t uPos, size_t uLevel)
+{
+   size_t uLeft;
+   size_t uRight;
+   void *pvLeft;
+   void *pvRight;
+   int iMerged;
+
+   assert(psParent != NULL);
+   assert(psParent->uCount >= 2);
+
+   uLeft = uPos > 0 ? uPos - 1 : uPos;
+   uRight = uLeft + 1;
+   pvLeft = psParent->apvChildren[uLeft];
+   pvRight = psParent->apvChildren[uRight];
+
+   if (uLevel == 0)
+      iMerged = BTree_leafShare(pvLeft, pvRight);
+   else
+      iMerged = BTree_innerShare(pvLeft, pvRight);
+
+   if (iMerged)
+   {
+      BTree_releaseNode(oBTree, pvRight, uLevel);
+      BTree_removeEntry(psParent->auSizes, psParent->uCount, uRight,
+                        sizeof(size_t));
+      BTree_removeEntry(psParent->apvFirsts, psParent->uCount, uRight,
+                        sizeof(void*));
+      BTree_removeEntry(psParent->apvChildren, psParent->uCount, uRight,
+                        sizeof(void*));
+      psParent->uCount--;
+   }
+   else
+   {
+      psParent->auSizes[uRight] = BTree_size(pvRight, uLevel);
+      psParent->apvFirsts[uRight] = BTree_first(pvRight, uLevel);
+   }
+   psParent->auSizes[uLeft] = BTree_size(pvLeft, uLevel);
+   psParent->apvFirsts[uLeft] = BTree_first(pvLeft, uLevel);
+}
+
+/*--------------------------------------------------------------------*/
+
+BTree_T BTree_new(void)
+{
+   return BTree_newIn(NULL);
+}
+
+/*--------------------------------------------------------------------*/
+
+BTree_T BTree_newIn(struct Arena *psArena)
+{
+   BTree_T oBTree;
+   struct BTreeLeaf *psRoot;
+
+   if (psArena != NULL)
+      oBTree = (BTree_T)Arena_alloc(psArena, sizeof(struct BTree));
+   else
+      oBTree = (BTree_T)Slab_alloc(&sTreeSlab);
+   if (oBTree == NULL)
+      return NULL;
+   oBTree->psArena = psArena;
+
+   psRoot = (struct BTreeLeaf*)BTree_allocNode(oBTree, 0);
+   if (psRoot == NULL)
+   {
+      if (psArena != NULL)
+         Arena_free(psArena, oBTree, sizeof(struct BTree));
+      else
+         Slab_free(&sTreeSlab, oBTree);
+      return NULL;
+   }
+   psRoot->uCount = 0;
+   psRoot->psNext = NULL;
+
+   oBTree->uLength = 0;
+   oBTree->uHeight = 0;
+   oBTree->pvRoot = psRoot;
+
+   assert(BTree_isValid(oBTree));
+
+   return oBTree;
+}
+
+/*--------------------------------------------------------------------*/
+
+void BTree_free(BTree_T oBTree)
+{
+   assert(oBTree != NULL);
+   assert(BTree_isValid(oBTree));
+
+   BTree_freeNode(oBTree, oBTree->pvRoot, oBTree->uHeight);
+   if (oBTree->psArena != NULL)
+      Arena_free(oBTree->psArena, oBTree, sizeof(struct BTree));
+   else
+      Slab_free(&sTreeSlab, oBTree);
+}
+
+/*--------------------------------------------------------------------*/
+
+size_t BTree_getLength(BTree_T oBTree)
+{
+   assert(oBTree != NULL);
+
+   return oBTree->uLength;
+}
+
+/*--------------------------------------------------------------------*/
+
+void *BTree_get(BTree_T oBTree, size_t uIndex)
+{
+   struct BTreeInner *psInner;
+   void *pvNode;
+   size_t uLevel;
+   size_t u;
+
+   assert(oBTree != NULL);
+   assert(uIndex < oBTree->uLength);
+
+   pvNode = oBTree->pvRoot;
+   for (uLevel = oBTree->uHeight; uLevel > 0; uLevel--)
+   {
+      psInner = pvNode;
+      for (u = 0; uIndex >= psInner->auSizes[u]; u++)
+         uIndex -= psInner->auSizes[u];
+      pvNode = psInner->apvChildren[u];
+   }
+
+   return (void*)((struct BTreeLeaf*)pvNode)->apvElements[uIndex];
+}
+
+/*--------------------------------------------------------------------*/
+
+int BTree_add(BTree_T oBTree, const void *pvElement)
+{
+   assert(oBTree != NULL);
+
+   return BTree_addAt(oBTree, oBTree->uLength, pvElement);
+}
+
+/*--------------------------------------------------------------------*/
+
+int BTree_addAt(BTree_T oBTree, size_t uIndex, const void *pvElement)
+{
+   void *apvPath[MAX_LEVELS];
+   size_t auSlots[MAX_LEVELS];
+   void *apvSpares[MAX_LEVELS + 1];
+   struct BTreeInner *psInner;
+   void *pvCarry;
+   size_t uHeight;
+   size_t uSplits;
+   size_t uSpares;
+   size_t uLevel;
+   size_t u;
+
+   assert(oBTree != NULL);
+   assert(uIndex <= oBTree->uLength);
+   assert(BTree_isValid(oBTree));
+
+   /* find the leaf the element goes in, remembering the way down */
+   uHeight = oBTree->uHeight;
+   apvPath[uHeight] = oBTree->pvRoot;
+   for (uLevel = uHeight; uLevel > 0; uLevel--)
+   {
+      psInner = apvPath[uLevel];
+      for (u = 0; u < psInner->uCount - 1 &&
+              uIndex > psInner->auSizes[u]; u++)
+         uIndex -= psInner->auSizes[u];
+      auSlots[uLevel] = u;
+      apvPath[uLevel - 1] = psInner->apvChildren[u];
+   }
+
+   /* the full nodes from the leaf up will split; allocate their new
+      siblings, and a new root if the root splits, before changing
+      anything so that running out of memory leaves oBTree intact */
+   for (uSplits = 0; uSplits <= uHeight &&
+           BTree_count(apvPath[uSplits], uSplits) == MAX_ENTRIES;
+        uSplits++)
+      ;
+   uSpares = uSplits > uHeight ? uSplits + 1 : uSplits;
+   for (u = 0; u < uSpares; u++)
+   {
+      apvSpares[u] = BTree_allocNode(oBTree, u);
+      if (apvSpares[u] == NULL)
+      {
+         while (u > 0)
+         {
+            u--;
+            BTree_releaseNode(oBTree, apvSpares[u], u);
+         }
+         return 0;
+      }
+   }
+
+   /* insert into the leaf, then update each inner node on the way
+      back up, adding the sibling split off below it if there is one */
+   BTree_leafInsert(apvPath[0], uIndex, pvElement,
+                    uSplits > 0 ? apvSpares[0] : NULL);
+   pvCarry = uSplits > 0 ? apvSpares[0] : NULL;
+   for (uLevel = 1; uLevel <= uHeight; uLevel++)
+   {
+      psInner = apvPath[uLevel];
+      u = auSlots[uLevel];
+      psInner->auSizes[u] = BTree_size(apvPath[uLevel - 1], uLevel - 1);
+      psInner->apvFirsts[u] = BTree_first(apvPath[uLevel - 1],
+                                          uLevel - 1);
+      if (pvCarry != NULL)
+      {
+         BTree_innerInsert(psInner, u + 1, pvCarry, uLevel,
+                           uLevel < uSplits ? apvSpares[uLevel] : NULL);
+         pvCarry = uLevel < uSplits ? apvSpares[uLevel] : NULL;
+      }
+   }
+
+   /* the root split, so grow a new root above the two halves */
+   if (pvCarry != NULL)
+   {
+      psInner = apvSpares[uSplits];
+      psInner->uCount = 0;
+      BTree_innerInsert(psInner, 0, oBTree->pvRoot, uHeight + 1, NULL);
+      BTree_innerInsert(psInner, 1, pvCarry, uHeight + 1, NULL);
+      oBTree->pvRoot = psInner;
+      oBTree->uHeight++;
+   }
+
+   oBTree->uLength++;
+
+   assert(BTree_isValid(oBTree));
+
+   return 1;
+}
+
+/*--------------------------------------------------------------------*/
+
+void *BTree_removeAt(BTree_T oBTree, size_t uIndex)
+{
+   void *apvPath[MAX_LEVELS];
+   size_t auSlots[MAX_LEVELS];
+   struct BTreeLeaf *psLeaf;
+   struct BTreeInner *psInner;
+   const void *pvOldElement;
+   size_t uHeight;
+   size_t uLevel;
+   size_t u;
+
+   assert(oBTree != NULL);
+   assert(uIndex < oBTree->uLength);
+   assert(BTree_isValid(oBTree));
+
+   /* find the leaf holding the element, remembering the way down */
+   uHeight = oBTree->uHeight;
+   apvPath[uHeight] = oBTree->pvRoot;
+   for (uLevel = uHeight; uLevel > 0; uLevel--)
+   {
+      psInner = apvPath[uLevel];
+      for (u = 0; uIndex >= psInner->auSizes[u]; u++)
+         uIndex -= psInner->auSizes[u];
+      auSlots[uLevel] = u;
+      apvPath[uLevel - 1] = psInner->apvChildren[u];
+   }
+
+   psLeaf = apvPath[0];
+   pvOldElement = psLeaf->apvElements[uIndex];
+   BTree_removeEntry(psLeaf->apvElements, psLeaf->uCount, uIndex,
+                     sizeof(void*));
+   psLeaf->uCount--;
+
+   /* update each inner node on the way back up, refilling any child
+      left less than half full */
+   for (uLevel = 1; uLevel <= uHeight; uLevel++)
+   {
+      psInner = apvPath[uLevel];
+      u = auSlots[uLevel];
+      psInner->auSizes[u]--;
+      if (BTree_count(apvPath[uLevel - 1], uLevel - 1) < MIN_ENTRIES)
+         BTree_rebalance(oBTree, psInner, u, uLevel - 1);
+      else
+         psInner->apvFirsts[u] = BTree_first(apvPath[uLevel - 1],
+                                             uLevel - 1);
+   }
+
+   /* a root with a single subtree is replaced by that subtree */
+   if (uHeight > 0 &&
+       ((struct BTreeInner*)oBTree->pvRoot)->uCount == 1)
+   {
+      psInner = oBTree->pvRoot;
+      oBTree->pvRoot = psInner->apvChildren[0];
+      oBTree->uHeight--;
+      BTree_releaseNode(oBTree, psInner, uHeight);
+   }
+
+   oBTree->uLength--;
+
+   assert(BTree_isValid(oBTree));
+
+   return (void*)pvOldElement;
+}
+
+/*--------------------------------------------------------------------*/
+
+void BTree_map(BTree_T oBTree,
+               void (*pfApply)(void *pvElement, void *pvExtra),
+               const void *pvExtra)
+{
+   struct BTreeLeaf *psLeaf;
+   void *pvNode;
+   size_t uLevel;
+   size_t u;
+
+   assert(oBTree != NULL);
+   assert(pfApply != NULL);
+
+   /* walk the linked leaves from the leftmost */
+   pvNode = oBTree->pvRoot;
+   for (uLevel = oBTree->uHeight; uLevel > 0; uLevel--)
+      pvNode = ((struct BTreeInner*)pvNode)->apvChildren[0];
+
+   for (psLeaf = pvNode; psLeaf != NULL; psLeaf = psLeaf->psNext)
+      for (u = 0; u < psLeaf->uCount; u++)
+         (*pfApply)((void*)psLeaf->apvElements[u], (void*)pvExtra);
+}
+
+/*--------------------------------------------------------------------*/
+
+int BTree_bsearch(BTree_T oBTree,
+                  void *pvSoughtElement,
+                  size_t *puIndex,
+                  int (*pfCompare)(const void *pvElement1,
+                                   const void *pvElement2))
+{
+   struct BTreeInner *psInner;
+   struct BTreeLeaf *psLeaf;
+   void *pvNode;
+   size_t uBase = 0;
+   size_t uLevel;
+   size_t uLo;
+   size_t uHi;
+   size_t uMid;
+   size_t u;
+   int iCompare;
+
+   assert(oBTree != NULL);
+   assert(puIndex != NULL);
+   assert(pfCompare != NULL);
+   assert(BTree_isValid(oBTree));
+
+   /* at each inner node, descend into the last subtree whose first
+      element is not greater than the sought one */
+   pvNode = oBTree->pvRoot;
+   for (uLevel = oBTree->uHeight; uLevel > 0; uLevel--)
+   {
+      psInner = pvNode;
+      uLo = 1;
+      uHi = psInner->uCount;
+      while (uLo < uHi)
+      {
+         uMid = uLo + (uHi - uLo) / 2;
+         if ((*pfCompare)(psInner->apvFirsts[uMid], pvSoughtElement) > 0)
+            uHi = uMid;
+         else
+            uLo = uMid + 1;
+      }
+      for (u = 0; u < uLo - 1; u++)
+         uBase += psInner->auSizes[u];
+      pvNode = psInner->apvChildren[uLo - 1];
+   }
+
+   psLeaf = pvNode;
+   uLo = 0;
+   uHi = psLeaf->uCount;
+   while (uLo < uHi)
+   {
+      uMid = uLo + (uHi - uLo) / 2;
+      iCompare = (*pfCompare)(psLeaf->apvElements[uMid],
+                              pvSoughtElement);
+      if (iCompare == 0)
+      {
+         *puIndex = uBase + uMid;
+         return 1;
+      }
+      if (iCompare < 0)
+         uLo = uMid + 1;
+      else
+         uHi = uMid;
+   }
+
+   *puIndex = uBase + uLo;
+   return 0;
+}
@@ -0,0 +1,104 @@
+/*--------------------------------------------------------------------*/
+/* btree.h                                                            */
+/* Author: Maxwell Lloyd and Venus Dinari                             */
+/*--------------------------------------------------------------------*/
+
+#ifndef BTREE_INCLUDED
+#define BTREE_INCLUDED
+
+#include <stddef.h>
+
+/* A BTree_T object is a sequence of elements addressed by index, like
+   a DynArray_T, stored in a B+ tree whose inner nodes count the
+   elements beneath them. Getting, adding, or removing the element at
+   any index takes O(log n) time, so a large sorted sequence can be
+   built or drained in O(n log n) time rather than O(n^2). */
+
+typedef struct BTree *BTree_T;
+
+struct Arena;
+
+/*--------------------------------------------------------------------*/
+
+/* Return a new, empty BTree_T object, or NULL if insufficient memory
+   is available. */
+
+BTree_T BTree_new(void);
+
+/*--------------------------------------------------------------------*/
+
+/* Return a new, empty BTree_T object whose memory, and that of the
+   nodes it grows, comes from psArena (see arena.h), or NULL if
+   insufficient memory is available. Releasing psArena frees the
+   BTree_T without BTree_free. If psArena is NULL, behave as
+   BTree_new. */
+
+BTree_T BTree_newIn(struct Arena *psArena);
+
+/*--------------------------------------------------------------------*/
+
+/* Free oBTree. */
+
+void BTree_free(BTree_T oBTree);
+
+/*--------------------------------------------------------------------*/
+
+/* Return the length of oBTree. */
+
+size_t BTree_getLength(BTree_T oBTree);
+
+/*--------------------------------------------------------------------*/
+
+/* Return the uIndex'th element of oBTree. */
+
+void *BTree_get(BTree_T oBTree, size_t uIndex);
+
+/*--------------------------------------------------------------------*/
+
+/* Add pvElement to the end of oBTree, thus incrementing its length.
+   Return 1 (TRUE) if successful, or 0 (FALSE) if insufficient memory
+   is available. */
+
+int BTree_add(BTree_T oBTree, const void *pvElement);
+
+/*--------------------------------------------------------------------*/
+
+/* Add pvElement to oBTree such that it is the uIndex'th element.
+   Return 1 (TRUE) if successful, or 0 (FALSE) if insufficient memory
+   is available, in which case oBTree is unchanged. */
+
+int BTree_addAt(BTree_T oBTree, size_t uIndex, const void *pvElement);
+
+/*--------------------------------------------------------------------*/
+
+/* Remove and return the uIndex'th element of oBTree. */
+
+void *BTree_removeAt(BTree_T oBTree, size_t uIndex);
+
+/*--------------------------------------------------------------------*/
+
+/* Apply function *pfApply to each element of oBTree in order, passing
+   pvExtra as an extra argument.  That is, for each element pvElement
+   of oBTree, call (*pfApply)(pvElement, pvExtra). */
+
+void BTree_map(BTree_T oBTree,
+               void (*pfApply)(void *pvElement, void *pvExtra),
+               const void *pvExtra);
+
+/*--------------------------------------------------------------------*/
+
+/* Binary search oBTree for *pvSoughtElement using *pfCompare to
+   determine equality.  If the element is found, then assign its
+   index to *puIndex and return 1.  If the element is not found, then
+   assign the index where it would belong to *puIndex and return 0.
+   *pfCompare must return <0, 0, or >0 if *pvElement1 is less than,
+   equal to, or greater than *pvElement2.
+   oBTree must be sorted as determined by *pfCompare. */
+
+int BTree_bsearch(BTree_T oBTree,
+                  void *pvSoughtElement,
+                  size_t *puIndex,
+                  int (*pfCompare)(const void *pvElement1,
+                                   const void *pvElement2));
+
+#endif
@@ -9,6 +9,7 @@
 #include <stdio.h>
 #include <stdlib.h>
 
+#include "atom.h"
 #include "dynarray.h"
 #include "path.h"
 #include "nodeDT.h"
@@ -40,23 +41,30 @@ static size_t ulCount;
 
 /*
   Traverses the DT starting at the root as far as possible towards
-  absolute path oPPath. If able to traverse, returns an int SUCCESS
-  status and sets *poNFurthest to the furthest node reached (which may
-  be only a prefix of oPPath, or even NULL if the root is NULL).
+  the absolute path described by psView. If able to traverse, returns
+  an int SUCCESS status and sets *poNFurthest to the furthest node
+  reached (which may be only a prefix of the path, or even NULL if the
+  root is NULL).
   Otherwise, sets *poNFurthest to NULL and returns with status:
-  * CONFLICTING_PATH if the root's path is not a prefix of oPPath
-  * MEMORY_ERROR if memory could not be allocated to complete request
+  * CONFLICTING_PATH if the root's path is not a prefix of the path
+  Does not allocate memory.
+
+  Each component is looked up in the atom table; a component with no
+  atom cannot name any node, so the traversal stops there. Otherwise
+  children are matched by their final component alone.
 */
-static int DT_traversePath(Path_T oPPath, Node_T *poNFurthest) {
+static int DT_traversePath(const struct PathView *psView,
+                           Node_T *poNFurthest) {
    int iStatus;
-   Path_T oPPrefix = NULL;
+   const char *pcComponent;
+   const char *pcName;
    Node_T oNCurr;
    Node_T oNChild = NULL;
-   size_t ulDepth;
-   size_t i;
+   size_t ulOffset = 0;
+   size_t ulLength;
    size_t ulChildID;
 
-   assert(oPPath != NULL);
+   assert(psView != NULL);
    assert(poNFurthest != NULL);
 
    /* root is NULL -> won't find anything */
@@ -65,32 +73,22 @@ static int DT_traversePath(Path_T oPPath, Node_T *poNFurthest) {
       return SUCCESS;
    }
 
-   iStatus = Path_prefix(oPPath, 1, &oPPrefix);
-   if(iStatus != SUCCESS) {
-      *poNFurthest = NULL;
-      return iStatus;
-   }
-
-   if(Path_comparePath(Node_getPath(oNRoot), oPPrefix)) {
-      Path_free(oPPrefix);
+   /* the root's path is a single component, so it must match the
+      first component of the path exactly */
+   pcComponent = PathView_nextComponent(psView, &ulOffset, &ulLength);
+   if(Path_getComponent(Node_getPath(oNRoot), 0) !=
+      Atom_find(pcComponent, ulLength)) {
       *poNFurthest = NULL;
       return CONFLICTING_PATH;
    }
-   Path_free(oPPrefix);
-   oPPrefix = NULL;
 
    oNCurr = oNRoot;
-   ulDepth = Path_getDepth(oPPath);
-   for(i = 2; i <= ulDepth; i++) {
-      iStatus = Path_prefix(oPPath, i, &oPPrefix);
-      if(iStatus != SUCCESS) {
-         *poNFurthest = NULL;
-         return iStatus;
-      }
-      if(Node_hasChild(oNCurr, oPPrefix, &ulChildID)) {
-         /* go to that child and continue with next prefix */
-         Path_free(oPPrefix);
-         oPPrefix = NULL;
+   while((pcComponent = PathView_nextComponent(psView, &ulOffset,
+                                               &ulLength)) != NULL) {
+      pcName = Atom_find(pcComponent, ulLength);
+      if(pcName != NULL &&
+         Node_hasChildName(oNCurr, pcName, &ulChildID)) {
+         /* go to that child and continue with next component */
          iStatus = Node_getChild(oNCurr, ulChildID, &oNChild);
          if(iStatus != SUCCESS) {
             *poNFurthest = NULL;
@@ -99,67 +97,52 @@ static int DT_traversePath(Path_T oPPath, Node_T *poNFurthest) {
          oNCurr = oNChild;
       }
       else {
-         /* oNCurr doesn't have child with path oPPrefix:
+         /* oNCurr doesn't have child with this name:
             this is as far as we can go */
          break;
       }
    }
 
-   Path_free(oPPrefix);
    *poNFurthest = oNCurr;
    return SUCCESS;
 }
 
 /*
-  Traverses the DT to find a node with absolute path pcPath. Returns a
-  int SUCCESS status and sets *poNResult to be the node, if found.
+  Traverses the DT to find a node with the absolute path described by
+  psView. The DT must be in an initialized state. Returns an int
+  SUCCESS status and sets *poNResult to be the node, if found.
   Otherwise, sets *poNResult to NULL and returns with status:
-  * INITIALIZATION_ERROR if the DT is not in an initialized state
-  * BAD_PATH if pcPath does not represent a well-formatted path
-  * CONFLICTING_PATH if the root's path is not a prefix of pcPath
-  * NO_SUCH_PATH if no node with pcPath exists in the hierarchy
-  * MEMORY_ERROR if memory could not be allocated to complete request
+  * CONFLICTING_PATH if the root's path is not a prefix of the path
+  * NO_SUCH_PATH if no node with the path exists in the hierarchy
+  Does not allocate memory.
  */
-static int DT_findNode(const char *pcPath, Node_T *poNResult) {
-   Path_T oPPath = NULL;
+static int DT_findNode(const struct PathView *psView,
+                       Node_T *poNResult) {
    Node_T oNFound = NULL;
    int iStatus;
 
-   assert(pcPath != NULL);
+   assert(psView != NULL);
    assert(poNResult != NULL);
+   assert(bIsInitialized);
 
-   if(!bIsInitialized) {
-      *poNResult = NULL;
-      return INITIALIZATION_ERROR;
-   }
-
-   iStatus = Path_new(pcPath, &oPPath);
+   iStatus = DT_traversePath(psView, &oNFound);
    if(iStatus != SUCCESS) {
       *poNResult = NULL;
       return iStatus;
    }
 
-   iStatus = DT_traversePath(oPPath, &oNFound);
-   if(iStatus != SUCCESS)
-   {
-      Path_free(oPPath);
-      *poNResult = NULL;
-      return iStatus;
-   }
-
    if(oNFound == NULL) {
-      Path_free(oPPath);
       *poNResult = NULL;
       return NO_SUCH_PATH;
    }
 
-   if(Path_comparePath(Node_getPath(oNFound), oPPath) != 0) {
-      Path_free(oPPath);
+   /* every level matched, so only a shallower node can differ */
+   if(Path_getDepth(Node_getPath(oNFound)) !=
+      PathView_getDepth(psView)) {
       *poNResult = NULL;
       return NO_SUCH_PATH;
    }
 
-   Path_free(oPPath);
    *poNResult = oNFound;
    return SUCCESS;
 }
@@ -168,6 +151,7 @@ static int DT_findNode(const char *pcPath, Node_T *poNResult) {
 
 int DT_insert(const char *pcPath) {
    int iStatus;
+   struct PathView sView;
    Path_T oPPath = NULL;
    Node_T oNFirstNew = NULL;
    Node_T oNCurr = NULL;
@@ -177,43 +161,40 @@ int DT_insert(const char *pcPath) {
    assert(pcPath != NULL);
    assert(CheckerDT_isValid(bIsInitialized, oNRoot, ulCount));
 
-   /* validate pcPath and generate a Path_T for it */
+   /* validate pcPath without allocating */
    if(!bIsInitialized)
       return INITIALIZATION_ERROR;
 
-   iStatus = Path_new(pcPath, &oPPath);
+   iStatus = PathView_init(&sView, pcPath);
    if(iStatus != SUCCESS)
       return iStatus;
 
-   /* find the closest ancestor of oPPath already in the tree */
-   iStatus= DT_traversePath(oPPath, &oNCurr);
+   /* find the closest ancestor of pcPath already in the tree */
+   iStatus= DT_traversePath(&sView, &oNCurr);
    if(iStatus != SUCCESS)
-   {
-      Path_free(oPPath);
       return iStatus;
-   }
 
    /* no ancestor node found, so if root is not NULL,
       pcPath isn't underneath root. */
-   if(oNCurr == NULL && oNRoot != NULL) {
-      Path_free(oPPath);
+   if(oNCurr == NULL && oNRoot != NULL)
       return CONFLICTING_PATH;
-   }
 
-   ulDepth = Path_getDepth(oPPath);
+   ulDepth = PathView_getDepth(&sView);
    if(oNCurr == NULL) /* new root! */
       ulIndex = 1;
    else {
       ulIndex = Path_getDepth(Node_getPath(oNCurr))+1;
 
       /* oNCurr is the node we're trying to insert */
-      if(ulIndex == ulDepth+1 && !Path_comparePath(oPPath,
-                                       Node_getPath(oNCurr))) {
-         Path_free(oPPath);
+      if(ulIndex == ulDepth+1)
          return ALREADY_IN_TREE;
-      }
    }
 
+   /* only now that nodes will be added, generate a Path_T for pcPath */
+   iStatus = Path_new(pcPath, &oPPath);
+   if(iStatus != SUCCESS)
+      return iStatus;
+
    /* starting at oNCurr, build rest of the path one level at a time */
    while(ulIndex <= ulDepth) {
       Path_T oPPrefix = NULL;
@@ -261,23 +242,38 @@ int DT_insert(const char *pcPath) {
 
 boolean DT_contains(const char *pcPath) {
    int iStatus;
+   struct PathView sView;
    Node_T oNFound = NULL;
 
    assert(pcPath != NULL);
 
-   iStatus = DT_findNode(pcPath, &oNFound);
+   if(!bIsInitialized)
+      return FALSE;
+
+   if(PathView_init(&sView, pcPath) != SUCCESS)
+      return FALSE;
+
+   iStatus = DT_findNode(&sView, &oNFound);
    return (boolean) (iStatus == SUCCESS);
 }
 
 
 int DT_rm(const char *pcPath) {
    int iStatus;
+   struct PathView sView;
    Node_T oNFound = NULL;
 
    assert(pcPath != NULL);
    assert(CheckerDT_isValid(bIsInitialized, oNRoot, ulCount));
 
-   iStatus = DT_findNode(pcPath, &oNFound);
+   if(!bIsInitialized)
+      return INITIALIZATION_ERROR;
+
+   iStatus = PathView_init(&sView, pcPath);
+   if(iStatus != SUCCESS)
+      return iStatus;
+
+   iStatus = DT_findNode(&sView, &oNFound);
 
    if(iStatus != SUCCESS)
        return iStatus;
@@ -365,16 +361,22 @@ static void DT_strlenAccumulate(Node_T oNNode, size_t *pulAcc) {
 }
 
 /*
-  Alternate version of strcat that inverts the typical argument
-  order, appending oNNode's path onto pcAcc, and also always adds one
-  newline at the end of the concatenated string.
+  Writes oNNode's path followed by a newline at *ppcCursor, and
+  advances *ppcCursor past them. Keeping the write position in the
+  cursor, rather than finding the end of the accumulated string again
+  with strcat, makes building the whole string linear in its length.
 */
-static void DT_strcatAccumulate(Node_T oNNode, char *pcAcc) {
-   assert(pcAcc != NULL);
+static void DT_writeAccumulate(Node_T oNNode, char **ppcCursor) {
+   size_t ulLength;
+
+   assert(ppcCursor != NULL);
 
    if(oNNode != NULL) {
-      strcat(pcAcc, Path_getPathname(Node_getPath(oNNode)));
-      strcat(pcAcc, "\n");
+      ulLength = Path_getStrLength(Node_getPath(oNNode));
+      memcpy(*ppcCursor, Path_getPathname(Node_getPath(oNNode)),
+             ulLength);
+      *ppcCursor += ulLength;
+      *(*ppcCursor)++ = '\n';
    }
 }
 /*--------------------------------------------------------------------*/
@@ -383,11 +385,14 @@ char *DT_toString(void) {
    DynArray_T nodes;
    size_t totalStrlen = 1;
    char *result = NULL;
+   char *pcCursor;
 
    if(!bIsInitialized)
       return NULL;
 
    nodes = DynArray_new(ulCount);
+   if(nodes == NULL)
+      return NULL;
    (void) DT_preOrderTraversal(oNRoot, nodes, 0);
 
    DynArray_map(nodes, (void (*)(void *, void*)) DT_strlenAccumulate,
@@ -398,10 +403,10 @@ char *DT_toString(void) {
       DynArray_free(nodes);
       return NULL;
    }
-   *result = '\0';
-
-   DynArray_map(nodes, (void (*)(void *, void*)) DT_strcatAccumulate,
-                (void *) result);
+   pcCursor = result;
+   DynArray_map(nodes, (void (*)(void *, void*)) DT_writeAccumulate,
+                (void *) &pcCursor);
+   *pcCursor = '\0';
 
    DynArray_free(nodes);
 
@@ -0,0 +1,134 @@
+/*--------------------------------------------------------------------*/
+/* dtbench_client.c                                                   */
+/* Author: Christopher Moretti                                        */
+/*--------------------------------------------------------------------*/
+
+#include <assert.h>
+#include <stddef.h>
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+#include "atom.h"
+#include "path.h"
+#include "nodeDT.h"
+
+/* the number of components above the wide directory */
+#define PARENT_DEPTH 16
+/* the length of each of those components */
+#define PARENT_COMPONENT_LENGTH 48
+/* the number of children in the wide directory */
+#define CHILD_COUNT 4096
+/* the number of times every child is looked up per measurement */
+#define ROUNDS 64
+/* room for a child's absolute path */
+#define MAX_PATH_LENGTH \
+   (PARENT_DEPTH * (PARENT_COMPONENT_LENGTH + 1) + 16)
+
+/* every child's absolute path, and the atom for its final component */
+static char acPaths[CHILD_COUNT][MAX_PATH_LENGTH];
+static const char *apcNames[CHILD_COUNT];
+
+/*
+  Binary searches oNParent's children by comparing each child's whole
+  absolute path with pcPath, as Node_hasChild used to. Returns TRUE
+  and stores the child's identifier in *pulChildID if found, or
+  returns FALSE otherwise.
+*/
+static boolean findByPath(Node_T oNParent, const char *pcPath,
+                          size_t *pulChildID) {
+  size_t ulLow = 0;
+  size_t ulHigh = Node_getNumChildren(oNParent);
+  size_t ulMid;
+  Node_T oNChild = NULL;
+  int iCmp;
+
+  while(ulLow < ulHigh) {
+    ulMid = ulLow + (ulHigh - ulLow) / 2;
+    (void) Node_getChild(oNParent, ulMid, &oNChild);
+    iCmp = Path_compareString(Node_getPath(oNChild), pcPath);
+    if(iCmp == 0) {
+      *pulChildID = ulMid;
+      return TRUE;
+    }
+    if(iCmp < 0)
+      ulLow = ulMid + 1;
+    else
+      ulHigh = ulMid;
+  }
+  return FALSE;
+}
+
+/* Returns the processor time in seconds since ulStart. */
+static double secondsSince(clock_t ulStart) {
+  return (double) (clock() - ulStart) / CLOCKS_PER_SEC;
+}
+
+/* Builds a directory with CHILD_COUNT children under a parent path of
+   PARENT_DEPTH long components, then times looking every child up by
+   full-path comparison and by final-component comparison.
+   Prints the timings to stdout. Returns 0. */
+int main(void) {
+  char acParent[MAX_PATH_LENGTH];
+  Path_T oPPath = NULL;
+  Node_T oNRoot = NULL;
+  Node_T oNParent = NULL;
+  Node_T oNNew = NULL;
+  size_t ulLength = 0;
+  size_t ulChildID = 0;
+  size_t i, j;
+  size_t ulFound;
+  clock_t ulStart;
+  double dByPath, dByName;
+
+  /* build the chain of long parent directories */
+  for(i = 0; i < PARENT_DEPTH; i++) {
+    if(i != 0)
+      acParent[ulLength++] = '/';
+    memset(acParent + ulLength, (int) ('a' + i % 26),
+           PARENT_COMPONENT_LENGTH);
+    ulLength += PARENT_COMPONENT_LENGTH;
+    acParent[ulLength] = '\0';
+
+    assert(Path_new(acParent, &oPPath) == SUCCESS);
+    assert(Node_new(oPPath, oNParent, &oNNew) == SUCCESS);
+    Path_free(oPPath);
+    if(oNRoot == NULL)
+      oNRoot = oNNew;
+    oNParent = oNNew;
+  }
+
+  /* fill the wide directory */
+  for(i = 0; i < CHILD_COUNT; i++) {
+    sprintf(acPaths[i], "%s/child%05lu", acParent, (unsigned long) i);
+    assert(Path_new(acPaths[i], &oPPath) == SUCCESS);
+    assert(Node_new(oPPath, oNParent, &oNNew) == SUCCESS);
+    Path_free(oPPath);
+    apcNames[i] = Atom_find(acPaths[i] + ulLength + 1,
+                            strlen(acPaths[i] + ulLength + 1));
+    assert(apcNames[i] != NULL);
+  }
+
+  ulFound = 0;
+  ulStart = clock();
+  for(j = 0; j < ROUNDS; j++)
+    for(i = 0; i < CHILD_COUNT; i++)
+      ulFound += findByPath(oNParent, acPaths[i], &ulChildID);
+  dByPath = secondsSince(ulStart);
+  assert(ulFound == (size_t) ROUNDS * CHILD_COUNT);
+
+  ulFound = 0;
+  ulStart = clock();
+  for(j = 0; j < ROUNDS; j++)
+    for(i = 0; i < CHILD_COUNT; i++)
+      ulFound += Node_hasChildName(oNParent, apcNames[i], &ulChildID);
+  dByName = secondsSince(ulStart);
+  assert(ulFound == (size_t) ROUNDS * CHILD_COUNT);
+
+  printf("%d lookups among %d siblings, parent path %lu chars\n",
+         ROUNDS * CHILD_COUNT, CHILD_COUNT, (unsigned long) ulLength);
+  printf("full-path compare:  %.3f s\n", dByPath);
+  printf("final-name compare: %.3f s\n", dByName);
+
+  (void) Node_free(oNRoot);
+  return 0;
+}
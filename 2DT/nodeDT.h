@@ -50,6 +50,14 @@ Path_T Node_getPath(Node_T oNNode);
 boolean Node_hasChild(Node_T oNParent, Path_T oPPath,
                          size_t *pulChildID);
 
+/*
+  Like Node_hasChild, but looks for a child whose final path component
+  is pcName, which must be an atom (see atom.h). Only the children's
+  final components are compared, never the shared parent prefix.
+*/
+boolean Node_hasChildName(Node_T oNParent, const char *pcName,
+                          size_t *pulChildID);
+
 /* Returns the number of children that oNParent has. */
 size_t Node_getNumChildren(Node_T oNParent);
 
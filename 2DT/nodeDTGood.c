@@ -6,7 +6,7 @@
 #include <stdlib.h>
 #include <assert.h>
 #include <string.h>
-#include "dynarray.h"
+#include "btree.h"
 #include "nodeDT.h"
 #include "checkerDT.h"
 
@@ -17,7 +17,7 @@ struct node {
    /* this node's parent */
    Node_T oNParent;
    /* the object containing links to this node's children */
-   DynArray_T oDChildren;
+   BTree_T oBChildren;
 };
 
 
@@ -31,24 +31,30 @@ static int Node_addChild(Node_T oNParent, Node_T oNChild,
    assert(oNParent != NULL);
    assert(oNChild != NULL);
 
-   if(DynArray_addAt(oNParent->oDChildren, ulIndex, oNChild))
+   if(BTree_addAt(oNParent->oBChildren, ulIndex, oNChild))
       return SUCCESS;
    else
       return MEMORY_ERROR;
 }
 
 /*
-  Compares the string representation of oNfirst with a string
-  pcSecond representing a node's path.
+  Compares the final component of oNFirst's path with the atom pcName.
   Returns <0, 0, or >0 if oNFirst is "less than", "equal to", or
-  "greater than" pcSecond, respectively.
+  "greater than" pcName, respectively. Siblings share every other
+  component, so this orders them exactly as their full paths would,
+  without rescanning the common parent prefix.
 */
-static int Node_compareString(const Node_T oNFirst,
-                                 const char *pcSecond) {
+static int Node_compareName(const Node_T oNFirst, const char *pcName) {
+   const char *pcFirst;
+
    assert(oNFirst != NULL);
-   assert(pcSecond != NULL);
+   assert(pcName != NULL);
 
-   return Path_compareString(oNFirst->oPPath, pcSecond);
+   pcFirst = Path_getComponent(oNFirst->oPPath,
+                               Path_getDepth(oNFirst->oPPath) - 1);
+   if(pcFirst == pcName)
+      return 0;
+   return strcmp(pcFirst, pcName);
 }
 
 
@@ -135,8 +141,8 @@ int Node_new(Path_T oPPath, Node_T oNParent, Node_T *poNResult) {
    psNew->oNParent = oNParent;
 
    /* initialize the new node */
-   psNew->oDChildren = DynArray_new(0);
-   if(psNew->oDChildren == NULL) {
+   psNew->oBChildren = BTree_new();
+   if(psNew->oBChildren == NULL) {
       Path_free(psNew->oPPath);
       free(psNew);
       *poNResult = NULL;
@@ -147,6 +153,7 @@ int Node_new(Path_T oPPath, Node_T oNParent, Node_T *poNResult) {
    if(oNParent != NULL) {
       iStatus = Node_addChild(oNParent, psNew, ulIndex);
       if(iStatus != SUCCESS) {
+         BTree_free(psNew->oBChildren);
          Path_free(psNew->oPPath);
          free(psNew);
          *poNResult = NULL;
@@ -163,36 +170,42 @@ int Node_new(Path_T oPPath, Node_T oNParent, Node_T *poNResult) {
 }
 
 size_t Node_free(Node_T oNNode) {
+   Node_T oNCurr;
+   Node_T oNNext;
+   size_t ulChildren;
    size_t ulIndex;
    size_t ulCount = 0;
 
    assert(oNNode != NULL);
    assert(CheckerDT_Node_isValid(oNNode));
 
-   /* remove from parent's list */
+   /* remove from parent's list, once for the whole subtree */
    if(oNNode->oNParent != NULL) {
-      if(DynArray_bsearch(
-            oNNode->oNParent->oDChildren,
-            oNNode, &ulIndex,
-            (int (*)(const void *, const void *)) Node_compare)
-        )
-         (void) DynArray_removeAt(oNNode->oNParent->oDChildren,
-                                  ulIndex);
+      if(Node_hasChild(oNNode->oNParent, oNNode->oPPath, &ulIndex))
+         (void) BTree_removeAt(oNNode->oNParent->oBChildren, ulIndex);
    }
 
-   /* recursively remove children */
-   while(DynArray_getLength(oNNode->oDChildren) != 0) {
-      ulCount += Node_free(DynArray_get(oNNode->oDChildren, 0));
-   }
-   DynArray_free(oNNode->oDChildren);
+   /* free the subtree in post-order without recursion: descend into
+      the last remaining child until reaching a node with none, free
+      that node, and climb back to its parent */
+   oNCurr = oNNode;
+   for(;;) {
+      ulChildren = BTree_getLength(oNCurr->oBChildren);
+      if(ulChildren != 0) {
+         oNCurr = BTree_removeAt(oNCurr->oBChildren, ulChildren - 1);
+         continue;
+      }
 
-   /* remove path */
-   Path_free(oNNode->oPPath);
+      oNNext = (oNCurr == oNNode) ? NULL : oNCurr->oNParent;
+      BTree_free(oNCurr->oBChildren);
+      Path_free(oNCurr->oPPath);
+      free(oNCurr);
+      ulCount++;
 
-   /* finally, free the struct node */
-   free(oNNode);
-   ulCount++;
-   return ulCount;
+      if(oNNext == NULL)
+         return ulCount;
+      oNCurr = oNNext;
+   }
 }
 
 Path_T Node_getPath(Node_T oNNode) {
@@ -207,16 +220,27 @@ boolean Node_hasChild(Node_T oNParent, Path_T oPPath,
    assert(oPPath != NULL);
    assert(pulChildID != NULL);
 
-   /* *pulChildID is the index into oNParent->oDChildren */
-   return DynArray_bsearch(oNParent->oDChildren,
-            (char*) Path_getPathname(oPPath), pulChildID,
-            (int (*)(const void*,const void*)) Node_compareString);
+   return Node_hasChildName(oNParent,
+            Path_getComponent(oPPath, Path_getDepth(oPPath) - 1),
+            pulChildID);
+}
+
+boolean Node_hasChildName(Node_T oNParent, const char *pcName,
+                          size_t *pulChildID) {
+   assert(oNParent != NULL);
+   assert(pcName != NULL);
+   assert(pulChildID != NULL);
+
+   /* *pulChildID is the index into oNParent->oBChildren */
+   return BTree_bsearch(oNParent->oBChildren,
+            (char*) pcName, pulChildID,
+            (int (*)(const void*,const void*)) Node_compareName);
 }
 
 size_t Node_getNumChildren(Node_T oNParent) {
    assert(oNParent != NULL);
 
-   return DynArray_getLength(oNParent->oDChildren);
+   return BTree_getLength(oNParent->oBChildren);
 }
 
 int  Node_getChild(Node_T oNParent, size_t ulChildID,
@@ -225,13 +249,13 @@ int  Node_getChild(Node_T oNParent, size_t ulChildID,
    assert(oNParent != NULL);
    assert(poNResult != NULL);
 
-   /* ulChildID is the index into oNParent->oDChildren */
+   /* ulChildID is the index into oNParent->oBChildren */
    if(ulChildID >= Node_getNumChildren(oNParent)) {
       *poNResult = NULL;
       return NO_SUCH_PATH;
    }
    else {
-      *poNResult = DynArray_get(oNParent->oDChildren, ulChildID);
+      *poNResult = BTree_get(oNParent->oBChildren, ulChildID);
       return SUCCESS;
    }
 }
@@ -12,7 +12,7 @@ enum { SUCCESS,
        ALREADY_IN_TREE,
        NO_SUCH_PATH, CONFLICTING_PATH, BAD_PATH,
        NOT_A_DIRECTORY, NOT_A_FILE,
-       MEMORY_ERROR
+       MEMORY_ERROR, IO_ERROR
 };
 
 /* In lieu of a proper boolean datatype */
@@ -20,5 +20,4 @@ enum bool { FALSE, TRUE };
 /* Make enumeration "feel" more like a builtin type */
 typedef enum bool boolean;
 
-
 #endif
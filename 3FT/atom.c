@@ -0,0 +1,310 @@
+/*--------------------------------------------------------------------*/
+/* atom.c                                                             */
+/* Author: Maxwell Lloyd and Venus Dinari                             */
+/*--------------------------------------------------------------------*/
+
+#ifdef THREADSAFE
+#define _POSIX_C_SOURCE 200112L
+#include <pthread.h>
+#endif
+#include <assert.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "atom.h"
+
+/*
+  An entry in the atom table. The atom's characters are stored
+  immediately after the entry, in the same allocation, so an atom
+  and its entry can be found from one another by pointer arithmetic.
+*/
+struct atom {
+   /* the next entry in the same hash bucket */
+   struct atom *psNext;
+   /* the hash of the atom's characters */
+   size_t ulHash;
+   /* the number of characters in the atom */
+   size_t ulLength;
+   /* the number of outstanding references to the atom */
+   size_t ulRefs;
+};
+
+/* The number of buckets the table starts with */
+enum { MIN_BUCKETS = 64 };
+
+/* The table's array of hash buckets, or NULL when there are no atoms */
+static struct atom **ppsBuckets;
+/* The number of elements in ppsBuckets (always a power of 2) */
+static size_t ulBucketCount;
+/* The number of atoms in the table */
+static size_t ulAtomCount;
+
+#ifdef THREADSAFE
+/* Held shared by Atom_find and exclusively by everything that changes
+   the table or a reference count */
+static pthread_rwlock_t sTableLock = PTHREAD_RWLOCK_INITIALIZER;
+#endif
+
+/* Acquires the table lock for reading, in the THREADSAFE build. */
+static void Atom_lockShared(void) {
+#ifdef THREADSAFE
+   (void) pthread_rwlock_rdlock(&sTableLock);
+#endif
+}
+
+/* Acquires the table lock for writing, in the THREADSAFE build. */
+static void Atom_lockExclusive(void) {
+#ifdef THREADSAFE
+   (void) pthread_rwlock_wrlock(&sTableLock);
+#endif
+}
+
+/* Releases the table lock, in the THREADSAFE build. */
+static void Atom_unlock(void) {
+#ifdef THREADSAFE
+   (void) pthread_rwlock_unlock(&sTableLock);
+#endif
+}
+
+/* Returns the entry that holds atom pcAtom. */
+static struct atom *Atom_entry(const char *pcAtom) {
+   assert(pcAtom != NULL);
+
+   return (struct atom *) pcAtom - 1;
+}
+
+/* Returns the atom stored after entry psEntry. */
+static const char *Atom_string(struct atom *psEntry) {
+   assert(psEntry != NULL);
+
+   return (const char *) (psEntry + 1);
+}
+
+/* Computes the FNV-1a hash of the ulLength characters at pcStr. */
+size_t Atom_hash(const char *pcStr, size_t ulLength) {
+   size_t ulHash = 2166136261U;
+   size_t i;
+
+   assert(pcStr != NULL);
+
+   for(i = 0; i < ulLength; i++) {
+      ulHash ^= (unsigned char) pcStr[i];
+      ulHash *= 16777619U;
+   }
+   return ulHash;
+}
+
+/*
+  Returns the entry for the ulLength characters at pcStr, whose hash
+  is ulHash, or NULL if the table has no such entry.
+*/
+static struct atom *Atom_lookup(const char *pcStr, size_t ulLength,
+                                size_t ulHash) {
+   struct atom *psEntry;
+
+   if(ppsBuckets == NULL)
+      return NULL;
+
+   for(psEntry = ppsBuckets[ulHash & (ulBucketCount - 1)];
+       psEntry != NULL; psEntry = psEntry->psNext) {
+      if(psEntry->ulHash == ulHash && psEntry->ulLength == ulLength &&
+         !memcmp(Atom_string(psEntry), pcStr, ulLength))
+         return psEntry;
+   }
+   return NULL;
+}
+
+/*
+  Doubles the number of buckets in the table, or allocates the initial
+  buckets if there are none. Returns SUCCESS, or MEMORY_ERROR if the
+  new bucket array could not be allocated (the table is unchanged).
+*/
+static int Atom_grow(void) {
+   struct atom **ppsNew;
+   struct atom *psEntry;
+   struct atom *psNext;
+   size_t ulNewCount;
+   size_t i;
+
+   if(ppsBuckets == NULL)
+      ulNewCount = MIN_BUCKETS;
+   else
+      ulNewCount = 2 * ulBucketCount;
+
+   ppsNew = calloc(ulNewCount, sizeof(struct atom *));
+   if(ppsNew == NULL)
+      return MEMORY_ERROR;
+
+   /* rehash every entry into the new buckets */
+   for(i = 0; i < ulBucketCount; i++) {
+      for(psEntry = ppsBuckets[i]; psEntry != NULL; psEntry = psNext) {
+         psNext = psEntry->psNext;
+         psEntry->psNext = ppsNew[psEntry->ulHash & (ulNewCount - 1)];
+         ppsNew[psEntry->ulHash & (ulNewCount - 1)] = psEntry;
+      }
+   }
+
+   free(ppsBuckets);
+   ppsBuckets = ppsNew;
+   ulBucketCount = ulNewCount;
+   return SUCCESS;
+}
+
+/*
+  Does the work of Atom_new, with the table lock held exclusively.
+*/
+static int Atom_intern(const char *pcStr, size_t ulLength,
+                       const char **ppcResult) {
+   struct atom *psEntry;
+   char *pcCopy;
+   size_t ulHash;
+   size_t ulBucket;
+
+   assert(pcStr != NULL);
+   assert(ppcResult != NULL);
+
+   ulHash = Atom_hash(pcStr, ulLength);
+   psEntry = Atom_lookup(pcStr, ulLength, ulHash);
+   if(psEntry != NULL) {
+      psEntry->ulRefs++;
+      *ppcResult = Atom_string(psEntry);
+      return SUCCESS;
+   }
+
+   /* keep the load factor at or below 1 */
+   if(ulAtomCount >= ulBucketCount) {
+      if(Atom_grow() != SUCCESS) {
+         *ppcResult = NULL;
+         return MEMORY_ERROR;
+      }
+   }
+
+   psEntry = malloc(sizeof(struct atom) + ulLength + 1);
+   if(psEntry == NULL) {
+      *ppcResult = NULL;
+      return MEMORY_ERROR;
+   }
+   psEntry->ulHash = ulHash;
+   psEntry->ulLength = ulLength;
+   psEntry->ulRefs = 1;
+   pcCopy = (char *) Atom_string(psEntry);
+   memcpy(pcCopy, pcStr, ulLength);
+   pcCopy[ulLength] = '\0';
+
+   ulBucket = ulHash & (ulBucketCount - 1);
+   psEntry->psNext = ppsBuckets[ulBucket];
+   ppsBuckets[ulBucket] = psEntry;
+   ulAtomCount++;
+
+   *ppcResult = pcCopy;
+   return SUCCESS;
+}
+
+/*
+  Unlinks and frees psEntry, whose last reference has been freed,
+  with the table lock held exclusively.
+*/
+static void Atom_remove(struct atom *psEntry) {
+   struct atom **ppsLink;
+
+   assert(psEntry != NULL);
+
+   /* unlink the entry from its bucket */
+   ppsLink = &ppsBuckets[psEntry->ulHash & (ulBucketCount - 1)];
+   while(*ppsLink != psEntry)
+      ppsLink = &(*ppsLink)->psNext;
+   *ppsLink = psEntry->psNext;
+   free(psEntry);
+   ulAtomCount--;
+
+   /* release the table itself along with its last atom */
+   if(ulAtomCount == 0) {
+      free(ppsBuckets);
+      ppsBuckets = NULL;
+      ulBucketCount = 0;
+   }
+}
+
+int Atom_new(const char *pcStr, size_t ulLength,
+             const char **ppcResult) {
+   int iStatus;
+
+   assert(pcStr != NULL);
+   assert(ppcResult != NULL);
+
+   Atom_lockExclusive();
+   iStatus = Atom_intern(pcStr, ulLength, ppcResult);
+   Atom_unlock();
+   return iStatus;
+}
+
+const char *Atom_find(const char *pcStr, size_t ulLength) {
+   struct atom *psEntry;
+
+   assert(pcStr != NULL);
+
+   Atom_lockShared();
+   psEntry = Atom_lookup(pcStr, ulLength, Atom_hash(pcStr, ulLength));
+   Atom_unlock();
+   if(psEntry == NULL)
+      return NULL;
+   return Atom_string(psEntry);
+}
+
+const char *Atom_retain(const char *pcAtom) {
+   assert(pcAtom != NULL);
+
+   Atom_lockExclusive();
+   Atom_entry(pcAtom)->ulRefs++;
+   Atom_unlock();
+   return pcAtom;
+}
+
+void Atom_free(const char *pcAtom) {
+   struct atom *psEntry;
+
+   if(pcAtom == NULL)
+      return;
+
+   Atom_lockExclusive();
+   psEntry = Atom_entry(pcAtom);
+   assert(psEntry->ulRefs > 0);
+   if(--psEntry->ulRefs == 0)
+      Atom_remove(psEntry);
+   Atom_unlock();
+}
+
+size_t Atom_getLength(const char *pcAtom) {
+   assert(pcAtom != NULL);
+
+   return Atom_entry(pcAtom)->ulLength;
+}
+
+size_t Atom_getHash(const char *pcAtom) {
+   assert(pcAtom != NULL);
+
+   return Atom_entry(pcAtom)->ulHash;
+}
+
+size_t Atom_copySize(const char *pcAtom) {
+   assert(pcAtom != NULL);
+
+   return sizeof(struct atom) + Atom_entry(pcAtom)->ulLength + 1;
+}
+
+const char *Atom_copy(const char *pcAtom, void *pvDest) {
+   struct atom *psEntry;
+   struct atom *psCopy = pvDest;
+
+   assert(pcAtom != NULL);
+   assert(pvDest != NULL);
+
+   /* an atom's length and hash never change, so no lock is needed */
+   psEntry = Atom_entry(pcAtom);
+   psCopy->psNext = NULL;
+   psCopy->ulHash = psEntry->ulHash;
+   psCopy->ulLength = psEntry->ulLength;
+   psCopy->ulRefs = 0;
+   memcpy(psCopy + 1, pcAtom, psEntry->ulLength + 1);
+   return Atom_string(psCopy);
+}
@@ -4,6 +4,7 @@
 /*--------------------------------------------------------------------*/
 
 #include "dynarray.h"
+#include "slab.h"
 #include <assert.h>
 #include <stdlib.h>
 
@@ -34,6 +35,14 @@ struct DynArray
 
 /*--------------------------------------------------------------------*/
 
+/* DynArray objects are allocated from a slab; their arrays, whose
+   sizes vary, come from malloc. */
+
+static struct Slab sDynArraySlab =
+   SLAB_INITIALIZER(sizeof(struct DynArray));
+
+/*--------------------------------------------------------------------*/
+
 #ifndef NDEBUG
 
 /* Check the invariants of oDynArray.  Return 1 (TRUE) iff oDynArray
@@ -81,7 +90,7 @@ DynArray_T DynArray_new(size_t uLength)
 {
    DynArray_T oDynArray;
 
-   oDynArray = (struct DynArray*)malloc(sizeof(struct DynArray));
+   oDynArray = (struct DynArray*)Slab_alloc(&sDynArraySlab);
    if (oDynArray == NULL)
       return NULL;
 
@@ -95,7 +104,7 @@ DynArray_T DynArray_new(size_t uLength)
       (const void**)calloc(oDynArray->uPhysLength, sizeof(void*));
    if (oDynArray->ppvArray == NULL)
    {
-      free(oDynArray);
+      Slab_free(&sDynArraySlab, oDynArray);
       return NULL;
    }
 
@@ -110,7 +119,7 @@ void DynArray_free(DynArray_T oDynArray)
    assert(DynArray_isValid(oDynArray));
 
    free(oDynArray->ppvArray);
-   free(oDynArray);
+   Slab_free(&sDynArraySlab, oDynArray);
 }
 
 /*--------------------------------------------------------------------*/
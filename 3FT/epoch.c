@@ -0,0 +1,265 @@
+/*--------------------------------------------------------------------*/
+/* epoch.c                                                            */
+/* Author: Maxwell Lloyd and Venus Dinari                             */
+/*--------------------------------------------------------------------*/
+
+#ifdef THREADSAFE
+#define _POSIX_C_SOURCE 200112L
+#include <pthread.h>
+#include <sched.h>
+#endif
+#include <stdlib.h>
+#include <assert.h>
+#include "epoch.h"
+
+#ifdef THREADSAFE
+
+/*
+  Each reader record gets a cache line to itself, so that announcing
+  an epoch does not disturb other threads. The epoch is advanced once
+  RECLAIM_BATCH objects have been retired since the last advance, and
+  an object retired in epoch e is freed on the advance to e + 2, so
+  LIMBO_LISTS lists hold everything still waiting.
+*/
+enum { CACHE_LINE = 64, RECLAIM_BATCH = 64, LIMBO_LISTS = 3 };
+
+/*
+  One thread's announcement. Records are never freed; the record of a
+  thread that has exited is reused by the next thread to register.
+*/
+struct Reader {
+   /* the epoch the thread announced when its current section began,
+      or 0 while it is outside a section */
+   unsigned long ulEpoch;
+   /* TRUE while a thread owns the record */
+   int iInUse;
+   /* the record registered before this one; never changes */
+   struct Reader *psNext;
+};
+
+/* the current epoch; starts at 1 so that 0 can mean "outside" */
+static unsigned long ulGlobalEpoch = 1;
+/* every record ever registered, most recent first */
+static struct Reader *psReaders;
+
+/* finds the calling thread's record, and returns it on thread exit */
+static pthread_key_t sReaderKey;
+static pthread_once_t sKeyOnce = PTHREAD_ONCE_INIT;
+static boolean bKeyCreated;
+
+/* guards the fields below and every advance of ulGlobalEpoch */
+static pthread_mutex_t sLimboLock = PTHREAD_MUTEX_INITIALIZER;
+/* the objects retired in epoch e, in list e % LIMBO_LISTS */
+static struct EpochEntry *apsLimbo[LIMBO_LISTS];
+/* the number of objects retired since the epoch last advanced */
+static size_t ulSinceAdvance;
+
+/*
+  Releases the record pvReader of a thread that is exiting, so that
+  another thread can take it. Has the signature pthread_key_create
+  expects.
+*/
+static void Epoch_release(void *pvReader) {
+   struct Reader *psReader = pvReader;
+
+   assert(psReader != NULL);
+
+   __atomic_store_n(&psReader->ulEpoch, 0UL, __ATOMIC_RELEASE);
+   __atomic_store_n(&psReader->iInUse, FALSE, __ATOMIC_RELEASE);
+}
+
+/* Creates sReaderKey, once per process. */
+static void Epoch_makeKey(void) {
+   bKeyCreated = (boolean)
+      (pthread_key_create(&sReaderKey, Epoch_release) == 0);
+}
+
+/*
+  Gives the calling thread a record, reusing a released one if there
+  is one. Returns the record, or NULL if a new one was needed and
+  could not be allocated or the thread could not be bound to it.
+*/
+static struct Reader *Epoch_register(void) {
+   struct Reader *psReader;
+   struct Reader *psHead;
+   void *pvNew;
+   int iFree;
+
+   for(psReader = __atomic_load_n(&psReaders, __ATOMIC_ACQUIRE);
+       psReader != NULL; psReader = psReader->psNext) {
+      iFree = FALSE;
+      if(__atomic_compare_exchange_n(&psReader->iInUse, &iFree, TRUE,
+                                     0, __ATOMIC_ACQUIRE,
+                                     __ATOMIC_RELAXED))
+         break;
+   }
+
+   if(psReader == NULL) {
+      if(posix_memalign(&pvNew, CACHE_LINE, sizeof(struct Reader)) != 0)
+         return NULL;
+      psReader = pvNew;
+      psReader->ulEpoch = 0;
+      psReader->iInUse = TRUE;
+      psHead = __atomic_load_n(&psReaders, __ATOMIC_RELAXED);
+      do
+         psReader->psNext = psHead;
+      while(!__atomic_compare_exchange_n(&psReaders, &psHead, psReader,
+                                         0, __ATOMIC_RELEASE,
+                                         __ATOMIC_RELAXED));
+   }
+
+   if(pthread_setspecific(sReaderKey, psReader) != 0) {
+      Epoch_release(psReader);
+      return NULL;
+   }
+   return psReader;
+}
+
+/*
+  Advances the epoch if every reader inside a section has announced
+  the current one, and then takes the list of objects that became
+  safe to free. Must be called with sLimboLock held. Returns TRUE and
+  sets *ppsFree to that list (possibly NULL) if the epoch advanced;
+  otherwise returns FALSE and sets *ppsFree to NULL.
+*/
+static boolean Epoch_tryAdvance(struct EpochEntry **ppsFree) {
+   struct Reader *psReader;
+   unsigned long ulEpoch;
+   unsigned long ulAnnounced;
+
+   assert(ppsFree != NULL);
+
+   *ppsFree = NULL;
+
+   /* order the unlinking of everything retired before the scan, as
+      Epoch_enter orders a reader's announcement before its loads */
+   __atomic_thread_fence(__ATOMIC_SEQ_CST);
+
+   ulEpoch = __atomic_load_n(&ulGlobalEpoch, __ATOMIC_RELAXED);
+   for(psReader = __atomic_load_n(&psReaders, __ATOMIC_ACQUIRE);
+       psReader != NULL; psReader = psReader->psNext) {
+      ulAnnounced = __atomic_load_n(&psReader->ulEpoch,
+                                    __ATOMIC_ACQUIRE);
+      if(ulAnnounced != 0 && ulAnnounced != ulEpoch)
+         return FALSE;
+   }
+
+   /* no reader can still hold what was retired in epoch ulEpoch - 1,
+      whose list is reused by epoch ulEpoch + 2 */
+   ulEpoch++;
+   __atomic_store_n(&ulGlobalEpoch, ulEpoch, __ATOMIC_RELEASE);
+   *ppsFree = apsLimbo[(ulEpoch + 1) % LIMBO_LISTS];
+   apsLimbo[(ulEpoch + 1) % LIMBO_LISTS] = NULL;
+   ulSinceAdvance = 0;
+   return TRUE;
+}
+
+/* Frees every object on list psFree. */
+static void Epoch_reclaim(struct EpochEntry *psFree) {
+   struct EpochEntry *psNext;
+
+   /* the entry may live inside the object it frees */
+   for(; psFree != NULL; psFree = psNext) {
+      psNext = psFree->psNext;
+      psFree->pfFree(psFree->pvItem);
+   }
+}
+
+boolean Epoch_enter(void) {
+   struct Reader *psReader;
+
+   if(pthread_once(&sKeyOnce, Epoch_makeKey) != 0 || !bKeyCreated)
+      return FALSE;
+
+   psReader = pthread_getspecific(sReaderKey);
+   if(psReader == NULL) {
+      psReader = Epoch_register();
+      if(psReader == NULL)
+         return FALSE;
+   }
+
+   /* announce, then make the announcement visible before any load
+      the section makes */
+   __atomic_store_n(&psReader->ulEpoch,
+                    __atomic_load_n(&ulGlobalEpoch, __ATOMIC_RELAXED),
+                    __ATOMIC_RELAXED);
+   __atomic_thread_fence(__ATOMIC_SEQ_CST);
+   return TRUE;
+}
+
+void Epoch_exit(void) {
+   struct Reader *psReader;
+
+   psReader = pthread_getspecific(sReaderKey);
+   assert(psReader != NULL);
+
+   __atomic_store_n(&psReader->ulEpoch, 0UL, __ATOMIC_RELEASE);
+}
+
+void Epoch_retire(struct EpochEntry *psEntry, void (*pfFree)(void *),
+                  void *pvItem) {
+   struct EpochEntry **ppsList;
+   struct EpochEntry *psFree = NULL;
+
+   assert(psEntry != NULL);
+   assert(pfFree != NULL);
+
+   psEntry->pfFree = pfFree;
+   psEntry->pvItem = pvItem;
+
+   (void) pthread_mutex_lock(&sLimboLock);
+   ppsList = &apsLimbo[__atomic_load_n(&ulGlobalEpoch, __ATOMIC_RELAXED) %
+                       LIMBO_LISTS];
+   psEntry->psNext = *ppsList;
+   *ppsList = psEntry;
+   if(++ulSinceAdvance >= RECLAIM_BATCH)
+      (void) Epoch_tryAdvance(&psFree);
+   (void) pthread_mutex_unlock(&sLimboLock);
+
+   Epoch_reclaim(psFree);
+}
+
+void Epoch_barrier(void) {
+   struct EpochEntry *psFree;
+   boolean bAdvanced;
+   size_t i;
+
+   for(;;) {
+      (void) pthread_mutex_lock(&sLimboLock);
+      for(i = 0; i < LIMBO_LISTS && apsLimbo[i] == NULL; i++)
+         ;
+      if(i == LIMBO_LISTS) {
+         (void) pthread_mutex_unlock(&sLimboLock);
+         return;
+      }
+      bAdvanced = Epoch_tryAdvance(&psFree);
+      (void) pthread_mutex_unlock(&sLimboLock);
+
+      Epoch_reclaim(psFree);
+      /* a reader is still inside an older section */
+      if(!bAdvanced)
+         (void) sched_yield();
+   }
+}
+
+#else
+
+boolean Epoch_enter(void) {
+   return TRUE;
+}
+
+void Epoch_exit(void) {
+}
+
+void Epoch_retire(struct EpochEntry *psEntry, void (*pfFree)(void *),
+                  void *pvItem) {
+   assert(psEntry != NULL);
+   assert(pfFree != NULL);
+
+   pfFree(pvItem);
+}
+
+void Epoch_barrier(void) {
+}
+
+#endif
@@ -0,0 +1,86 @@
+/*--------------------------------------------------------------------*/
+/* epoch.h                                                            */
+/* Author: Maxwell Lloyd and Venus Dinari                             */
+/*--------------------------------------------------------------------*/
+
+#ifndef EPOCH_INCLUDED
+#define EPOCH_INCLUDED
+
+#include "a4def.h"
+
+/*
+  Epoch-based reclamation lets readers follow pointers into a shared
+  structure without taking any lock. A reader brackets its accesses
+  with Epoch_enter and Epoch_exit. A writer that unlinks an object
+  passes it to Epoch_retire instead of freeing it, and the object is
+  freed only once every reader that might still reach it has called
+  Epoch_exit.
+
+  A global epoch counter advances only after every reader inside a
+  section has announced the current epoch, and what was retired two
+  epochs ago is then reclaimed. A reader's announcement goes to a
+  record of its own thread, so readers never write memory that other
+  threads write.
+
+  Pointers that readers follow must be loaded with EPOCH_READ and
+  stored with EPOCH_PUBLISH, the latter only once the object pointed
+  to is fully initialized.
+
+  When compiled without THREADSAFE defined there are no other
+  threads: sections cost nothing, and a retired object is freed at
+  once.
+*/
+
+/*
+  The bookkeeping for one retired object, embedded in the object so
+  that retiring it never allocates. Its fields belong to this module.
+*/
+struct EpochEntry {
+   /* the next entry retired in the same epoch */
+   struct EpochEntry *psNext;
+   /* the function that frees the object, and its argument */
+   void (*pfFree)(void *);
+   void *pvItem;
+};
+
+#ifdef THREADSAFE
+/* Loads lvalue slot with acquire ordering. */
+#define EPOCH_READ(slot) __atomic_load_n(&(slot), __ATOMIC_ACQUIRE)
+/* Stores value into lvalue slot with release ordering. */
+#define EPOCH_PUBLISH(slot, value) \
+   __atomic_store_n(&(slot), (value), __ATOMIC_RELEASE)
+#else
+#define EPOCH_READ(slot) (slot)
+#define EPOCH_PUBLISH(slot, value) ((slot) = (value))
+#endif
+
+/*
+  Begins a read-side section in the calling thread, registering the
+  thread the first time it calls. Returns TRUE, or FALSE if the
+  thread could not be registered for lack of memory, in which case
+  no section was begun and the caller must not call Epoch_exit.
+  Sections do not nest.
+*/
+boolean Epoch_enter(void);
+
+/* Ends the calling thread's read-side section. */
+void Epoch_exit(void);
+
+/*
+  Arranges for pfFree(pvItem) to be called once no read-side section
+  that began before this call is still running, using *psEntry, which
+  must live as long as the object, for bookkeeping. The object must
+  already be unreachable to readers that begin afterwards. May free
+  objects retired earlier. Must not be called within a read-side
+  section.
+*/
+void Epoch_retire(struct EpochEntry *psEntry, void (*pfFree)(void *),
+                  void *pvItem);
+
+/*
+  Waits until every object retired so far has been freed. Must not be
+  called within a read-side section.
+*/
+void Epoch_barrier(void);
+
+#endif
@@ -1,31 +1,148 @@
 /*--------------------------------------------------------------------*/
-/* dt.c                                                               */
+/* ft.c                                                               */
 /* Author: Christopher Moretti                                        */
 /*--------------------------------------------------------------------*/
 
+#ifdef THREADSAFE
+#define _POSIX_C_SOURCE 200112L
+#include <pthread.h>
+#endif
 #include <stddef.h>
 #include <assert.h>
 #include <string.h>
 #include <stdio.h>
 #include <stdlib.h>
 
-#include "dynarray.h"
+#include "arena.h"
+#include "atom.h"
+#include "epoch.h"
 #include "path.h"
 #include "nodeFT.h"
 #include "ft.h"
 
 
 /*
-  A Directory Tree is a representation of a hierarchy of directories,
-  represented as an AO with 3 state variables:
+  A File Tree is a representation of a hierarchy of directories and
+  files, represented as an object with 3 state variables and the
+  arena, path index, path filter, directory cache and handle table it
+  may use, plus locks in the THREADSAFE build:
 */
+struct FT {
+   /* 1. a pointer to the root node in the hierarchy */
+   Node_T oNRoot;
+   /* 2. a counter of the number of nodes in the hierarchy */
+   size_t ulCount;
+   /* 3. &sArena if every node is allocated from it, or NULL if the
+      nodes are on the heap */
+   struct Arena *psArena;
+   struct Arena sArena;
+   /* the index of every node by absolute path, or NULL if lookups
+      walk down from the root; see FT_indexPathsIn */
+   struct PathIndex *psPaths;
+   /* the filter of every node's path, or NULL if lookups of paths
+      that are not there traverse like any other; see
+      FT_filterPathsIn */
+   struct PathFilter *psFilter;
+   /* the cache of directories lookups start from, or NULL if they
+      start from the root; see FT_cacheDirsIn */
+   struct DirCache *psDirs;
+   /* the entries of the directories handles have been opened to, or
+      NULL if none has been; see FT_openDirIn */
+   struct HandleTable *psHandles;
+#ifdef THREADSAFE
+   /* held shared by every change that leaves oNRoot in place, and
+      exclusively by those that may change it, by those that read
+      every node, and by FT_rmDirLaterIn, which must know a subtree's
+      size while nothing changes inside it; below it, each node has a
+      lock of its own. Lookups take neither, and instead run in an
+      epoch read-side section */
+   pthread_rwlock_t sLock;
+   /* serializes updates to ulCount under a shared sLock */
+   pthread_mutex_t sCountLock;
+#endif
+};
 
-/* 1. a flag for being in an initialized state (TRUE) or not (FALSE) */
+/*
+  The functions that take no FT_T work on a default FT, which needs
+  no allocation and is in an initialized state (TRUE) or not (FALSE).
+*/
 static boolean bIsInitialized;
-/* 2. a pointer to the root node in the hierarchy */
-static Node_T oNRoot;
-/* 3. a counter of the number of nodes in the hierarchy */
-static size_t ulCount;
+#ifdef THREADSAFE
+static struct FT sDefault = { NULL, 0, NULL, ARENA_INITIALIZER, NULL,
+                              NULL, NULL, NULL,
+                              PTHREAD_RWLOCK_INITIALIZER,
+                              PTHREAD_MUTEX_INITIALIZER };
+#else
+static struct FT sDefault;
+#endif
+
+/* Acquires oFTree's lock shared, in the THREADSAFE build. */
+static void FT_lockShared(FT_T oFTree) {
+   assert(oFTree != NULL);
+#ifdef THREADSAFE
+   (void) pthread_rwlock_rdlock(&oFTree->sLock);
+#endif
+}
+
+/* Acquires oFTree's lock exclusively, in the THREADSAFE build. */
+static void FT_lockExclusive(FT_T oFTree) {
+   assert(oFTree != NULL);
+#ifdef THREADSAFE
+   (void) pthread_rwlock_wrlock(&oFTree->sLock);
+#endif
+}
+
+/* Releases oFTree's lock, in the THREADSAFE build. */
+static void FT_unlock(FT_T oFTree) {
+   assert(oFTree != NULL);
+#ifdef THREADSAFE
+   (void) pthread_rwlock_unlock(&oFTree->sLock);
+#endif
+}
+
+/* Releases oNHeld's lock, unless it is NULL, then oFTree's. */
+static void FT_release(FT_T oFTree, Node_T oNHeld) {
+   if(oNHeld != NULL)
+      Node_unlock(oNHeld);
+   FT_unlock(oFTree);
+}
+
+/*
+  Makes oNRoot, the root of a new tree of its own, the root of oFTree,
+  first adding its nodes to oFTree's directory cache, path index and
+  path filter, if it has them. Returns SUCCESS, or frees oNRoot and
+  returns MEMORY_ERROR if they could not be indexed.
+*/
+static int FT_setRoot(FT_T oFTree, Node_T oNRoot) {
+   assert(oFTree != NULL);
+   assert(oNRoot != NULL);
+
+   if(oFTree->psPaths != NULL &&
+      Node_indexPaths(oNRoot, oFTree->psPaths) != SUCCESS) {
+      (void) Node_free(oNRoot);
+      return MEMORY_ERROR;
+   }
+   if(oFTree->psDirs != NULL)
+      Node_cacheDirs(oNRoot, oFTree->psDirs);
+   if(oFTree->psFilter != NULL)
+      Node_filterPaths(oNRoot, oFTree->psFilter);
+   EPOCH_PUBLISH(oFTree->oNRoot, oNRoot);
+   return SUCCESS;
+}
+
+/* Adds ulAdded and subtracts ulRemoved from oFTree's node count. */
+static void FT_adjustCount(FT_T oFTree, size_t ulAdded,
+                           size_t ulRemoved) {
+   assert(oFTree != NULL);
+#ifdef THREADSAFE
+   (void) pthread_mutex_lock(&oFTree->sCountLock);
+#endif
+   oFTree->ulCount += ulAdded;
+   oFTree->ulCount -= ulRemoved;
+#ifdef THREADSAFE
+   (void) pthread_mutex_unlock(&oFTree->sCountLock);
+#endif
+}
 
 
 
@@ -38,229 +155,340 @@ static size_t ulCount;
 */
 
 /*
-  Traverses the FT starting at the root as far as possible towards
-  absolute path oPPath. If able to traverse, returns an int SUCCESS
-  status and sets *poNFurthest to the furthest node reached (which may
-  be only a prefix of oPPath, or even NULL if the root is NULL).
+  Returns the status for a path psView describes that a lookup did
+  not find in the tree whose root is oNRoot: CONFLICTING_PATH if the
+  root's name is not the path's first component, and NO_SUCH_PATH
+  otherwise.
+*/
+static int FT_missStatus(Node_T oNRoot, const struct PathView *psView) {
+   const char *pcComponent;
+   const char *pcName;
+   size_t ulOffset = 0;
+   size_t ulLength = 0;
+
+   assert(oNRoot != NULL);
+   assert(psView != NULL);
+
+   pcComponent = PathView_nextComponent(psView, &ulOffset, &ulLength);
+   pcName = Node_getName(oNRoot);
+   if(Atom_getLength(pcName) != ulLength ||
+      memcmp(pcName, pcComponent, ulLength) != 0)
+      return CONFLICTING_PATH;
+   return NO_SUCH_PATH;
+}
+
+/*
+  Looks up the node with the absolute path psView describes in
+  oFTree's path index psPaths, returning as FT_findNode does. The
+  root is consulted only to tell CONFLICTING_PATH from NO_SUCH_PATH.
+  Takes no lock, and must be called inside an epoch read-side section
+  in the THREADSAFE build.
+*/
+static int FT_findIndexed(FT_T oFTree, struct PathIndex *psPaths,
+                          const struct PathView *psView,
+                          Node_T *poNResult) {
+   Node_T oNRoot;
+
+   assert(oFTree != NULL);
+   assert(psPaths != NULL);
+   assert(psView != NULL);
+   assert(poNResult != NULL);
+
+   *poNResult = NULL;
+   oNRoot = EPOCH_READ(oFTree->oNRoot);
+   if(oNRoot == NULL)
+      return NO_SUCH_PATH;
+   if(Node_findPath(psPaths, oNRoot, psView, poNResult) == SUCCESS)
+      return SUCCESS;
+   return FT_missStatus(oNRoot, psView);
+}
+
+/*
+  Looks up the node with the absolute path psView describes in
+  oFTree, starting from the deepest directory on the path in oFTree's
+  directory cache psDirs, and returns as FT_findNode does. Takes no
+  lock, and must be called inside an epoch read-side section in the
+  THREADSAFE build.
+*/
+static int FT_findCached(FT_T oFTree, struct DirCache *psDirs,
+                         const struct PathView *psView,
+                         Node_T *poNResult) {
+   Node_T oNRoot;
+
+   assert(oFTree != NULL);
+   assert(psDirs != NULL);
+   assert(psView != NULL);
+   assert(poNResult != NULL);
+
+   *poNResult = NULL;
+   oNRoot = EPOCH_READ(oFTree->oNRoot);
+   if(oNRoot == NULL)
+      return NO_SUCH_PATH;
+   if(Node_findCached(psDirs, oNRoot, psView, poNResult) == SUCCESS)
+      return SUCCESS;
+   return FT_missStatus(oNRoot, psView);
+}
+
+/*
+  Traverses oFTree starting at the root as far as possible towards
+  the absolute path described by psView. If able to traverse, returns
+  an int SUCCESS status and sets *poNFurthest to the furthest node
+  reached (which may be only a prefix of the path, or even NULL if the
+  root is NULL).
   Otherwise, sets *poNFurthest to NULL and returns with status:
-  * CONFLICTING_PATH if the root's path is not a prefix of oPPath
-  * MEMORY_ERROR if memory could not be allocated to complete request
+  * CONFLICTING_PATH if the root's path is not a prefix of the path
+
+  Each component is matched against children's names by its hash and
+  characters, without allocating. The atom table is not consulted: an
+  atom found there holds no reference, so in the THREADSAFE build
+  another thread could free it while the traversal still used it.
+
+  Node locks are coupled on the way down: a child is locked before
+  its parent is released. Only nodes of depth ulLockDepth or less are
+  locked, and the traversal goes at most one level past them. The
+  deepest node locked is left locked, exclusively if bExclusive, and
+  stored in *poNHeld for the caller to release (NULL if none is).
+  That node is upgraded to exclusive while its parent is still held,
+  so it cannot be removed meanwhile, and its child is then looked up
+  again in case one was added before the upgrade.
+
+  If poNHeld is NULL, no lock is taken at all and bExclusive is
+  ignored; the caller must then be in an epoch read-side section,
+  which keeps every node reached from being freed until it ends.
 */
-static int FT_traversePath(Path_T oPPath, Node_T *poNFurthest) {
-   int iStatus;
-   Path_T oPPrefix = NULL;
+static int FT_traversePath(FT_T oFTree,
+                           const struct PathView *psView,
+                           size_t ulLockDepth, boolean bExclusive,
+                           Node_T *poNFurthest, Node_T *poNHeld) {
+   const char *pcComponent;
+   const char *pcName;
    Node_T oNCurr;
-   Node_T oNChild = NULL;
-   size_t ulDepth;
-   size_t i;
-   size_t ulChildID;
-
-   assert(oPPath != NULL);
+   Node_T oNAbove = NULL;
+   Node_T oNChild;
+   boolean bLocking = (boolean) (poNHeld != NULL);
+   boolean bCurrExclusive = FALSE;
+   size_t ulOffset = 0;
+   size_t ulResume;
+   size_t ulLength;
+
+   assert(oFTree != NULL);
+   assert(psView != NULL);
    assert(poNFurthest != NULL);
 
+   if(bLocking)
+      *poNHeld = NULL;
+   else
+      ulLockDepth = 0;
+
    /* root is NULL -> won't find anything */
-   if(oNRoot == NULL) {
+   oNCurr = EPOCH_READ(oFTree->oNRoot);
+   if(oNCurr == NULL) {
       *poNFurthest = NULL;
       return SUCCESS;
    }
 
-   iStatus = Path_prefix(oPPath, 1, &oPPrefix);
-   if(iStatus != SUCCESS) {
-      *poNFurthest = NULL;
-      return iStatus;
-   }
-
-   if(Path_comparePath(Node_getPath(oNRoot), oPPrefix)) {
-      Path_free(oPPrefix);
+   /* the root's path is a single component, so it must match the
+      first component of the path exactly */
+   pcComponent = PathView_nextComponent(psView, &ulOffset, &ulLength);
+   pcName = Node_getName(oNCurr);
+   if(Atom_getLength(pcName) != ulLength ||
+      memcmp(pcName, pcComponent, ulLength) != 0) {
       *poNFurthest = NULL;
       return CONFLICTING_PATH;
    }
 
-
-
-   Path_free(oPPrefix);
-   oPPrefix = NULL;
-
-   oNCurr = oNRoot;
-   ulDepth = Path_getDepth(oPPath);
-   for(i = 2; i <= ulDepth; i++) {
-      iStatus = Path_prefix(oPPath, i, &oPPrefix);
-      if(iStatus != SUCCESS) {
-         *poNFurthest = NULL;
-         return iStatus;
-      }
-      if(Node_hasChild(oNCurr, oPPrefix, &ulChildID)) {
-         /* go to that child and continue with next prefix */
-         Path_free(oPPrefix);
-         oPPrefix = NULL;
-         iStatus = Node_getChild(oNCurr, ulChildID, &oNChild);
-         if(iStatus != SUCCESS) {
-            *poNFurthest = NULL;
-            return iStatus;
+   /* the root is only removed while the FT is locked exclusively, so
+      the FT lock keeps it in place as a parent's lock would */
+   if(ulLockDepth != 0)
+      Node_lockShared(oNCurr);
+   for(;;) {
+      ulResume = ulOffset;
+      oNChild = NULL;
+      pcComponent = PathView_nextComponent(psView, &ulOffset, &ulLength);
+      if(pcComponent != NULL)
+         (void) Node_getChildByComponent(oNCurr, pcComponent, ulLength,
+                                         &oNChild);
+
+      if(oNChild != NULL &&
+         (!bLocking || Node_getDepth(oNCurr) < ulLockDepth)) {
+         /* go to that child and continue with next component */
+         if(bLocking) {
+            Node_lockShared(oNChild);
+            if(oNAbove != NULL)
+               Node_unlock(oNAbove);
          }
+         oNAbove = oNCurr;
          oNCurr = oNChild;
+         bCurrExclusive = FALSE;
+         continue;
       }
-      else {
-         /* oNCurr doesn't have child with path oPPrefix:
-            this is as far as we can go */
-         break;
+
+      /* this is as far as locks go: upgrade if asked to, and look
+         for the same child again */
+      if(bExclusive && !bCurrExclusive && ulLockDepth != 0) {
+         Node_unlock(oNCurr);
+         Node_lockExclusive(oNCurr);
+         bCurrExclusive = TRUE;
+         ulOffset = ulResume;
+         continue;
       }
+      break;
    }
 
-   Path_free(oPPrefix);
-   *poNFurthest = oNCurr;
+   if(oNAbove != NULL && bLocking)
+      Node_unlock(oNAbove);
+   if(ulLockDepth != 0)
+      *poNHeld = oNCurr;
+
+   *poNFurthest = (oNChild != NULL) ? oNChild : oNCurr;
    return SUCCESS;
 }
 
 /*
-  Traverses the FT to find a node with absolute path pcPath. Returns a
-  int SUCCESS status and sets *poNResult to be the node, if found.
+  Traverses oFTree to find a node with the absolute path described by
+  psView, locking as FT_traversePath does with ulLockDepth, bExclusive
+  and poNHeld. Returns an int
+  SUCCESS status and sets *poNResult to be the node, if found.
   Otherwise, sets *poNResult to NULL and returns with status:
-  * INITIALIZATION_ERROR if the FT is not in an initialized state
-  * BAD_PATH if pcPath does not represent a well-formatted path
-  * CONFLICTING_PATH if the root's path is not a prefix of pcPath
-  * NO_SUCH_PATH if no node with pcPath exists in the hierarchy
-  * MEMORY_ERROR if memory could not be allocated to complete request
+  * CONFLICTING_PATH if the root's path is not a prefix of the path
+  * NO_SUCH_PATH if no node with the path exists in the hierarchy
+  Does not allocate memory.
  */
-static int FT_findNode(const char *pcPath, Node_T *poNResult) {
-   Path_T oPPath = NULL;
+static int FT_findNode(FT_T oFTree, const struct PathView *psView,
+                       size_t ulLockDepth, boolean bExclusive,
+                       Node_T *poNResult, Node_T *poNHeld) {
+   struct PathIndex *psPaths;
+   struct PathFilter *psFilter;
+   struct DirCache *psDirs;
+   Node_T oNRoot;
    Node_T oNFound = NULL;
    int iStatus;
 
-   assert(pcPath != NULL);
+   assert(psView != NULL);
    assert(poNResult != NULL);
+   assert(oFTree != NULL);
 
-   if(!bIsInitialized) {
+   /* a path the filter rules out is answered from the root alone */
+   psFilter = EPOCH_READ(oFTree->psFilter);
+   if(psFilter != NULL && !Node_mayHavePath(psFilter, psView)) {
       *poNResult = NULL;
-      return INITIALIZATION_ERROR;
+      if(poNHeld != NULL)
+         *poNHeld = NULL;
+      oNRoot = EPOCH_READ(oFTree->oNRoot);
+      return oNRoot == NULL ? NO_SUCH_PATH :
+         FT_missStatus(oNRoot, psView);
    }
 
-   iStatus = Path_new(pcPath, &oPPath);
-   if(iStatus != SUCCESS) {
-      *poNResult = NULL;
-      return iStatus;
+   /* a lookup that takes no locks probes the path index, if any, or
+      else starts from the directory cache, if any */
+   if(poNHeld == NULL) {
+      psPaths = EPOCH_READ(oFTree->psPaths);
+      if(psPaths != NULL)
+         return FT_findIndexed(oFTree, psPaths, psView, poNResult);
+      psDirs = EPOCH_READ(oFTree->psDirs);
+      if(psDirs != NULL)
+         return FT_findCached(oFTree, psDirs, psView, poNResult);
    }
 
-   iStatus = FT_traversePath(oPPath, &oNFound);
-   if(iStatus != SUCCESS)
-   {
-      Path_free(oPPath);
+   iStatus = FT_traversePath(oFTree, psView, ulLockDepth, bExclusive,
+                             &oNFound, poNHeld);
+   if(iStatus != SUCCESS) {
       *poNResult = NULL;
       return iStatus;
    }
 
    if(oNFound == NULL) {
-      Path_free(oPPath);
       *poNResult = NULL;
       return NO_SUCH_PATH;
    }
 
-   if(Path_comparePath(Node_getPath(oNFound), oPPath) != 0) {
-      Path_free(oPPath);
+   /* every level matched, so only a shallower node can differ */
+   if(Node_getDepth(oNFound) != PathView_getDepth(psView)) {
       *poNResult = NULL;
       return NO_SUCH_PATH;
    }
 
-   Path_free(oPPath);
    *poNResult = oNFound;
    return SUCCESS;
 }
 
-/*--------------------------------------------------------------------*/
 
-int FT_insertDir(const char *pcPath) {
+/* --------------------------------------------------------------------
+
+  Each FT_*Locked function does the work of the corresponding FT_*In
+  function, which calls it with oFTree's lock held. A function that
+  finds a node leaves the one node lock it still holds in *poNHeld,
+  and the FT_*In function releases it after the call. The lookups may
+  instead be called with poNHeld NULL from an epoch read-side
+  section, without oFTree's lock, and then take no lock at all.
+
+-------------------------------------------------------------------- */
+
+static int FT_insertDirLocked(FT_T oFTree, const char *pcPath,
+   Node_T *poNHeld) {
    int iStatus;
+   struct PathView sView;
    Path_T oPPath = NULL;
    Node_T oNFirstNew = NULL;
    Node_T oNCurr = NULL;
    size_t ulDepth, ulIndex;
-   size_t ulNewNodes = 0;
+   size_t ulNewNodes;
 
    assert(pcPath != NULL);
 
-   /* validate pcPath and generate a Path_T for it */
-   if(!bIsInitialized)
-      return INITIALIZATION_ERROR;
-
-   iStatus = Path_new(pcPath, &oPPath);
+   /* validate pcPath without allocating */
+   iStatus = PathView_init(&sView, pcPath);
    if(iStatus != SUCCESS)
       return iStatus;
 
-   /* find the closest ancestor of oPPath already in the tree */
-   iStatus= FT_traversePath(oPPath, &oNCurr);
+   /* find the closest ancestor of pcPath already in the tree */
+   iStatus= FT_traversePath(oFTree, &sView, PathView_getDepth(&sView),
+                            TRUE, &oNCurr, poNHeld);
    if(iStatus != SUCCESS)
-   {
-      Path_free(oPPath);
       return iStatus;
-   }
-   
+
    /* check to see if oNCurr is a file */
-   if(oNCurr != NULL && Node_type(oNCurr) == TRUE) {
-      Path_free(oPPath);
+   if(oNCurr != NULL && Node_type(oNCurr) == TRUE)
       return NOT_A_DIRECTORY;
-   }
 
    /* no ancestor node found, so if root is not NULL,
       pcPath isn't underneath root. */
-   if(oNCurr == NULL && oNRoot != NULL) {
-      Path_free(oPPath);
+   if(oNCurr == NULL && oFTree->oNRoot != NULL)
       return CONFLICTING_PATH;
-   }
 
-   ulDepth = Path_getDepth(oPPath);
+   ulDepth = PathView_getDepth(&sView);
    if(oNCurr == NULL) /* new root! */
       ulIndex = 1;
    else {
-      ulIndex = Path_getDepth(Node_getPath(oNCurr))+1;
+      ulIndex = Node_getDepth(oNCurr)+1;
 
       /* oNCurr is the node we're trying to insert */
-      if(ulIndex == ulDepth+1 && !Path_comparePath(oPPath,
-                                       Node_getPath(oNCurr))) {
-         Path_free(oPPath);
+      if(ulIndex == ulDepth+1)
          return ALREADY_IN_TREE;
-      }
    }
 
-   /* starting at oNCurr, build rest of the path one level at a time */
-   while(ulIndex <= ulDepth) {
-      Path_T oPPrefix = NULL;
-      Node_T oNNewNode = NULL;
+   /* only now that nodes will be added, generate a Path_T for pcPath */
+   iStatus = Path_new(pcPath, &oPPath);
+   if(iStatus != SUCCESS)
+      return iStatus;
 
-      /* generate a Path_T for this level */
-      iStatus = Path_prefix(oPPath, ulIndex, &oPPrefix);
-      if(iStatus != SUCCESS) {
-         Path_free(oPPath);
-         if(oNFirstNew != NULL)
-            (void) Node_free(oNFirstNew);
-         
-         return iStatus;
-      }
+   /* build the rest of the path below oNCurr in one piece, linked in
+      only once complete; a new root starts the tree's nodes in its
+      arena, if it has one */
+   iStatus = Node_newChain(oPPath, oNCurr, oFTree->psArena, FALSE,
+                          NULL, 0, &oNFirstNew);
+   Path_free(oPPath);
+   if(iStatus != SUCCESS)
+      return iStatus;
+   ulNewNodes = ulDepth - ulIndex + 1;
 
-      /* insert the new node for this level */
-      iStatus = Node_newDir(oPPrefix, oNCurr, &oNNewNode); /* We need to make this Node_newDir()*/
-      if(iStatus != SUCCESS) {
-         Path_free(oPPath);
-         Path_free(oPPrefix);
-         if(oNFirstNew != NULL)
-            (void) Node_free(oNFirstNew);
-         
+   /* update FT state variables to reflect insertion */
+   if(oFTree->oNRoot == NULL) {
+      iStatus = FT_setRoot(oFTree, oNFirstNew);
+      if(iStatus != SUCCESS)
          return iStatus;
-      }
-
-      /* set up for next level */
-      Path_free(oPPrefix);
-      oNCurr = oNNewNode;
-      ulNewNodes++;
-      if(oNFirstNew == NULL)
-         oNFirstNew = oNCurr;
-      ulIndex++;
    }
-
-   Path_free(oPPath);
-   /* update FT state variables to reflect insertion */
-   if(oNRoot == NULL)
-      oNRoot = oNFirstNew;
-   ulCount += ulNewNodes;
+   FT_adjustCount(oFTree, ulNewNodes, 0);
 
    
    return SUCCESS;
@@ -268,13 +496,19 @@ int FT_insertDir(const char *pcPath) {
 
 /*--------------------------------------------------------------------*/
 
-boolean FT_containsDir(const char *pcPath) {
+static boolean FT_containsDirLocked(FT_T oFTree, const char *pcPath,
+   Node_T *poNHeld) {
    int iStatus;
+   struct PathView sView;
    Node_T oNFound = NULL;
 
    assert(pcPath != NULL);
 
-   iStatus = FT_findNode(pcPath, &oNFound);
+   if(PathView_init(&sView, pcPath) != SUCCESS)
+      return FALSE;
+
+   iStatus = FT_findNode(oFTree, &sView, PathView_getDepth(&sView),
+                         FALSE, &oNFound, poNHeld);
 
    /* makes sure the node exists and is a directory */
    return (boolean) ((iStatus == SUCCESS) && (Node_type(oNFound) == FALSE));
@@ -282,14 +516,22 @@ boolean FT_containsDir(const char *pcPath) {
 
 /*--------------------------------------------------------------------*/
 
-int FT_rmDir(const char *pcPath) {
+static int FT_rmDirLocked(FT_T oFTree, const char *pcPath,
+   boolean bLater, Node_T *poNHeld) {
    int iStatus;
+   struct PathView sView;
    Node_T oNFound = NULL;
 
    assert(pcPath != NULL);
    
 
-   iStatus = FT_findNode(pcPath, &oNFound);
+   iStatus = PathView_init(&sView, pcPath);
+   if(iStatus != SUCCESS)
+      return iStatus;
+
+   /* lock the parent, which Node_free detaches oNFound from */
+   iStatus = FT_findNode(oFTree, &sView, PathView_getDepth(&sView) - 1,
+                         TRUE, &oNFound, poNHeld);
 
    if(iStatus != SUCCESS)
        return iStatus;
@@ -298,9 +540,19 @@ int FT_rmDir(const char *pcPath) {
       return NOT_A_DIRECTORY;
    }
 
-   ulCount -= Node_free(oNFound);
-   if(ulCount == 0)
-      oNRoot = NULL;
+   if(oNFound == oFTree->oNRoot)
+      EPOCH_PUBLISH(oFTree->oNRoot, NULL);
+
+   /* if bLater, only unlink the subtree here, and count its nodes
+      removed now though they are freed in the background */
+   if(bLater) {
+      FT_adjustCount(oFTree, 0, Node_detach(oNFound));
+      if(oFTree->psHandles != NULL)
+         Node_countDetach(oFTree->psHandles);
+      Node_freeLater(oNFound);
+   }
+   else
+      FT_adjustCount(oFTree, 0, Node_free(oNFound));
 
    
    return SUCCESS;
@@ -308,113 +560,75 @@ int FT_rmDir(const char *pcPath) {
 
 /*--------------------------------------------------------------------*/
 
-int FT_insertFile(const char *pcPath, void *pvContents,
-   size_t ulLength) {
+static int FT_insertFileLocked(FT_T oFTree, const char *pcPath,
+   void *pvContents, size_t ulLength,
+   Node_T *poNHeld) {
    int iStatus;
+   struct PathView sView;
    Path_T oPPath = NULL;
    Node_T oNFirstNew = NULL;
    Node_T oNCurr = NULL;
    size_t ulDepth, ulIndex;
-   size_t ulNewNodes = 0;
+   size_t ulNewNodes;
 
    assert(pcPath != NULL);
 
-   /* validate pcPath and generate a Path_T for it */
-   if(!bIsInitialized)
-      return INITIALIZATION_ERROR;
-
-   iStatus = Path_new(pcPath, &oPPath);
+   /* validate pcPath without allocating */
+   iStatus = PathView_init(&sView, pcPath);
    if(iStatus != SUCCESS)
       return iStatus;
 
-   if(oNRoot == NULL){
+   if(oFTree->oNRoot == NULL){
       return CONFLICTING_PATH;
    }
 
-   /* find the closest ancestor of oPPath already in the tree */
-   iStatus= FT_traversePath(oPPath, &oNCurr);
+   /* find the closest ancestor of pcPath already in the tree */
+   iStatus= FT_traversePath(oFTree, &sView, PathView_getDepth(&sView),
+                            TRUE, &oNCurr, poNHeld);
    if(iStatus != SUCCESS)
-   {
-      Path_free(oPPath);
       return iStatus;
-   }
-   
+
    /* check to see if oNCurr is a file */
-   if(oNCurr != NULL && Node_type(oNCurr) == TRUE) {
-      Path_free(oPPath);
+   if(oNCurr != NULL && Node_type(oNCurr) == TRUE)
       return NOT_A_DIRECTORY;
-   }
 
    /* no ancestor node found, so if root is not NULL,
       pcPath isn't underneath root. */
-   if(oNCurr == NULL && oNRoot != NULL) {
-      Path_free(oPPath);
+   if(oNCurr == NULL && oFTree->oNRoot != NULL)
       return CONFLICTING_PATH;
-   }
 
-   ulDepth = Path_getDepth(oPPath);
-   if(oNCurr == NULL){ /* new root! */
+   ulDepth = PathView_getDepth(&sView);
+   if(oNCurr == NULL) /* new root! */
       ulIndex = 1;
-   }
    else {
-      ulIndex = Path_getDepth(Node_getPath(oNCurr))+1;
+      ulIndex = Node_getDepth(oNCurr)+1;
 
       /* oNCurr is the node we're trying to insert */
-      if(ulIndex == ulDepth+1 && !Path_comparePath(oPPath,
-                                       Node_getPath(oNCurr))) {
-         Path_free(oPPath);
+      if(ulIndex == ulDepth+1)
          return ALREADY_IN_TREE;
-      }
    }
 
-   /* starting at oNCurr, build rest of the path one level at a time */
-   while(ulIndex <= ulDepth) {
-      Path_T oPPrefix = NULL;
-      Node_T oNNewNode = NULL;
+   /* only now that nodes will be added, generate a Path_T for pcPath */
+   iStatus = Path_new(pcPath, &oPPath);
+   if(iStatus != SUCCESS)
+      return iStatus;
 
-      /* generate a Path_T for this level */
-      iStatus = Path_prefix(oPPath, ulIndex, &oPPrefix);
-      if(iStatus != SUCCESS) {
-         Path_free(oPPath);
-         if(oNFirstNew != NULL)
-            (void) Node_free(oNFirstNew);
-         
-         return iStatus;
-      }
+   /* build the rest of the path below oNCurr, ending in the file, in
+      one piece linked in only once complete */
+   iStatus = Node_newChain(oPPath, oNCurr, oFTree->psArena, TRUE,
+                          pvContents, ulLength, &oNFirstNew);
+   Path_free(oPPath);
+   if(iStatus != SUCCESS)
+      return iStatus;
+   ulNewNodes = ulDepth - ulIndex + 1;
 
-      /* insert the new node for this level */
-      if(ulIndex==ulDepth){
-         iStatus = Node_newFile(oPPrefix, oNCurr, &oNNewNode, pvContents, ulLength); /* We need to make this Node_newFile()*/
-      }
-      else{
-         iStatus = Node_newDir(oPPrefix, oNCurr, &oNNewNode); /* We need to make this Node_newDir()*/
-      }
-      if(iStatus != SUCCESS) {
-         Path_free(oPPath);
-         Path_free(oPPrefix);
-         if(oNFirstNew != NULL)
-            (void) Node_free(oNFirstNew);
-         
+   /* update FT state variables to reflect insertion */
+   if(oFTree->oNRoot == NULL) {
+      iStatus = FT_setRoot(oFTree, oNFirstNew);
+      if(iStatus != SUCCESS)
          return iStatus;
-      }
-
-      /* set up for next level */
-      Path_free(oPPrefix);
-      oNCurr = oNNewNode;
-      ulNewNodes++;
-      if(oNFirstNew == NULL)
-         oNFirstNew = oNCurr;
-      ulIndex++;
    }
-
-
-
-
-   Path_free(oPPath);
-   /* update FT state variables to reflect insertion */
-   if(oNRoot == NULL)
-      oNRoot = oNFirstNew;
-   ulCount += ulNewNodes;
+   FT_adjustCount(oFTree, ulNewNodes, 0);
 
    
    return SUCCESS;
@@ -422,13 +636,19 @@ int FT_insertFile(const char *pcPath, void *pvContents,
 
 /*--------------------------------------------------------------------*/
 
-boolean FT_containsFile(const char *pcPath) {
+static boolean FT_containsFileLocked(FT_T oFTree, const char *pcPath,
+   Node_T *poNHeld) {
    int iStatus;
+   struct PathView sView;
    Node_T oNFound = NULL;
 
    assert(pcPath != NULL);
 
-   iStatus = FT_findNode(pcPath, &oNFound);
+   if(PathView_init(&sView, pcPath) != SUCCESS)
+      return FALSE;
+
+   iStatus = FT_findNode(oFTree, &sView, PathView_getDepth(&sView),
+                         FALSE, &oNFound, poNHeld);
 
    /* makes sure the node exists and is a directory */
    return (boolean) ((iStatus == SUCCESS) && (Node_type(oNFound) == TRUE));
@@ -436,14 +656,22 @@ boolean FT_containsFile(const char *pcPath) {
 
 /*--------------------------------------------------------------------*/
 
-int FT_rmFile(const char *pcPath) {
+static int FT_rmFileLocked(FT_T oFTree, const char *pcPath,
+   Node_T *poNHeld) {
    int iStatus;
+   struct PathView sView;
    Node_T oNFound = NULL;
 
    assert(pcPath != NULL);
    
 
-   iStatus = FT_findNode(pcPath, &oNFound);
+   iStatus = PathView_init(&sView, pcPath);
+   if(iStatus != SUCCESS)
+      return iStatus;
+
+   /* lock the parent, which Node_free detaches oNFound from */
+   iStatus = FT_findNode(oFTree, &sView, PathView_getDepth(&sView) - 1,
+                         TRUE, &oNFound, poNHeld);
 
    if(iStatus != SUCCESS)
        return iStatus;
@@ -452,9 +680,7 @@ int FT_rmFile(const char *pcPath) {
       return NOT_A_FILE;
    }
 
-   ulCount -= Node_free(oNFound);
-   if(ulCount == 0)
-      oNRoot = NULL;
+   FT_adjustCount(oFTree, 0, Node_free(oNFound));
 
    
    return SUCCESS;
@@ -462,277 +688,1766 @@ int FT_rmFile(const char *pcPath) {
 
 /*--------------------------------------------------------------------*/
 
-void *FT_getFileContents(const char *pcPath){
+static void *FT_getFileContentsLocked(FT_T oFTree, const char *pcPath,
+   Node_T *poNHeld) {
    int iStatus;
-   Node_T oNCurr;
-   Path_T oPPath;
-   oNCurr = NULL;
-   oPPath = NULL;
+   struct PathView sView;
+   Node_T oNFound = NULL;
 
    assert(pcPath != NULL);
 
-   /* Defensive copy */
-   iStatus = Path_new(pcPath, &oPPath);
-   if(iStatus != SUCCESS)
-   {
-      Path_free(oPPath);
+   if(PathView_init(&sView, pcPath) != SUCCESS)
       return NULL;
-   }
 
-   /* Store last node of pcPath into oNCurr*/
-   iStatus = FT_traversePath(oPPath, &oNCurr);
+   iStatus = FT_findNode(oFTree, &sView, PathView_getDepth(&sView),
+                         FALSE, &oNFound, poNHeld);
    if(iStatus != SUCCESS)
-   {
-      Path_free(oPPath);
-      return NULL;
-   }
-
-   /* Make sure oNCurr is not a directory*/
-   if(Node_type(oNCurr) == FALSE){
-      Path_free(oPPath);
       return NULL;
-   }
 
-   /* Confirm oNCurr is last node of pcPath */
-   if(Path_comparePath(Node_getPath(oNCurr), oPPath) != 0){
-      Path_free(oPPath);
+   /* Make sure oNFound is not a directory*/
+   if(Node_type(oNFound) == FALSE)
       return NULL;
-   }
 
-   /* Need to access oNCurrs contents*/
-   Path_free(oPPath);
-   return Node_data(oNCurr);
+   return Node_data(oNFound);
 }
 
 /*--------------------------------------------------------------------*/
 
-void *FT_replaceFileContents(const char *pcPath, void *pvNewContents,
-   size_t ulNewLength){
-      int iStatus;
-      void* oldContents;
-      Node_T oNCurr;
-      Path_T oPPath;
-      oNCurr = NULL;
-      oPPath = NULL;
-   
-      assert(pcPath != NULL);
-   
-      /* Defensive copy */
-      iStatus = Path_new(pcPath, &oPPath);
-      if(iStatus != SUCCESS)
-      {
-         Path_free(oPPath);
-         return NULL;
-      }
-   
-      /* Store last node of pcPath into oNCurr*/
-      iStatus = FT_traversePath(oPPath, &oNCurr);
-      if(iStatus != SUCCESS)
-      {
-         Path_free(oPPath);
-         return NULL;
-      }
-   
-      /* Make sure oNCurr is not a directory*/
-      if(Node_type(oNCurr) == FALSE){
-         Path_free(oPPath);
-         return NULL;
-      }
-   
-      /* Confirm oNCurr is last node of pcPath */
-      if(Path_comparePath(Node_getPath(oNCurr), oPPath) != 0){
-         Path_free(oPPath);
-         return NULL;
-      }
-   
-      /* Need to access oNCurrs contents*/
-      Path_free(oPPath);
-      oldContents = Node_data(oNCurr);
-      Node_changeData(oNCurr, pvNewContents, ulNewLength);
-      return oldContents;
+static void *FT_replaceFileContentsLocked(FT_T oFTree, const char *pcPath,
+   void *pvNewContents, size_t ulNewLength,
+   Node_T *poNHeld) {
+   int iStatus;
+   void* oldContents;
+   struct PathView sView;
+   Node_T oNFound = NULL;
+
+   assert(pcPath != NULL);
+
+   if(PathView_init(&sView, pcPath) != SUCCESS)
+      return NULL;
+
+   iStatus = FT_findNode(oFTree, &sView, PathView_getDepth(&sView),
+                         TRUE, &oNFound, poNHeld);
+   if(iStatus != SUCCESS)
+      return NULL;
+
+   /* Make sure oNFound is not a directory*/
+   if(Node_type(oNFound) == FALSE)
+      return NULL;
+
+   oldContents = Node_data(oNFound);
+   Node_changeData(oNFound, pvNewContents, ulNewLength);
+   return oldContents;
 }
 
 /*--------------------------------------------------------------------*/
 
-int FT_stat(const char *pcPath, boolean *pbIsFile, size_t *pulSize){
+static int FT_statLocked(FT_T oFTree, const char *pcPath,
+   boolean *pbIsFile, size_t *pulSize,
+   Node_T *poNHeld) {
    int iStatus;
-   Node_T oNCurr;
-   Path_T oPPath;
-   oNCurr = NULL;
-   oPPath = NULL;
+   struct PathView sView;
+   Node_T oNFound = NULL;
 
    assert(pcPath != NULL);
    assert(pbIsFile != NULL);
    assert(pulSize != NULL);
 
-   if(!bIsInitialized){
-      return INITIALIZATION_ERROR;
-   }
-
-   /* Defensive copy */
-   iStatus = Path_new(pcPath, &oPPath);
+   iStatus = PathView_init(&sView, pcPath);
    if(iStatus != SUCCESS)
-   {
-      Path_free(oPPath);
-      return MEMORY_ERROR;
-   }
+      return iStatus;
 
-   /* Store last node of pcPath into oNCurr*/
-   iStatus = FT_traversePath(oPPath, &oNCurr);
+   iStatus = FT_findNode(oFTree, &sView, PathView_getDepth(&sView),
+                         FALSE, &oNFound, poNHeld);
    if(iStatus != SUCCESS)
-   {
-      Path_free(oPPath);
-      return MEMORY_ERROR;
-   }
-
-   /* Confirm oNCurr is last node of pcPath */
-   if(Path_comparePath(Node_getPath(oNCurr), oPPath) != 0){
-      Path_free(oPPath);
-      return NO_SUCH_PATH;
-   }
+      return iStatus;
 
    /* If it is a directory, do not change pulSize */
-   if(Node_type(oNCurr) == TRUE){
-      *pulSize = Node_len(oNCurr);
+   if(Node_type(oNFound) == TRUE){
+      *pulSize = Node_len(oNFound);
    }
 
-   *pbIsFile = Node_type(oNCurr);
-   
+   *pbIsFile = Node_type(oNFound);
 
    return SUCCESS;
 }
 
+
 /*--------------------------------------------------------------------*/
 
-int FT_init(void) {
-   if(bIsInitialized)
-      return INITIALIZATION_ERROR;
+/*
+  Does the work of FT_openDirIn if bIsFile is FALSE and of
+  FT_openFileIn if it is TRUE, storing the handle's entry in
+  *ppsEntry and its generation in *pulGeneration.
+*/
+static int FT_openLocked(FT_T oFTree, const char *pcPath,
+   boolean bIsFile, struct NodeHandle **ppsEntry,
+   size_t *pulGeneration, Node_T *poNHeld) {
+   int iStatus;
+   struct PathView sView;
+   struct HandleTable *psHandles;
+   Node_T oNFound = NULL;
 
-   bIsInitialized = TRUE;
-   oNRoot = NULL;
-   ulCount = 0;
+   assert(pcPath != NULL);
+   assert(ppsEntry != NULL);
+   assert(pulGeneration != NULL);
 
-   
-   return SUCCESS;
-}
+   iStatus = PathView_init(&sView, pcPath);
+   if(iStatus != SUCCESS)
+      return iStatus;
 
-/*--------------------------------------------------------------------*/
+   /* the first handle makes the table, with oFTree locked
+      exclusively */
+   if(oFTree->psHandles == NULL) {
+      psHandles = Node_newHandleTable();
+      if(psHandles == NULL)
+         return MEMORY_ERROR;
+      EPOCH_PUBLISH(oFTree->psHandles, psHandles);
+   }
 
-int FT_destroy(void) {
-   
+   /* hold the node, which Node_openHandle requires */
+   iStatus = FT_findNode(oFTree, &sView, PathView_getDepth(&sView),
+                         FALSE, &oNFound, poNHeld);
+   if(iStatus != SUCCESS)
+      return iStatus;
 
-   if(!bIsInitialized)
-      return INITIALIZATION_ERROR;
+   if(Node_type(oNFound) != bIsFile)
+      return bIsFile ? NOT_A_FILE : NOT_A_DIRECTORY;
 
-   if(oNRoot) {
-      ulCount -= Node_free(oNRoot);
-      oNRoot = NULL;
-   }
+   return Node_openHandle(oFTree->psHandles, oNFound, ppsEntry,
+                          pulGeneration);
+}
 
-   bIsInitialized = FALSE;
+/*
+  Returns SUCCESS if pcName is a single component of a path, that is
+  if it is not empty and has no '/', and BAD_PATH otherwise.
+*/
+static int FT_checkName(const char *pcName) {
+   assert(pcName != NULL);
 
-   
+   if(*pcName == '\0' || strchr(pcName, '/') != NULL)
+      return BAD_PATH;
    return SUCCESS;
 }
 
-
-/* --------------------------------------------------------------------
-
-  The following auxiliary functions are used for generating the
-  string representation of the FT.
+/*
+  Locks the node of oFTree that the handle with entry psEntry and
+  generation ulGeneration is to exclusively and stores it in *poNHeld.
+  Returns SUCCESS, or sets *poNHeld to NULL and returns NO_SUCH_PATH
+  if the handle is stale or to no node, or MEMORY_ERROR if this thread
+  cannot take part in the epoch scheme, which keeps the node from
+  being freed until it is locked.
 */
+static int FT_lockHandle(FT_T oFTree, struct NodeHandle *psEntry,
+                         size_t ulGeneration, Node_T *poNHeld) {
+   Node_T oNNode;
 
-/*
-  Performs a pre-order traversal of the tree rooted at n,
-  inserting each payload to DynArray_T d beginning at index i.
-  Returns the next unused index in d after the insertion(s).
-*/
-static size_t FT_preOrderTraversal(Node_T n, DynArray_T d, size_t i) {
-   size_t c;
-
-   assert(d != NULL);
-
-   if(n != NULL) {
-      (void) DynArray_set(d, i, n);
-      i++;
-
-      /* Get all file children */
-      for(c = 0; c < Node_getNumChildren(n); c++) {
-         int iStatus;
-         Node_T oNChild = NULL;
-         iStatus = Node_getChild(n,c, &oNChild);
-         assert(iStatus == SUCCESS);
-         if(Node_type(oNChild) == TRUE){
-            i = FT_preOrderTraversal(oNChild, d, i);
-         }
-      }
+   assert(oFTree != NULL);
+   assert(poNHeld != NULL);
 
-      /* Get all directory children, and add them recursively */
-      for(c = 0; c < Node_getNumChildren(n); c++) {
-         int iStatus;
-         Node_T oNChild = NULL;
-         iStatus = Node_getChild(n,c, &oNChild);
-         assert(iStatus == SUCCESS);
-         if(Node_type(oNChild) == FALSE){
-            i = FT_preOrderTraversal(oNChild, d, i);
-         }
-      }
+   *poNHeld = NULL;
+   if(!Epoch_enter())
+      return MEMORY_ERROR;
+   oNNode = Node_resolveHandle(psEntry, ulGeneration,
+                               EPOCH_READ(oFTree->oNRoot));
+   if(oNNode != NULL) {
+      /* the node may have been removed before it was locked */
+      Node_lockExclusive(oNNode);
+      if(Node_isHandleCurrent(psEntry, ulGeneration))
+         *poNHeld = oNNode;
+      else
+         Node_unlock(oNNode);
    }
-   return i;
+   Epoch_exit();
+
+   return *poNHeld != NULL ? SUCCESS : NO_SUCH_PATH;
 }
 
-/*
-  Alternate version of strlen that uses pulAcc as an in-out parameter
-  to accumulate a string length, rather than returning the length of
-  oNNode's path, and also always adds one addition byte to the sum.
+/*--------------------------------------------------------------------*/
+
+static int FT_insertFileAtLocked(FT_T oFTree, const FT_Dir *psDir,
+   const char *pcName, void *pvContents, size_t ulLength,
+   Node_T *poNHeld) {
+   int iStatus;
+   Node_T oNNew = NULL;
+
+   assert(psDir != NULL);
+   assert(poNHeld != NULL);
+
+   iStatus = FT_checkName(pcName);
+   if(iStatus != SUCCESS)
+      return iStatus;
+
+   iStatus = FT_lockHandle(oFTree, psDir->psEntry, psDir->ulGeneration,
+                           poNHeld);
+   if(iStatus != SUCCESS)
+      return iStatus;
+
+   iStatus = Node_newChild(*poNHeld, NULL, pcName, strlen(pcName), TRUE,
+                           pvContents, ulLength, &oNNew);
+   if(iStatus != SUCCESS)
+      return iStatus;
+   FT_adjustCount(oFTree, 1, 0);
+
+   return SUCCESS;
+}
+
+/*--------------------------------------------------------------------*/
+
+/*
+  Does the work of FT_containsAtIn. Takes no lock, and must be called
+  inside an epoch read-side section in the THREADSAFE build.
+*/
+static boolean FT_containsAtLocked(FT_T oFTree, const FT_Dir *psDir,
+   const char *pcName) {
+   Node_T oNDir;
+   Node_T oNChild = NULL;
+
+   assert(psDir != NULL);
+
+   if(FT_checkName(pcName) != SUCCESS)
+      return FALSE;
+
+   oNDir = Node_resolveHandle(psDir->psEntry, psDir->ulGeneration,
+                              EPOCH_READ(oFTree->oNRoot));
+   if(oNDir == NULL)
+      return FALSE;
+
+   return (boolean) (Node_getChildByComponent(oNDir, pcName,
+                                              strlen(pcName),
+                                              &oNChild) == SUCCESS);
+}
+
+/*--------------------------------------------------------------------*/
+
+static int FT_rmAtLocked(FT_T oFTree, const FT_Dir *psDir,
+   const char *pcName, Node_T *poNHeld) {
+   int iStatus;
+   Node_T oNFound = NULL;
+
+   assert(psDir != NULL);
+   assert(poNHeld != NULL);
+
+   iStatus = FT_checkName(pcName);
+   if(iStatus != SUCCESS)
+      return iStatus;
+
+   /* the directory is held exclusively, as the parent of the node
+      Node_free detaches */
+   iStatus = FT_lockHandle(oFTree, psDir->psEntry, psDir->ulGeneration,
+                           poNHeld);
+   if(iStatus != SUCCESS)
+      return iStatus;
+
+   if(Node_getChildByComponent(*poNHeld, pcName, strlen(pcName),
+                               &oNFound) != SUCCESS)
+      return NO_SUCH_PATH;
+
+   FT_adjustCount(oFTree, 0, Node_free(oNFound));
+   return SUCCESS;
+}
+
+/*--------------------------------------------------------------------*/
+
+/*
+  Does the work of FT_getFileContentsOfIn. Takes no lock, and must be
+  called inside an epoch read-side section in the THREADSAFE build.
+*/
+static void *FT_getFileContentsOfLocked(FT_T oFTree,
+                                        const FT_File *psFile) {
+   Node_T oNFile;
+
+   assert(psFile != NULL);
+
+   oNFile = Node_resolveHandle(psFile->psEntry, psFile->ulGeneration,
+                               EPOCH_READ(oFTree->oNRoot));
+   if(oNFile == NULL)
+      return NULL;
+
+   return Node_data(oNFile);
+}
+
+/*--------------------------------------------------------------------*/
+
+static void *FT_replaceFileContentsOfLocked(FT_T oFTree,
+   const FT_File *psFile, void *pvNewContents, size_t ulNewLength,
+   Node_T *poNHeld) {
+   void *pvOldContents;
+
+   assert(psFile != NULL);
+   assert(poNHeld != NULL);
+
+   if(FT_lockHandle(oFTree, psFile->psEntry, psFile->ulGeneration,
+                    poNHeld) != SUCCESS)
+      return NULL;
+
+   pvOldContents = Node_data(*poNHeld);
+   Node_changeData(*poNHeld, pvNewContents, ulNewLength);
+   return pvOldContents;
+}
+
+/*--------------------------------------------------------------------*/
+
+/*
+  Does the work of FT_statOfIn. Takes no lock, and must be called
+  inside an epoch read-side section in the THREADSAFE build.
+*/
+static int FT_statOfLocked(FT_T oFTree, const FT_File *psFile,
+                           size_t *pulSize) {
+   Node_T oNFile;
+
+   assert(psFile != NULL);
+   assert(pulSize != NULL);
+
+   oNFile = Node_resolveHandle(psFile->psEntry, psFile->ulGeneration,
+                               EPOCH_READ(oFTree->oNRoot));
+   if(oNFile == NULL)
+      return NO_SUCH_PATH;
+
+   *pulSize = Node_len(oNFile);
+   return SUCCESS;
+}
+
+
+/* --------------------------------------------------------------------
+
+  The following auxiliary functions are used for generating the
+  string representation of the FT.
+*/
+
+/*
+  Returns the first directory among oNParent's children with
+  identifier ulChildID or greater, or NULL if there is none.
+*/
+static Node_T FT_nextDir(Node_T oNParent, size_t ulChildID) {
+   Node_T oNChild = NULL;
+
+   assert(oNParent != NULL);
+
+   for(; ulChildID < Node_getNumChildren(oNParent); ulChildID++) {
+      (void) Node_getChild(oNParent, ulChildID, &oNChild);
+      if(Node_type(oNChild) == FALSE)
+         return oNChild;
+   }
+   return NULL;
+}
+
+/*
+  Calls (*pfVisit)(oNNode, pvExtra) on every node of oFTree in the
+  order it is listed: depth first, with each directory followed by
+  its files and then by its subdirectories, and siblings of the same
+  type in lexicographic order.
+
+  The walk finds its way back up through parent links rather than a
+  stack or a list of nodes, so it takes constant extra memory.
+*/
+static void FT_walk(FT_T oFTree,
+                    void (*pfVisit)(Node_T oNNode, void *pvExtra),
+                    void *pvExtra) {
+   Node_T oNCurr;
+   Node_T oNNext = NULL;
+   size_t ulChildID;
+
+   assert(oFTree != NULL);
+   assert(pfVisit != NULL);
+
+   oNCurr = oFTree->oNRoot;
+   if(oNCurr == NULL)
+      return;
+
+   for(;;) {
+      /* list the directory, then its files */
+      (*pfVisit)(oNCurr, pvExtra);
+      for(ulChildID = 0; ulChildID < Node_getNumChildren(oNCurr);
+          ulChildID++) {
+         (void) Node_getChild(oNCurr, ulChildID, &oNNext);
+         if(Node_type(oNNext) == TRUE)
+            (*pfVisit)(oNNext, pvExtra);
+      }
+
+      /* go to its first subdirectory, or else to the next
+         subdirectory after the nearest ancestor that has one */
+      ulChildID = 0;
+      while((oNNext = FT_nextDir(oNCurr, ulChildID)) == NULL) {
+         if(oNCurr == oFTree->oNRoot)
+            return;
+         ulChildID = Node_getChildID(oNCurr) + 1;
+         oNCurr = Node_getParent(oNCurr);
+      }
+      oNCurr = oNNext;
+   }
+}
+
+/*
+  Alternate version of strlen that uses pulAcc as an in-out parameter
+  to accumulate a string length, rather than returning the length of
+  oNNode's path, and also always adds one addition byte to the sum.
 */
 static void FT_strlenAccumulate(Node_T oNNode, size_t *pulAcc) {
    assert(pulAcc != NULL);
 
    if(oNNode != NULL)
-      *pulAcc += (Path_getStrLength(Node_getPath(oNNode)) + 1);
+      *pulAcc += (Node_getPathLength(oNNode) + 1);
 }
 
 /*
-  Alternate version of strcat that inverts the typical argument
-  order, appending oNNode's path onto pcAcc, and also always adds one
-  newline at the end of the concatenated string.
+  Writes oNNode's path followed by a newline at *ppcCursor, and
+  advances *ppcCursor past them. Keeping the write position in the
+  cursor, rather than finding the end of the accumulated string again
+  with strcat, makes building the whole string linear in its length.
 */
-static void FT_strcatAccumulate(Node_T oNNode, char *pcAcc) {
-   assert(pcAcc != NULL);
+static void FT_writeAccumulate(Node_T oNNode, char **ppcCursor) {
+   size_t ulLength;
+
+   assert(ppcCursor != NULL);
 
    if(oNNode != NULL) {
-      strcat(pcAcc, Path_getPathname(Node_getPath(oNNode)));
-      strcat(pcAcc, "\n");
+      ulLength = Node_getPathLength(oNNode);
+      (void) Node_writePath(oNNode, *ppcCursor);
+      *ppcCursor += ulLength;
+      *(*ppcCursor)++ = '\n';
+   }
+}
+
+/* The size of the buffer FT_writeToFile fills between writes */
+enum { WRITE_BUFFER_SIZE = 8192 };
+
+/* The state of a dump in progress to a stream */
+struct Writer {
+   /* the stream being written */
+   FILE *psFile;
+   /* SUCCESS, or the status of the first failure */
+   int iStatus;
+   /* the number of characters in acBuffer not yet written */
+   size_t ulUsed;
+   /* listing text waiting to be written */
+   char acBuffer[WRITE_BUFFER_SIZE];
+};
+
+/*
+  Writes out any listing text buffered in psWriter, unless an earlier
+  write failed.
+*/
+static void FT_flushWriter(struct Writer *psWriter) {
+   assert(psWriter != NULL);
+
+   if(psWriter->iStatus == SUCCESS && psWriter->ulUsed != 0 &&
+      fwrite(psWriter->acBuffer, 1, psWriter->ulUsed,
+             psWriter->psFile) != psWriter->ulUsed)
+      psWriter->iStatus = IO_ERROR;
+   psWriter->ulUsed = 0;
+}
+
+/*
+  Adds oNNode's path followed by a newline to the listing psWriter is
+  writing, flushing the buffer first if they do not fit. A path too
+  long for the buffer at all is written through a temporary copy.
+*/
+static void FT_writeBuffered(Node_T oNNode, struct Writer *psWriter) {
+   size_t ulLength;
+   char *pcPath;
+
+   assert(oNNode != NULL);
+   assert(psWriter != NULL);
+
+   if(psWriter->iStatus != SUCCESS)
+      return;
+
+   ulLength = Node_getPathLength(oNNode) + 1;
+   if(ulLength > WRITE_BUFFER_SIZE - psWriter->ulUsed)
+      FT_flushWriter(psWriter);
+
+   if(ulLength <= WRITE_BUFFER_SIZE) {
+      (void) Node_writePath(oNNode,
+                            psWriter->acBuffer + psWriter->ulUsed);
+      psWriter->ulUsed += ulLength;
+      psWriter->acBuffer[psWriter->ulUsed - 1] = '\n';
+      return;
+   }
+
+   pcPath = Node_toString(oNNode);
+   if(pcPath == NULL) {
+      psWriter->iStatus = MEMORY_ERROR;
+      return;
    }
+   pcPath[ulLength - 1] = '\n';
+   if(fwrite(pcPath, 1, ulLength, psWriter->psFile) != ulLength)
+      psWriter->iStatus = IO_ERROR;
+   free(pcPath);
 }
 /*--------------------------------------------------------------------*/
 
-char *FT_toString(void) {
-   DynArray_T nodes;
+static char *FT_toStringLocked(FT_T oFTree) {
    size_t totalStrlen = 1;
    char *result = NULL;
+   char *pcCursor;
 
-   if(!bIsInitialized)
+   FT_walk(oFTree, (void (*)(Node_T, void *)) FT_strlenAccumulate,
+           (void *) &totalStrlen);
+
+   result = malloc(totalStrlen);
+   if(result == NULL)
       return NULL;
 
-   nodes = DynArray_new(ulCount);
-   (void) FT_preOrderTraversal(oNRoot, nodes, 0);
+   pcCursor = result;
+   FT_walk(oFTree, (void (*)(Node_T, void *)) FT_writeAccumulate,
+           (void *) &pcCursor);
+   *pcCursor = '\0';
 
-   DynArray_map(nodes, (void (*)(void *, void*)) FT_strlenAccumulate,
-                (void*) &totalStrlen);
+   return result;
+}
 
-   result = malloc(totalStrlen);
-   if(result == NULL) {
-      DynArray_free(nodes);
+/*--------------------------------------------------------------------*/
+
+static int FT_writeToFileLocked(FT_T oFTree, FILE *psFile) {
+   struct Writer sWriter;
+
+   assert(psFile != NULL);
+
+   sWriter.psFile = psFile;
+   sWriter.iStatus = SUCCESS;
+   sWriter.ulUsed = 0;
+
+   FT_walk(oFTree, (void (*)(Node_T, void *)) FT_writeBuffered,
+           (void *) &sWriter);
+   FT_flushWriter(&sWriter);
+
+   return sWriter.iStatus;
+}
+
+
+/*
+  Returns the number of leading components that the valid paths pcA
+  and pcB have in common.
+*/
+static size_t FT_sharedDepth(const char *pcA, const char *pcB) {
+   size_t ulDepth = 0;
+   size_t i;
+
+   assert(pcA != NULL);
+   assert(pcB != NULL);
+
+   for(i = 0; pcA[i] == pcB[i]; i++) {
+      if(pcA[i] == '\0')
+         return ulDepth + 1;
+      if(pcA[i] == '/')
+         ulDepth++;
+   }
+   /* the component before the mismatch counts if both end there */
+   if(i != 0 && (pcA[i] == '\0' || pcA[i] == '/') &&
+      (pcB[i] == '\0' || pcB[i] == '/'))
+      ulDepth++;
+   return ulDepth;
+}
+
+/*
+  Returns the deepest of oNPrev and its ancestors whose path is a
+  prefix of the valid path psView describes, or NULL if there is none
+  or oNPrev is NULL. pcPrev is a path of which oNPrev's is a prefix,
+  and pcPath is psView's. Advances *pulOffset and *pulComponent, as
+  PathView_nextComponent does, past the components of the node
+  returned, so the rest of the path can be followed down from it.
+*/
+static Node_T FT_resume(const struct PathView *psView,
+                        const char *pcPath, const char *pcPrev,
+                        Node_T oNPrev, size_t *pulOffset,
+                        size_t *pulComponent) {
+   Node_T oNCurr = NULL;
+   size_t ulShared;
+   size_t i;
+
+   assert(psView != NULL);
+   assert(pcPath != NULL);
+   assert(pulOffset != NULL);
+   assert(pulComponent != NULL);
+
+   if(oNPrev == NULL)
       return NULL;
+
+   /* climb from the previous node to the deepest ancestor the two
+      paths share, and skip its components */
+   ulShared = FT_sharedDepth(pcPrev, pcPath);
+   for(oNCurr = oNPrev; oNCurr != NULL &&
+          Node_getDepth(oNCurr) > ulShared;
+       oNCurr = Node_getParent(oNCurr))
+      ;
+   if(oNCurr != NULL)
+      for(i = 0; i < Node_getDepth(oNCurr); i++)
+         (void) PathView_nextComponent(psView, pulOffset,
+                                       pulComponent);
+   return oNCurr;
+}
+
+/*
+  Inserts pcPath into oFTree as FT_bulkLoadIn does, as a file with
+  contents pvContents of length ulLength if bIsFile, starting from the
+  node for the components it shares with pcPrev, the path loaded
+  before it, whose node is oNPrev; both are NULL for the first path.
+  Adds the number of nodes created to *pulAdded. Returns SUCCESS and
+  sets *poNLoaded to pcPath's node, or frees the nodes created for
+  pcPath, leaving oFTree unchanged, and returns the failing status.
+*/
+static int FT_bulkLoadPath(FT_T oFTree, const char *pcPath,
+                           boolean bIsFile, void *pvContents,
+                           size_t ulLength, const char *pcPrev,
+                           Node_T oNPrev, Node_T *poNLoaded,
+                           size_t *pulAdded) {
+   struct PathView sView;
+   const char *pcComponent;
+   const char *pcName;
+   Node_T oNCurr;
+   Node_T oNChild;
+   Node_T oNFirstNew = NULL;
+   size_t ulDepth;
+   size_t ulOffset = 0;
+   size_t ulComponent = 0;
+   boolean bLast;
+   int iStatus;
+
+   assert(oFTree != NULL);
+   assert(pcPath != NULL);
+   assert(poNLoaded != NULL);
+   assert(pulAdded != NULL);
+
+   iStatus = PathView_init(&sView, pcPath);
+   if(iStatus != SUCCESS)
+      return iStatus;
+   ulDepth = PathView_getDepth(&sView);
+
+   oNCurr = FT_resume(&sView, pcPath, pcPrev, oNPrev, &ulOffset,
+                      &ulComponent);
+
+   /* with nothing shared, start at the root, adding it if need be */
+   if(oNCurr == NULL) {
+      pcComponent = PathView_nextComponent(&sView, &ulOffset,
+                                           &ulComponent);
+      oNCurr = oFTree->oNRoot;
+      if(oNCurr == NULL) {
+         if(bIsFile)
+            return CONFLICTING_PATH;
+         iStatus = Node_newChild(NULL, oFTree->psArena, pcComponent,
+                                 ulComponent, FALSE, NULL, 0, &oNCurr);
+         if(iStatus == SUCCESS)
+            iStatus = FT_setRoot(oFTree, oNCurr);
+         if(iStatus != SUCCESS)
+            return iStatus;
+         oNFirstNew = oNCurr;
+         (*pulAdded)++;
+      }
+      else {
+         pcName = Node_getName(oNCurr);
+         if(Atom_getLength(pcName) != ulComponent ||
+            memcmp(pcName, pcComponent, ulComponent) != 0)
+            return CONFLICTING_PATH;
+         if(ulDepth == 1)
+            return ALREADY_IN_TREE;
+      }
+   }
+   else if(Node_getDepth(oNCurr) == ulDepth)
+      return ALREADY_IN_TREE;
+
+   /* add the remaining components, descending into those present */
+   while((pcComponent = PathView_nextComponent(&sView, &ulOffset,
+                                               &ulComponent)) != NULL) {
+      bLast = (boolean) (Node_getDepth(oNCurr) + 1 == ulDepth);
+      iStatus = Node_newChild(oNCurr, NULL, pcComponent, ulComponent,
+                              (boolean) (bLast && bIsFile),
+                              bLast ? pvContents : NULL,
+                              bLast ? ulLength : 0, &oNChild);
+      if(iStatus == SUCCESS) {
+         if(oNFirstNew == NULL)
+            oNFirstNew = oNChild;
+         (*pulAdded)++;
+      }
+      else if(iStatus != ALREADY_IN_TREE || bLast)
+         break;
+      oNCurr = oNChild;
+   }
+
+   /* as FT_insertDir and FT_insertFile do, add nothing on failure */
+   if(pcComponent != NULL) {
+      if(oNFirstNew != NULL) {
+         if(oNFirstNew == oFTree->oNRoot)
+            EPOCH_PUBLISH(oFTree->oNRoot, NULL);
+         *pulAdded -= Node_free(oNFirstNew);
+      }
+      return iStatus;
    }
-   *result = '\0';
 
-   DynArray_map(nodes, (void (*)(void *, void*)) FT_strcatAccumulate,
-                (void *) result);
+   *poNLoaded = oNCurr;
+   return SUCCESS;
+}
 
-   DynArray_free(nodes);
+/*--------------------------------------------------------------------*/
 
-   return result;
+static int FT_bulkLoadLocked(FT_T oFTree, const char **ppcPaths,
+                             const boolean *pbIsFile,
+                             void **ppvContents,
+                             const size_t *pulLengths, size_t ulCount) {
+   const char *pcPrev = NULL;
+   Node_T oNPrev = NULL;
+   size_t ulAdded = 0;
+   size_t i;
+   int iStatus = SUCCESS;
+
+   assert(ppcPaths != NULL || ulCount == 0);
+
+   for(i = 0; i < ulCount && iStatus == SUCCESS; i++) {
+      assert(ppcPaths[i] != NULL);
+      iStatus = FT_bulkLoadPath(oFTree, ppcPaths[i],
+                   (boolean) (pbIsFile != NULL && pbIsFile[i]),
+                   ppvContents != NULL ? ppvContents[i] : NULL,
+                   pulLengths != NULL ? pulLengths[i] : 0,
+                   pcPrev, oNPrev, &oNPrev, &ulAdded);
+      pcPrev = ppcPaths[i];
+   }
+   FT_adjustCount(oFTree, ulAdded, 0);
+
+   return iStatus;
+}
+
+/*
+  Finds the node with path pcPath in oFTree as FT_findNode does, with
+  the same statuses and BAD_PATH if pcPath is not well formatted, but
+  starting from the node for the components pcPath shares with pcPrev,
+  a path of which oNPrev's is a prefix; both may be NULL.
+*/
+static int FT_batchFind(FT_T oFTree, const char *pcPath,
+                        const char *pcPrev, Node_T oNPrev,
+                        Node_T *poNFound) {
+   struct PathView sView;
+   const char *pcComponent;
+   const char *pcName;
+   Node_T oNCurr;
+   size_t ulOffset = 0;
+   size_t ulComponent = 0;
+   int iStatus;
+
+   assert(oFTree != NULL);
+   assert(pcPath != NULL);
+   assert(poNFound != NULL);
+
+   iStatus = PathView_init(&sView, pcPath);
+   if(iStatus != SUCCESS)
+      return iStatus;
+
+   oNCurr = FT_resume(&sView, pcPath, pcPrev, oNPrev, &ulOffset,
+                      &ulComponent);
+   if(oNCurr == NULL) {
+      pcComponent = PathView_nextComponent(&sView, &ulOffset,
+                                           &ulComponent);
+      oNCurr = oFTree->oNRoot;
+      if(oNCurr == NULL)
+         return NO_SUCH_PATH;
+      pcName = Node_getName(oNCurr);
+      if(Atom_getLength(pcName) != ulComponent ||
+         memcmp(pcName, pcComponent, ulComponent) != 0)
+         return CONFLICTING_PATH;
+   }
+
+   while((pcComponent = PathView_nextComponent(&sView, &ulOffset,
+                                               &ulComponent)) != NULL)
+      if(Node_getChildByComponent(oNCurr, pcComponent, ulComponent,
+                                  &oNCurr) != SUCCESS)
+         return NO_SUCH_PATH;
+
+   *poNFound = oNCurr;
+   return SUCCESS;
+}
+
+/*
+  Applies *psOp to oFTree, as FT_applyBatchIn does, starting from the
+  node for the components its path shares with pcPrev, the path of the
+  operation before it, of which oNPrev's path is a prefix; both are
+  NULL for the first. Adds the numbers of nodes created and removed to
+  *pulAdded and *pulRemoved, and sets *poNNext to the deepest node
+  known to remain on psOp's path, or NULL. Returns psOp's status.
+*/
+static int FT_applyOp(FT_T oFTree, const FT_Op *psOp,
+                      const char *pcPrev, Node_T oNPrev,
+                      Node_T *poNNext, size_t *pulAdded,
+                      size_t *pulRemoved) {
+   Node_T oNFound = NULL;
+   boolean bIsFile;
+   int iStatus;
+
+   assert(oFTree != NULL);
+   assert(psOp != NULL);
+   assert(psOp->pcPath != NULL);
+   assert(poNNext != NULL);
+   assert(pulAdded != NULL);
+   assert(pulRemoved != NULL);
+
+   *poNNext = NULL;
+
+   if(psOp->eKind == FT_OP_INSERT_DIR ||
+      psOp->eKind == FT_OP_INSERT_FILE) {
+      bIsFile = (boolean) (psOp->eKind == FT_OP_INSERT_FILE);
+      return FT_bulkLoadPath(oFTree, psOp->pcPath, bIsFile,
+                             bIsFile ? psOp->pvContents : NULL,
+                             bIsFile ? psOp->ulLength : 0,
+                             pcPrev, oNPrev, poNNext, pulAdded);
+   }
+
+   iStatus = FT_batchFind(oFTree, psOp->pcPath, pcPrev, oNPrev,
+                          &oNFound);
+   if(iStatus != SUCCESS)
+      return iStatus;
+   *poNNext = oNFound;
+
+   switch(psOp->eKind) {
+      case FT_OP_RM_DIR:
+         if(Node_type(oNFound) == TRUE)
+            return NOT_A_DIRECTORY;
+         break;
+      case FT_OP_RM_FILE:
+         if(Node_type(oNFound) == FALSE)
+            return NOT_A_FILE;
+         break;
+      case FT_OP_REPLACE_CONTENTS:
+         if(Node_type(oNFound) == FALSE)
+            return NOT_A_FILE;
+         if(psOp->ppvOldContents != NULL)
+            *psOp->ppvOldContents = Node_data(oNFound);
+         Node_changeData(oNFound, psOp->pvContents, psOp->ulLength);
+         return SUCCESS;
+      default:
+         assert(FALSE);
+         return SUCCESS;
+   }
+
+   /* the removed node's parent stays, for the next operation */
+   *poNNext = Node_getParent(oNFound);
+   if(oNFound == oFTree->oNRoot)
+      EPOCH_PUBLISH(oFTree->oNRoot, NULL);
+   *pulRemoved += Node_free(oNFound);
+   return SUCCESS;
+}
+
+/* An operation of a batch, and the key that orders it by path */
+struct BatchEntry {
+   /* the operation's path with each '/' replaced by '\1' */
+   const char *pcKey;
+   const FT_Op *psOp;
+};
+
+/*
+  Compares the batch entries at pv1 and pv2 by key, so that, with '/'
+  ordered before every other character a path may hold, a directory's
+  descendants follow it directly. Entries with the same key keep the
+  order their operations have in the batch.
+*/
+static int FT_compareEntries(const void *pv1, const void *pv2) {
+   const struct BatchEntry *psEntry1 = pv1;
+   const struct BatchEntry *psEntry2 = pv2;
+   int iResult;
+
+   iResult = strcmp(psEntry1->pcKey, psEntry2->pcKey);
+   if(iResult != 0)
+      return iResult;
+   return psEntry1->psOp < psEntry2->psOp ? -1 :
+      psEntry1->psOp > psEntry2->psOp;
+}
+
+/*
+  Returns TRUE if the key pcA is a proper prefix of the key pcB that
+  ends where one of pcB's components does, so that pcA's path names
+  an ancestor of pcB's.
+*/
+static boolean FT_isAncestorKey(const char *pcA, const char *pcB) {
+   size_t ulLength;
+
+   assert(pcA != NULL);
+   assert(pcB != NULL);
+
+   ulLength = strlen(pcA);
+   return (boolean) (strncmp(pcA, pcB, ulLength) == 0 &&
+                     pcB[ulLength] == '\1');
+}
+
+/*
+  Returns a new array of entries for the ulCount operations at psOps in
+  the order FT_applyBatchIn applies them, or NULL if memory could not
+  be allocated. They are sorted by path when that cannot change any
+  result: when no operation's path is a prefix of another's, so none
+  can create or remove a node another one reaches, and all the paths
+  share their root, so the first cannot decide which root another one
+  finds. Otherwise, as when a path holds a '\1' that its key could not
+  tell from a '/', they are left in the order given.
+*/
+static struct BatchEntry *FT_orderOps(const FT_Op *psOps,
+                                      size_t ulCount) {
+   struct BatchEntry *psOrder;
+   char *pcKey;
+   char *pcSlash;
+   size_t ulKeys = 0;
+   size_t ulLength;
+   size_t ulRoot;
+   size_t i;
+   boolean bSortable = TRUE;
+
+   assert(psOps != NULL || ulCount == 0);
+
+   for(i = 0; i < ulCount; i++)
+      ulKeys += strlen(psOps[i].pcPath) + 1;
+   psOrder = malloc(ulCount * sizeof(struct BatchEntry) + ulKeys);
+   if(psOrder == NULL)
+      return NULL;
+
+   /* the keys follow the entries in the same block */
+   pcKey = (char *) (psOrder + ulCount);
+   for(i = 0; i < ulCount; i++) {
+      psOrder[i].pcKey = pcKey;
+      psOrder[i].psOp = &psOps[i];
+      ulLength = strlen(psOps[i].pcPath);
+      if(memchr(psOps[i].pcPath, '\1', ulLength) != NULL)
+         bSortable = FALSE;
+      memcpy(pcKey, psOps[i].pcPath, ulLength + 1);
+      for(pcSlash = strchr(pcKey, '/'); pcSlash != NULL;
+          pcSlash = strchr(pcSlash + 1, '/'))
+         *pcSlash = '\1';
+      pcKey += ulLength + 1;
+   }
+   if(ulCount < 2 || !bSortable)
+      return psOrder;
+
+   qsort(psOrder, ulCount, sizeof(struct BatchEntry),
+         FT_compareEntries);
+
+   /* sorted, a path any other has as a prefix is next to such a one */
+   ulRoot = strcspn(psOrder[0].pcKey, "\1");
+   for(i = 1; i < ulCount; i++)
+      if(FT_isAncestorKey(psOrder[i - 1].pcKey, psOrder[i].pcKey) ||
+         strncmp(psOrder[i].pcKey, psOrder[0].pcKey, ulRoot) != 0 ||
+         (psOrder[i].pcKey[ulRoot] != '\1' &&
+          psOrder[i].pcKey[ulRoot] != '\0'))
+         break;
+   if(i == ulCount)
+      return psOrder;
+
+   for(i = 0; i < ulCount; i++)
+      psOrder[i].psOp = &psOps[i];
+   return psOrder;
+}
+
+/*--------------------------------------------------------------------*/
+
+static int FT_applyBatchLocked(FT_T oFTree, const FT_Op *psOps,
+                               size_t ulCount, int *piResults) {
+   struct BatchEntry *psOrder;
+   const FT_Op *psOp;
+   const char *pcPrev = NULL;
+   Node_T oNPrev = NULL;
+   size_t ulAdded = 0;
+   size_t ulRemoved = 0;
+   size_t ulFirstFailed = ulCount;
+   size_t i;
+
+   assert(psOps != NULL || ulCount == 0);
+   assert(piResults != NULL || ulCount == 0);
+
+   /* without memory to sort, apply the operations as given */
+   psOrder = FT_orderOps(psOps, ulCount);
+
+   for(i = 0; i < ulCount; i++) {
+      psOp = psOrder != NULL ? psOrder[i].psOp : &psOps[i];
+      piResults[psOp - psOps] = FT_applyOp(oFTree, psOp, pcPrev, oNPrev,
+                                           &oNPrev, &ulAdded,
+                                           &ulRemoved);
+      pcPrev = psOp->pcPath;
+      if(piResults[psOp - psOps] != SUCCESS &&
+         (size_t) (psOp - psOps) < ulFirstFailed)
+         ulFirstFailed = (size_t) (psOp - psOps);
+   }
+   FT_adjustCount(oFTree, ulAdded, ulRemoved);
+   free(psOrder);
+
+   return ulFirstFailed == ulCount ? SUCCESS : piResults[ulFirstFailed];
+}
+
+
+/* --------------------------------------------------------------------
+
+  The FT_*In functions take oFTree's lock around the corresponding
+  FT_*Locked call: exclusively to add or remove the root, to list
+  the tree, or to detach a subtree whole, and shared otherwise, with
+  node locks doing the rest.
+
+-------------------------------------------------------------------- */
+
+/*
+  Returns a new, empty FT whose nodes come from its arena if bArena is
+  TRUE, or NULL if memory could not be allocated.
+*/
+static FT_T FT_create(boolean bArena) {
+   FT_T oFTree;
+   struct Arena sEmpty = ARENA_INITIALIZER;
+
+   oFTree = malloc(sizeof(struct FT));
+   if(oFTree == NULL)
+      return NULL;
+
+   oFTree->oNRoot = NULL;
+   oFTree->ulCount = 0;
+   oFTree->sArena = sEmpty;
+   oFTree->psArena = bArena ? &oFTree->sArena : NULL;
+   oFTree->psPaths = NULL;
+   oFTree->psFilter = NULL;
+   oFTree->psDirs = NULL;
+   oFTree->psHandles = NULL;
+#ifdef THREADSAFE
+   if(pthread_rwlock_init(&oFTree->sLock, NULL) != 0) {
+      free(oFTree);
+      return NULL;
+   }
+   if(pthread_mutex_init(&oFTree->sCountLock, NULL) != 0) {
+      (void) pthread_rwlock_destroy(&oFTree->sLock);
+      free(oFTree);
+      return NULL;
+   }
+#endif
+
+   return oFTree;
+}
+
+/*
+  Frees every node of oFTree and leaves it empty. A tree in an arena
+  is freed by releasing the arena, once nothing can still reach its
+  nodes; their locks are not destroyed one by one, which no
+  implementation this builds on requires of an unlocked lock. Returns
+  the number of nodes freed.
+*/
+static size_t FT_clear(FT_T oFTree) {
+   size_t ulFreed = 0;
+
+   assert(oFTree != NULL);
+
+   if(oFTree->oNRoot != NULL) {
+      if(oFTree->psArena != NULL)
+         ulFreed = oFTree->ulCount;
+      else
+         ulFreed = Node_free(oFTree->oNRoot);
+      oFTree->oNRoot = NULL;
+   }
+   /* return the nodes' memory before returning, including that of
+      subtrees removed by FT_rmDirLaterIn */
+   Node_waitForReclaimer();
+   Epoch_barrier();
+   if(oFTree->psArena != NULL)
+      Arena_release(oFTree->psArena);
+   Node_freePathIndex(oFTree->psPaths);
+   oFTree->psPaths = NULL;
+   Node_freePathFilter(oFTree->psFilter);
+   oFTree->psFilter = NULL;
+   Node_freeDirCache(oFTree->psDirs);
+   oFTree->psDirs = NULL;
+   Node_freeHandleTable(oFTree->psHandles);
+   oFTree->psHandles = NULL;
+
+   return ulFreed;
+}
+
+FT_T FT_new(void) {
+   return FT_create(FALSE);
+}
+
+FT_T FT_newArena(void) {
+   return FT_create(TRUE);
+}
+
+/*--------------------------------------------------------------------*/
+
+void FT_free(FT_T oFTree) {
+   if(oFTree == NULL)
+      return;
+
+   (void) FT_clear(oFTree);
+#ifdef THREADSAFE
+   (void) pthread_mutex_destroy(&oFTree->sCountLock);
+   (void) pthread_rwlock_destroy(&oFTree->sLock);
+#endif
+   free(oFTree);
+}
+
+/*--------------------------------------------------------------------*/
+
+int FT_insertDirIn(FT_T oFTree, const char *pcPath) {
+   Node_T oNHeld = NULL;
+   int iStatus;
+
+   /* only an insert into an empty FT adds the root */
+   FT_lockShared(oFTree);
+   if(oFTree->oNRoot == NULL) {
+      FT_unlock(oFTree);
+      FT_lockExclusive(oFTree);
+   }
+   iStatus = FT_insertDirLocked(oFTree, pcPath, &oNHeld);
+   FT_release(oFTree, oNHeld);
+   return iStatus;
+}
+
+/*--------------------------------------------------------------------*/
+
+boolean FT_containsDirIn(FT_T oFTree, const char *pcPath) {
+   Node_T oNHeld = NULL;
+   boolean bResult;
+
+   /* look up without locks, unless this thread cannot take part in
+      the epoch scheme */
+   if(Epoch_enter()) {
+      bResult = FT_containsDirLocked(oFTree, pcPath, NULL);
+      Epoch_exit();
+      return bResult;
+   }
+   FT_lockShared(oFTree);
+   bResult = FT_containsDirLocked(oFTree, pcPath, &oNHeld);
+   FT_release(oFTree, oNHeld);
+   return bResult;
+}
+
+/*--------------------------------------------------------------------*/
+
+int FT_rmDirIn(FT_T oFTree, const char *pcPath) {
+   Node_T oNHeld = NULL;
+   int iStatus;
+
+   assert(pcPath != NULL);
+
+   /* only a path of one component can name the root */
+   if(strchr(pcPath, '/') == NULL)
+      FT_lockExclusive(oFTree);
+   else
+      FT_lockShared(oFTree);
+   iStatus = FT_rmDirLocked(oFTree, pcPath, FALSE, &oNHeld);
+   FT_release(oFTree, oNHeld);
+   return iStatus;
+}
+
+/*--------------------------------------------------------------------*/
+
+int FT_rmDirLaterIn(FT_T oFTree, const char *pcPath) {
+   Node_T oNHeld = NULL;
+   int iStatus;
+
+   /* the subtree's size is read while no other change can be inside
+      it, which only waits for the changes already under way */
+   FT_lockExclusive(oFTree);
+   iStatus = FT_rmDirLocked(oFTree, pcPath, TRUE, &oNHeld);
+   FT_release(oFTree, oNHeld);
+   return iStatus;
+}
+
+/*--------------------------------------------------------------------*/
+
+int FT_insertFileIn(FT_T oFTree, const char *pcPath, void *pvContents,
+                    size_t ulLength) {
+   Node_T oNHeld = NULL;
+   int iStatus;
+
+   FT_lockShared(oFTree);
+   iStatus = FT_insertFileLocked(oFTree, pcPath, pvContents, ulLength,
+                                 &oNHeld);
+   FT_release(oFTree, oNHeld);
+   return iStatus;
+}
+
+/*--------------------------------------------------------------------*/
+
+boolean FT_containsFileIn(FT_T oFTree, const char *pcPath) {
+   Node_T oNHeld = NULL;
+   boolean bResult;
+
+   if(Epoch_enter()) {
+      bResult = FT_containsFileLocked(oFTree, pcPath, NULL);
+      Epoch_exit();
+      return bResult;
+   }
+   FT_lockShared(oFTree);
+   bResult = FT_containsFileLocked(oFTree, pcPath, &oNHeld);
+   FT_release(oFTree, oNHeld);
+   return bResult;
+}
+
+/*--------------------------------------------------------------------*/
+
+int FT_rmFileIn(FT_T oFTree, const char *pcPath) {
+   Node_T oNHeld = NULL;
+   int iStatus;
+
+   FT_lockShared(oFTree);
+   iStatus = FT_rmFileLocked(oFTree, pcPath, &oNHeld);
+   FT_release(oFTree, oNHeld);
+   return iStatus;
+}
+
+/*--------------------------------------------------------------------*/
+
+void *FT_getFileContentsIn(FT_T oFTree, const char *pcPath) {
+   Node_T oNHeld = NULL;
+   void *pvContents;
+
+   if(Epoch_enter()) {
+      pvContents = FT_getFileContentsLocked(oFTree, pcPath, NULL);
+      Epoch_exit();
+      return pvContents;
+   }
+   FT_lockShared(oFTree);
+   pvContents = FT_getFileContentsLocked(oFTree, pcPath, &oNHeld);
+   FT_release(oFTree, oNHeld);
+   return pvContents;
+}
+
+/*--------------------------------------------------------------------*/
+
+void *FT_replaceFileContentsIn(FT_T oFTree, const char *pcPath,
+                               void *pvNewContents, size_t ulNewLength) {
+   Node_T oNHeld = NULL;
+   void *pvOldContents;
+
+   FT_lockShared(oFTree);
+   pvOldContents = FT_replaceFileContentsLocked(oFTree, pcPath,
+                                                pvNewContents,
+                                                ulNewLength, &oNHeld);
+   FT_release(oFTree, oNHeld);
+   return pvOldContents;
+}
+
+/*--------------------------------------------------------------------*/
+
+int FT_statIn(FT_T oFTree, const char *pcPath, boolean *pbIsFile,
+              size_t *pulSize) {
+   Node_T oNHeld = NULL;
+   int iStatus;
+
+   if(Epoch_enter()) {
+      iStatus = FT_statLocked(oFTree, pcPath, pbIsFile, pulSize, NULL);
+      Epoch_exit();
+      return iStatus;
+   }
+   FT_lockShared(oFTree);
+   iStatus = FT_statLocked(oFTree, pcPath, pbIsFile, pulSize, &oNHeld);
+   FT_release(oFTree, oNHeld);
+   return iStatus;
+}
+
+/*--------------------------------------------------------------------*/
+
+char *FT_toStringIn(FT_T oFTree) {
+   char *pcResult;
+
+   FT_lockExclusive(oFTree);
+   pcResult = FT_toStringLocked(oFTree);
+   FT_unlock(oFTree);
+   return pcResult;
+}
+
+/*--------------------------------------------------------------------*/
+
+int FT_writeToFileIn(FT_T oFTree, FILE *psFile) {
+   int iStatus;
+
+   FT_lockExclusive(oFTree);
+   iStatus = FT_writeToFileLocked(oFTree, psFile);
+   FT_unlock(oFTree);
+   return iStatus;
+}
+
+
+/*--------------------------------------------------------------------*/
+
+int FT_bulkLoadIn(FT_T oFTree, const char **ppcPaths,
+                  const boolean *pbIsFile, void **ppvContents,
+                  const size_t *pulLengths, size_t ulCount) {
+   int iStatus;
+
+   /* nodes are added without node locks, and the root may be */
+   FT_lockExclusive(oFTree);
+   iStatus = FT_bulkLoadLocked(oFTree, ppcPaths, pbIsFile, ppvContents,
+                               pulLengths, ulCount);
+   FT_unlock(oFTree);
+   return iStatus;
+}
+
+/*--------------------------------------------------------------------*/
+
+int FT_applyBatchIn(FT_T oFTree, const FT_Op *psOps, size_t ulCount,
+                    int *piResults) {
+   int iStatus;
+
+   /* one lock for the whole batch, which may add or remove the root */
+   FT_lockExclusive(oFTree);
+   iStatus = FT_applyBatchLocked(oFTree, psOps, ulCount, piResults);
+   FT_unlock(oFTree);
+   return iStatus;
+}
+
+
+/*--------------------------------------------------------------------*/
+
+int FT_indexPathsIn(FT_T oFTree) {
+   struct PathIndex *psPaths;
+   int iStatus = SUCCESS;
+
+   /* every node is added, so nothing may change meanwhile */
+   FT_lockExclusive(oFTree);
+   if(oFTree->psPaths == NULL) {
+      psPaths = Node_newPathIndex();
+      if(psPaths == NULL)
+         iStatus = MEMORY_ERROR;
+      else if(oFTree->oNRoot != NULL &&
+              Node_indexPaths(oFTree->oNRoot, psPaths) != SUCCESS) {
+         Node_freePathIndex(psPaths);
+         iStatus = MEMORY_ERROR;
+      }
+      else
+         EPOCH_PUBLISH(oFTree->psPaths, psPaths);
+   }
+   FT_unlock(oFTree);
+   return iStatus;
+}
+
+/*--------------------------------------------------------------------*/
+
+int FT_filterPathsIn(FT_T oFTree, size_t ulPaths, double dRate) {
+   struct PathFilter *psFilter;
+   int iStatus = SUCCESS;
+
+   /* every node is counted, so nothing may change meanwhile */
+   FT_lockExclusive(oFTree);
+   if(oFTree->psFilter == NULL) {
+      psFilter = Node_newPathFilter(ulPaths, dRate);
+      if(psFilter == NULL)
+         iStatus = MEMORY_ERROR;
+      else {
+         if(oFTree->oNRoot != NULL)
+            Node_filterPaths(oFTree->oNRoot, psFilter);
+         EPOCH_PUBLISH(oFTree->psFilter, psFilter);
+      }
+   }
+   FT_unlock(oFTree);
+   return iStatus;
+}
+
+/*--------------------------------------------------------------------*/
+
+int FT_cacheDirsIn(FT_T oFTree, size_t ulSlots) {
+   struct DirCache *psDirs;
+   int iStatus = SUCCESS;
+
+   FT_lockExclusive(oFTree);
+   if(oFTree->psDirs == NULL) {
+      psDirs = Node_newDirCache(ulSlots);
+      if(psDirs == NULL)
+         iStatus = MEMORY_ERROR;
+      else {
+         if(oFTree->oNRoot != NULL)
+            Node_cacheDirs(oFTree->oNRoot, psDirs);
+         EPOCH_PUBLISH(oFTree->psDirs, psDirs);
+      }
+   }
+   FT_unlock(oFTree);
+   return iStatus;
+}
+
+/*--------------------------------------------------------------------*/
+
+int FT_getCacheStatsIn(FT_T oFTree, size_t *pulHits,
+                       size_t *pulMisses) {
+   assert(pulHits != NULL);
+   assert(pulMisses != NULL);
+
+   *pulHits = 0;
+   *pulMisses = 0;
+   FT_lockShared(oFTree);
+   if(oFTree->psDirs != NULL)
+      Node_getDirCacheStats(oFTree->psDirs, pulHits, pulMisses);
+   FT_unlock(oFTree);
+   return SUCCESS;
+}
+
+/*--------------------------------------------------------------------*/
+
+int FT_openDirIn(FT_T oFTree, const char *pcPath, FT_Dir *psDir) {
+   Node_T oNHeld = NULL;
+   int iStatus;
+
+   /* only the first handle adds the table */
+   FT_lockShared(oFTree);
+   if(oFTree->psHandles == NULL) {
+      FT_unlock(oFTree);
+      FT_lockExclusive(oFTree);
+   }
+   iStatus = FT_openLocked(oFTree, pcPath, FALSE, &psDir->psEntry,
+                           &psDir->ulGeneration, &oNHeld);
+   FT_release(oFTree, oNHeld);
+   return iStatus;
+}
+
+/*--------------------------------------------------------------------*/
+
+int FT_insertFileAtIn(FT_T oFTree, const FT_Dir *psDir,
+                      const char *pcName, void *pvContents,
+                      size_t ulLength) {
+   Node_T oNHeld = NULL;
+   int iStatus;
+
+   FT_lockShared(oFTree);
+   iStatus = FT_insertFileAtLocked(oFTree, psDir, pcName, pvContents,
+                                   ulLength, &oNHeld);
+   FT_release(oFTree, oNHeld);
+   return iStatus;
+}
+
+/*--------------------------------------------------------------------*/
+
+boolean FT_containsAtIn(FT_T oFTree, const FT_Dir *psDir,
+                        const char *pcName) {
+   boolean bResult;
+
+   /* the directory is reached through its handle without locks, so a
+      thread that cannot take part in the epoch scheme cannot look */
+   if(!Epoch_enter())
+      return FALSE;
+   bResult = FT_containsAtLocked(oFTree, psDir, pcName);
+   Epoch_exit();
+   return bResult;
+}
+
+/*--------------------------------------------------------------------*/
+
+int FT_rmAtIn(FT_T oFTree, const FT_Dir *psDir, const char *pcName) {
+   Node_T oNHeld = NULL;
+   int iStatus;
+
+   FT_lockShared(oFTree);
+   iStatus = FT_rmAtLocked(oFTree, psDir, pcName, &oNHeld);
+   FT_release(oFTree, oNHeld);
+   return iStatus;
+}
+
+/*--------------------------------------------------------------------*/
+
+int FT_openFileIn(FT_T oFTree, const char *pcPath, FT_File *psFile) {
+   Node_T oNHeld = NULL;
+   int iStatus;
+
+   /* only the first handle adds the table */
+   FT_lockShared(oFTree);
+   if(oFTree->psHandles == NULL) {
+      FT_unlock(oFTree);
+      FT_lockExclusive(oFTree);
+   }
+   iStatus = FT_openLocked(oFTree, pcPath, TRUE, &psFile->psEntry,
+                           &psFile->ulGeneration, &oNHeld);
+   FT_release(oFTree, oNHeld);
+   return iStatus;
+}
+
+/*--------------------------------------------------------------------*/
+
+void *FT_getFileContentsOfIn(FT_T oFTree, const FT_File *psFile) {
+   void *pvContents;
+
+   /* as in FT_containsAtIn, the file is reached without locks */
+   if(!Epoch_enter())
+      return NULL;
+   pvContents = FT_getFileContentsOfLocked(oFTree, psFile);
+   Epoch_exit();
+   return pvContents;
+}
+
+/*--------------------------------------------------------------------*/
+
+void *FT_replaceFileContentsOfIn(FT_T oFTree, const FT_File *psFile,
+                                 void *pvNewContents,
+                                 size_t ulNewLength) {
+   Node_T oNHeld = NULL;
+   void *pvOldContents;
+
+   FT_lockShared(oFTree);
+   pvOldContents = FT_replaceFileContentsOfLocked(oFTree, psFile,
+                                                  pvNewContents,
+                                                  ulNewLength, &oNHeld);
+   FT_release(oFTree, oNHeld);
+   return pvOldContents;
+}
+
+/*--------------------------------------------------------------------*/
+
+int FT_statOfIn(FT_T oFTree, const FT_File *psFile, size_t *pulSize) {
+   int iStatus;
+
+   if(!Epoch_enter())
+      return MEMORY_ERROR;
+   iStatus = FT_statOfLocked(oFTree, psFile, pulSize);
+   Epoch_exit();
+   return iStatus;
+}
+
+
+/* --------------------------------------------------------------------
+
+  The functions below keep the original single-tree interface: each
+  checks that the default FT is initialized and forwards to the
+  corresponding function above.
+
+-------------------------------------------------------------------- */
+
+int FT_insertDir(const char *pcPath) {
+   if(!bIsInitialized)
+      return INITIALIZATION_ERROR;
+   return FT_insertDirIn(&sDefault, pcPath);
+}
+
+/*--------------------------------------------------------------------*/
+
+boolean FT_containsDir(const char *pcPath) {
+   if(!bIsInitialized)
+      return FALSE;
+   return FT_containsDirIn(&sDefault, pcPath);
+}
+
+/*--------------------------------------------------------------------*/
+
+int FT_rmDir(const char *pcPath) {
+   if(!bIsInitialized)
+      return INITIALIZATION_ERROR;
+   return FT_rmDirIn(&sDefault, pcPath);
+}
+
+/*--------------------------------------------------------------------*/
+
+int FT_rmDirLater(const char *pcPath) {
+   if(!bIsInitialized)
+      return INITIALIZATION_ERROR;
+   return FT_rmDirLaterIn(&sDefault, pcPath);
+}
+
+/*--------------------------------------------------------------------*/
+
+int FT_insertFile(const char *pcPath, void *pvContents,
+                  size_t ulLength) {
+   if(!bIsInitialized)
+      return INITIALIZATION_ERROR;
+   return FT_insertFileIn(&sDefault, pcPath, pvContents, ulLength);
+}
+
+/*--------------------------------------------------------------------*/
+
+boolean FT_containsFile(const char *pcPath) {
+   if(!bIsInitialized)
+      return FALSE;
+   return FT_containsFileIn(&sDefault, pcPath);
+}
+
+/*--------------------------------------------------------------------*/
+
+int FT_rmFile(const char *pcPath) {
+   if(!bIsInitialized)
+      return INITIALIZATION_ERROR;
+   return FT_rmFileIn(&sDefault, pcPath);
+}
+
+/*--------------------------------------------------------------------*/
+
+void *FT_getFileContents(const char *pcPath) {
+   if(!bIsInitialized)
+      return NULL;
+   return FT_getFileContentsIn(&sDefault, pcPath);
+}
+
+/*--------------------------------------------------------------------*/
+
+void *FT_replaceFileContents(const char *pcPath, void *pvNewContents,
+                             size_t ulNewLength) {
+   if(!bIsInitialized)
+      return NULL;
+   return FT_replaceFileContentsIn(&sDefault, pcPath, pvNewContents,
+                                   ulNewLength);
+}
+
+/*--------------------------------------------------------------------*/
+
+int FT_stat(const char *pcPath, boolean *pbIsFile, size_t *pulSize) {
+   if(!bIsInitialized)
+      return INITIALIZATION_ERROR;
+   return FT_statIn(&sDefault, pcPath, pbIsFile, pulSize);
+}
+
+/*--------------------------------------------------------------------*/
+
+/*
+  Sets the default FT to an initialized, empty state, with its nodes
+  in its arena if bArena is TRUE.
+*/
+static int FT_initDefault(boolean bArena) {
+   if(bIsInitialized)
+      return INITIALIZATION_ERROR;
+
+   bIsInitialized = TRUE;
+   sDefault.oNRoot = NULL;
+   sDefault.ulCount = 0;
+   sDefault.psArena = bArena ? &sDefault.sArena : NULL;
+
+   return SUCCESS;
+}
+
+int FT_init(void) {
+   return FT_initDefault(FALSE);
+}
+
+/*--------------------------------------------------------------------*/
+
+int FT_initArena(void) {
+   return FT_initDefault(TRUE);
+}
+
+/*--------------------------------------------------------------------*/
+
+int FT_destroy(void) {
+   if(!bIsInitialized)
+      return INITIALIZATION_ERROR;
+
+   sDefault.ulCount -= FT_clear(&sDefault);
+
+   bIsInitialized = FALSE;
+
+   return SUCCESS;
+}
+
+/*--------------------------------------------------------------------*/
+
+char *FT_toString(void) {
+   if(!bIsInitialized)
+      return NULL;
+   return FT_toStringIn(&sDefault);
+}
+
+/*--------------------------------------------------------------------*/
+
+int FT_writeToFile(FILE *psFile) {
+   assert(psFile != NULL);
+
+   if(!bIsInitialized)
+      return INITIALIZATION_ERROR;
+   return FT_writeToFileIn(&sDefault, psFile);
+}
+
+/*--------------------------------------------------------------------*/
+
+int FT_bulkLoad(const char **ppcPaths, const boolean *pbIsFile,
+                void **ppvContents, const size_t *pulLengths,
+                size_t ulCount) {
+   if(!bIsInitialized)
+      return INITIALIZATION_ERROR;
+   return FT_bulkLoadIn(&sDefault, ppcPaths, pbIsFile, ppvContents,
+                        pulLengths, ulCount);
+}
+
+/*--------------------------------------------------------------------*/
+
+int FT_applyBatch(const FT_Op *psOps, size_t ulCount, int *piResults) {
+   if(!bIsInitialized)
+      return INITIALIZATION_ERROR;
+   return FT_applyBatchIn(&sDefault, psOps, ulCount, piResults);
+}
+
+/*--------------------------------------------------------------------*/
+
+int FT_indexPaths(void) {
+   if(!bIsInitialized)
+      return INITIALIZATION_ERROR;
+   return FT_indexPathsIn(&sDefault);
+}
+
+/*--------------------------------------------------------------------*/
+
+int FT_filterPaths(size_t ulPaths, double dRate) {
+   if(!bIsInitialized)
+      return INITIALIZATION_ERROR;
+   return FT_filterPathsIn(&sDefault, ulPaths, dRate);
+}
+
+/*--------------------------------------------------------------------*/
+
+int FT_cacheDirs(size_t ulSlots) {
+   if(!bIsInitialized)
+      return INITIALIZATION_ERROR;
+   return FT_cacheDirsIn(&sDefault, ulSlots);
+}
+
+/*--------------------------------------------------------------------*/
+
+int FT_getCacheStats(size_t *pulHits, size_t *pulMisses) {
+   if(!bIsInitialized)
+      return INITIALIZATION_ERROR;
+   return FT_getCacheStatsIn(&sDefault, pulHits, pulMisses);
+}
+
+/*--------------------------------------------------------------------*/
+
+int FT_openDir(const char *pcPath, FT_Dir *psDir) {
+   if(!bIsInitialized)
+      return INITIALIZATION_ERROR;
+   return FT_openDirIn(&sDefault, pcPath, psDir);
+}
+
+/*--------------------------------------------------------------------*/
+
+int FT_insertFileAt(const FT_Dir *psDir, const char *pcName,
+                    void *pvContents, size_t ulLength) {
+   if(!bIsInitialized)
+      return INITIALIZATION_ERROR;
+   return FT_insertFileAtIn(&sDefault, psDir, pcName, pvContents,
+                            ulLength);
+}
+
+/*--------------------------------------------------------------------*/
+
+boolean FT_containsAt(const FT_Dir *psDir, const char *pcName) {
+   if(!bIsInitialized)
+      return FALSE;
+   return FT_containsAtIn(&sDefault, psDir, pcName);
+}
+
+/*--------------------------------------------------------------------*/
+
+int FT_rmAt(const FT_Dir *psDir, const char *pcName) {
+   if(!bIsInitialized)
+      return INITIALIZATION_ERROR;
+   return FT_rmAtIn(&sDefault, psDir, pcName);
+}
+
+/*--------------------------------------------------------------------*/
+
+int FT_openFile(const char *pcPath, FT_File *psFile) {
+   if(!bIsInitialized)
+      return INITIALIZATION_ERROR;
+   return FT_openFileIn(&sDefault, pcPath, psFile);
+}
+
+/*--------------------------------------------------------------------*/
+
+void *FT_getFileContentsOf(const FT_File *psFile) {
+   if(!bIsInitialized)
+      return NULL;
+   return FT_getFileContentsOfIn(&sDefault, psFile);
+}
+
+/*--------------------------------------------------------------------*/
+
+void *FT_replaceFileContentsOf(const FT_File *psFile,
+                               void *pvNewContents, size_t ulNewLength) {
+   if(!bIsInitialized)
+      return NULL;
+   return FT_replaceFileContentsOfIn(&sDefault, psFile, pvNewContents,
+                                     ulNewLength);
+}
+
+/*--------------------------------------------------------------------*/
+
+int FT_statOf(const FT_File *psFile, size_t *pulSize) {
+   if(!bIsInitialized)
+      return INITIALIZATION_ERROR;
+   return FT_statOfIn(&sDefault, psFile, pulSize);
 }
@@ -13,8 +13,138 @@
 */
 
 #include <stddef.h>
+#include <stdio.h>
 #include "a4def.h"
 
+/*
+  A FT_T is a handle to one independent File Tree. The functions whose
+  names end in In work on the FT_T they are given; the others work on
+  a single default FT that FT_init and FT_destroy set up and tear down.
+  Distinct FT_Ts share no state apart from the atom table that interns
+  path components.
+
+  When compiled with THREADSAFE defined, any of these functions may be
+  called from any thread, except that FT_new, FT_free, FT_init and
+  FT_destroy must not run concurrently with another call on the same
+  FT. Inserts and removals block only changes that pass through the
+  directories they change. Adding or removing the root, and the
+  rmDirLater, toString and writeToFile functions, lock out every
+  other change to the FT.
+  The containsDir, containsFile, getFileContents and stat functions
+  take no lock (see epoch.h), and removed nodes are freed only once no
+  such call can still reach them. FT_free and FT_destroy wait for that
+  before returning.
+*/
+typedef struct FT *FT_T;
+
+/*
+  One change in a batch passed to FT_applyBatch: eKind names the
+  function to apply to absolute path pcPath. pvContents and ulLength
+  are used only by FT_OP_INSERT_FILE and FT_OP_REPLACE_CONTENTS;
+  FT_OP_REPLACE_CONTENTS stores the old contents in *ppvOldContents
+  unless ppvOldContents is NULL.
+*/
+enum FT_OpKind { FT_OP_INSERT_DIR, FT_OP_INSERT_FILE, FT_OP_RM_DIR,
+                 FT_OP_RM_FILE, FT_OP_REPLACE_CONTENTS };
+
+typedef struct FT_Op {
+   enum FT_OpKind eKind;
+   const char *pcPath;
+   void *pvContents;
+   size_t ulLength;
+   void **ppvOldContents;
+} FT_Op;
+
+/*
+  A handle to a directory of a FT, filled in by FT_openDir, through
+  which the FT_*At functions reach its children without a path lookup.
+  A handle whose fields are all 0 or NULL is to no directory. A handle
+  may be copied, needs no closing, and goes stale once its directory
+  is removed, even if another is inserted at the same path. It must
+  not be used after the FT is freed or destroyed, or with another FT.
+*/
+struct NodeHandle;
+
+typedef struct FT_Dir {
+   struct NodeHandle *psEntry;
+   size_t ulGeneration;
+} FT_Dir;
+
+/*
+  A handle to a file of a FT, filled in by FT_openFile, through which
+  the FT_*Of functions reach the file without a path lookup. It is
+  copied, zeroed and goes stale as a FT_Dir does, once its file is
+  removed, directly or with a directory above it.
+*/
+typedef struct FT_File {
+   struct NodeHandle *psEntry;
+   size_t ulGeneration;
+} FT_File;
+
+/*
+  Returns a new, empty FT, or NULL if memory could not be allocated.
+  The new FT is in an initialized state and must be freed by FT_free.
+*/
+FT_T FT_new(void);
+
+/*
+  Does what FT_new does, but allocates every node of the new FT, with
+  its name and children, from an arena of its own, which FT_free
+  releases whole without visiting the nodes. Names are copied into the
+  arena instead of shared through the atom table.
+*/
+FT_T FT_newArena(void);
+
+/*
+  Frees oFTree and all its contents. Does nothing if oFTree is NULL.
+  File contents are owned by the client and are not freed.
+*/
+void FT_free(FT_T oFTree);
+
+/*
+  Each of these does to oFTree what the function of the same name
+  without the In suffix, declared below, does to the default FT.
+  None of them returns INITIALIZATION_ERROR.
+*/
+int FT_insertDirIn(FT_T oFTree, const char *pcPath);
+boolean FT_containsDirIn(FT_T oFTree, const char *pcPath);
+int FT_rmDirIn(FT_T oFTree, const char *pcPath);
+int FT_rmDirLaterIn(FT_T oFTree, const char *pcPath);
+int FT_insertFileIn(FT_T oFTree, const char *pcPath, void *pvContents,
+                    size_t ulLength);
+boolean FT_containsFileIn(FT_T oFTree, const char *pcPath);
+int FT_rmFileIn(FT_T oFTree, const char *pcPath);
+void *FT_getFileContentsIn(FT_T oFTree, const char *pcPath);
+void *FT_replaceFileContentsIn(FT_T oFTree, const char *pcPath,
+                               void *pvNewContents, size_t ulNewLength);
+int FT_statIn(FT_T oFTree, const char *pcPath, boolean *pbIsFile,
+              size_t *pulSize);
+char *FT_toStringIn(FT_T oFTree);
+int FT_writeToFileIn(FT_T oFTree, FILE *psFile);
+int FT_bulkLoadIn(FT_T oFTree, const char **ppcPaths,
+                  const boolean *pbIsFile, void **ppvContents,
+                  const size_t *pulLengths, size_t ulCount);
+int FT_applyBatchIn(FT_T oFTree, const FT_Op *psOps, size_t ulCount,
+                    int *piResults);
+int FT_indexPathsIn(FT_T oFTree);
+int FT_filterPathsIn(FT_T oFTree, size_t ulPaths, double dRate);
+int FT_cacheDirsIn(FT_T oFTree, size_t ulSlots);
+int FT_getCacheStatsIn(FT_T oFTree, size_t *pulHits,
+                       size_t *pulMisses);
+int FT_openDirIn(FT_T oFTree, const char *pcPath, FT_Dir *psDir);
+int FT_insertFileAtIn(FT_T oFTree, const FT_Dir *psDir,
+                      const char *pcName, void *pvContents,
+                      size_t ulLength);
+boolean FT_containsAtIn(FT_T oFTree, const FT_Dir *psDir,
+                        const char *pcName);
+int FT_rmAtIn(FT_T oFTree, const FT_Dir *psDir, const char *pcName);
+int FT_openFileIn(FT_T oFTree, const char *pcPath, FT_File *psFile);
+void *FT_getFileContentsOfIn(FT_T oFTree, const FT_File *psFile);
+void *FT_replaceFileContentsOfIn(FT_T oFTree, const FT_File *psFile,
+                                 void *pvNewContents,
+                                 size_t ulNewLength);
+int FT_statOfIn(FT_T oFTree, const FT_File *psFile, size_t *pulSize);
+
 /*
    Inserts a new directory into the FT with absolute path pcPath.
    Returns SUCCESS if the new directory is inserted successfully.
@@ -47,6 +177,15 @@ boolean FT_containsDir(const char *pcPath);
 */
 int FT_rmDir(const char *pcPath);
 
+/*
+  Does what FT_rmDir does, with the same statuses, but only unlinks
+  the subtree, in constant time, and leaves freeing it to a background
+  thread. Without THREADSAFE, or if the thread cannot be started, the
+  subtree is freed before returning. FT_destroy and FT_free wait until
+  such subtrees are freed.
+*/
+int FT_rmDirLater(const char *pcPath);
+
 
 /*
    Inserts a new file into the FT with absolute path pcPath, with
@@ -127,6 +266,12 @@ int FT_stat(const char *pcPath, boolean *pbIsFile, size_t *pulSize);
 */
 int FT_init(void);
 
+/*
+  Does what FT_init does, but allocates the default FT from an arena,
+  as FT_newArena does, until the next FT_destroy.
+*/
+int FT_initArena(void);
+
 /*
   Removes all contents of the data structure and
   returns it to an uninitialized state.
@@ -149,4 +294,195 @@ int FT_destroy(void);
 */
 char *FT_toString(void);
 
+/*
+  Writes the same representation FT_toString returns to psFile,
+  without building it in memory: the listing is produced a node at a
+  time through a fixed-size buffer. Returns:
+  * INITIALIZATION_ERROR if the data structure is not initialized
+  * IO_ERROR if writing to psFile fails
+  * MEMORY_ERROR if a path too long for the buffer cannot be copied
+  * SUCCESS otherwise
+  Output before a failure may already have been written.
+*/
+int FT_writeToFile(FILE *psFile);
+
+/*
+  Inserts the ulCount paths ppcPaths[0], ppcPaths[1], ... in order,
+  as FT_insertFile would if pbIsFile is not NULL and pbIsFile[i] is
+  TRUE, with contents ppvContents[i] of length pulLengths[i] (NULL and
+  0 if those arrays are NULL), and as FT_insertDir would otherwise.
+  A sorted listing loads in time linear in its total length; other
+  orders are accepted. The FT is locked against other changes for the
+  whole load. Returns the status FT_insertDir or FT_insertFile would
+  for the first path that cannot be inserted, leaving the paths before
+  it in the FT and not trying those after it, or:
+  * INITIALIZATION_ERROR if the data structure is not initialized
+  * SUCCESS if every path was inserted
+*/
+int FT_bulkLoad(const char **ppcPaths, const boolean *pbIsFile,
+                void **ppvContents, const size_t *pulLengths,
+                size_t ulCount);
+
+/*
+  Applies the ulCount changes psOps[0], psOps[1], ... to the FT with
+  the FT locked against other changes throughout, and stores in
+  piResults[i] the status the function named by psOps[i].eKind would
+  return: that of FT_insertDir, FT_insertFile, FT_rmDir or FT_rmFile,
+  or for FT_OP_REPLACE_CONTENTS, SUCCESS if the contents were replaced
+  and otherwise BAD_PATH, CONFLICTING_PATH, NO_SUCH_PATH or NOT_A_FILE
+  as FT_rmFile would. The results are those of applying the changes
+  in the order given. Returns:
+  * INITIALIZATION_ERROR if the data structure is not initialized
+  * SUCCESS if every change was applied
+  * otherwise, the first status in piResults other than SUCCESS
+*/
+int FT_applyBatch(const FT_Op *psOps, size_t ulCount, int *piResults);
+
+/*
+  Builds an index of every directory and file in the FT by absolute
+  path, which every change keeps up to date until FT_destroy, so that
+  FT_containsDir, FT_containsFile, FT_getFileContents and FT_stat find
+  a path in one hash probe. The index costs two to four pointers of
+  memory per node, plus a copy of the node's absolute path, which
+  each insert allocates and fills for every node it adds.
+  Does nothing if the FT is already indexed. Returns:
+  * INITIALIZATION_ERROR if the data structure is not initialized
+  * MEMORY_ERROR if memory could not be allocated for the index,
+                 in which case the FT is left without one
+  * SUCCESS otherwise
+*/
+int FT_indexPaths(void);
+
+/*
+  Gives the FT a counting Bloom filter over the absolute paths of all
+  its directories and files, which every change keeps up to date until
+  FT_destroy, and through which lookups reject most absent paths
+  without a traversal. Sized for ulPaths paths, it lets through about
+  a fraction dRate of absent paths, more if the FT grows past ulPaths,
+  and takes about 2.5 log2(1 / dRate) bytes per path, rounded up to a
+  power of 2 in all; rates below 2^-8 are treated as 2^-8. Does
+  nothing if the FT already has a filter. Returns:
+  * INITIALIZATION_ERROR if the data structure is not initialized
+  * MEMORY_ERROR if memory could not be allocated for the filter,
+                 in which case the FT is left without one
+  * SUCCESS otherwise
+*/
+int FT_filterPaths(size_t ulPaths, double dRate);
+
+/*
+  Gives the FT a cache of ulSlots directories, rounded up to a power
+  of 2, that FT_containsDir, FT_containsFile, FT_getFileContents and
+  FT_stat fill with the directories they reach, and start from, until
+  FT_destroy. Each slot costs two words of memory; nodes keep nothing
+  more. Removing a directory evicts only the directories it removes.
+  Lookups use the FT's path index instead, if it has one (see
+  FT_indexPaths). Does nothing if the FT already has a cache.
+  Returns:
+  * INITIALIZATION_ERROR if the data structure is not initialized
+  * MEMORY_ERROR if memory could not be allocated for the cache,
+                 in which case the FT is left without one
+  * SUCCESS otherwise
+*/
+int FT_cacheDirs(size_t ulSlots);
+
+/*
+  Stores in *pulHits and *pulMisses the number of lookups that did
+  and did not start from a directory in the FT's cache (both 0 if the
+  FT has no cache). Lookups of paths of at most two components count
+  as neither. Returns:
+  * INITIALIZATION_ERROR if the data structure is not initialized
+  * SUCCESS otherwise
+*/
+int FT_getCacheStats(size_t *pulHits, size_t *pulMisses);
+
+/*
+  Stores a handle to the directory with absolute path pcPath in
+  *psDir. Opening the same directory again gives an equal handle.
+  Returns SUCCESS if it was opened. Otherwise, leaves *psDir unchanged
+  and returns:
+  * INITIALIZATION_ERROR if the FT is not in an initialized state
+  * BAD_PATH if pcPath does not represent a well-formatted path
+  * CONFLICTING_PATH if the root exists but is not a prefix of pcPath
+  * NO_SUCH_PATH if absolute path pcPath does not exist in the FT
+  * NOT_A_DIRECTORY if pcPath is in the FT as a file not a directory
+  * MEMORY_ERROR if memory could not be allocated to complete request
+*/
+int FT_openDir(const char *pcPath, FT_Dir *psDir);
+
+/*
+  Inserts a new file named pcName, with contents pvContents of size
+  ulLength bytes, into the directory *psDir is a handle to, as
+  FT_insertFile would at the directory's path followed by "/" and
+  pcName. Returns SUCCESS if the file is inserted.
+  Otherwise, returns:
+  * INITIALIZATION_ERROR if the FT is not in an initialized state
+  * BAD_PATH if pcName is empty or contains a '/'
+  * NO_SUCH_PATH if *psDir is stale or to no directory
+  * ALREADY_IN_TREE if the directory has a child named pcName
+  * MEMORY_ERROR if memory could not be allocated to complete request
+*/
+int FT_insertFileAt(const FT_Dir *psDir, const char *pcName,
+                    void *pvContents, size_t ulLength);
+
+/*
+  Returns TRUE if the directory *psDir is a handle to has a child,
+  file or directory, named pcName, and FALSE if not or if *psDir is
+  stale or there is an error while checking. Takes no lock.
+*/
+boolean FT_containsAt(const FT_Dir *psDir, const char *pcName);
+
+/*
+  Removes the child named pcName of the directory *psDir is a handle
+  to: a file as FT_rmFile would, or a directory with its subtree as
+  FT_rmDir would, making handles to it and to anything in it stale.
+  Returns SUCCESS if found and removed. Otherwise, returns:
+  * INITIALIZATION_ERROR if the FT is not in an initialized state
+  * BAD_PATH if pcName is empty or contains a '/'
+  * NO_SUCH_PATH if *psDir is stale or to no directory, or the
+                 directory has no child named pcName
+  * MEMORY_ERROR if memory could not be allocated to complete request
+*/
+int FT_rmAt(const FT_Dir *psDir, const char *pcName);
+
+/*
+  Stores a handle to the file with absolute path pcPath in *psFile.
+  Opening the same file again gives an equal handle. Returns SUCCESS
+  if it was opened. Otherwise,
+  leaves *psFile unchanged and returns:
+  * INITIALIZATION_ERROR if the FT is not in an initialized state
+  * BAD_PATH if pcPath does not represent a well-formatted path
+  * CONFLICTING_PATH if the root exists but is not a prefix of pcPath
+  * NO_SUCH_PATH if absolute path pcPath does not exist in the FT
+  * NOT_A_FILE if pcPath is in the FT as a directory not a file
+  * MEMORY_ERROR if memory could not be allocated to complete request
+*/
+int FT_openFile(const char *pcPath, FT_File *psFile);
+
+/*
+  Returns the contents of the file *psFile is a handle to, or NULL if
+  *psFile is stale or to no file, or if unable to complete the request
+  for any other reason. Takes no lock.
+*/
+void *FT_getFileContentsOf(const FT_File *psFile);
+
+/*
+  Replaces the contents of the file *psFile is a handle to with
+  pvNewContents of size ulNewLength bytes. Returns the old contents if
+  successful, and NULL if *psFile is stale or to no file, or if unable
+  to complete the request for any other reason.
+*/
+void *FT_replaceFileContentsOf(const FT_File *psFile,
+                               void *pvNewContents, size_t ulNewLength);
+
+/*
+  Sets *pulSize to the length of the contents of the file *psFile is a
+  handle to and returns SUCCESS. Otherwise, leaves *pulSize unchanged
+  and returns:
+  * INITIALIZATION_ERROR if the FT is not in an initialized state
+  * NO_SUCH_PATH if *psFile is stale or to no file
+  * MEMORY_ERROR if memory could not be allocated to complete request
+  Takes no lock.
+*/
+int FT_statOf(const FT_File *psFile, size_t *pulSize);
+
 #endif
@@ -18,6 +18,8 @@ int main(void) {
   char* temp;
   boolean bIsFile;
   size_t l;
+  FT_Dir sDir = { NULL, 0 };
+  FT_File sFile = { NULL, 0 };
   char arr[ARRLEN];
   arr[0] = '\0';
 
@@ -235,7 +237,723 @@ int main(void) {
   fprintf(stderr, "Checkpoint 4.5:\n%s\n", temp);
   free(temp);
 
+  /* writeToFile streams exactly what toString returns, including
+     paths longer than its buffer
+  */
+  {
+    enum {LONG_DEPTH = 100, NAME_LENGTH = 99};
+    char *pcLong;
+    char *pcRead;
+    size_t ulLength;
+    size_t i;
+    FILE *psFile;
+
+    pcLong = malloc(LONG_DEPTH * (NAME_LENGTH + 1) + 6);
+    assert(pcLong != NULL);
+    strcpy(pcLong, "1root");
+    for(i = 0; i < LONG_DEPTH; i++) {
+      strcat(pcLong, "/");
+      memset(pcLong + strlen(pcLong), 'a' + (int) (i % 26),
+             NAME_LENGTH);
+      pcLong[(i + 1) * (NAME_LENGTH + 1) + 5] = '\0';
+    }
+    assert(FT_insertDir(pcLong) == SUCCESS);
+
+    assert((temp = FT_toString()) != NULL);
+    ulLength = strlen(temp);
+    assert((psFile = tmpfile()) != NULL);
+    assert(FT_writeToFile(psFile) == SUCCESS);
+    assert((size_t) ftell(psFile) == ulLength);
+    rewind(psFile);
+    pcRead = malloc(ulLength + 1);
+    assert(pcRead != NULL);
+    assert(fread(pcRead, 1, ulLength + 1, psFile) == ulLength);
+    pcRead[ulLength] = '\0';
+    assert(!strcmp(pcRead, temp));
+    fclose(psFile);
+    free(pcRead);
+    free(temp);
+
+    pcLong[strlen("1root/") + NAME_LENGTH] = '\0';
+    assert(FT_rmDir(pcLong) == SUCCESS);
+    free(pcLong);
+  }
+
+  /* A wide directory behaves the same as a narrow one: children
+     inserted and removed out of order are still found, and are
+     still printed in lexicographic order, both while it is large
+     and after it shrinks again.
+  */
+  {
+    enum {WIDE = 300};
+    char acPath[32];
+    char *pcExpected;
+    size_t i;
+
+    assert(FT_insertDir("1root/w") == SUCCESS);
+    for(i = 0; i < WIDE; i++) {
+      sprintf(acPath, "1root/w/f%03lu", (unsigned long) (i * 7 % WIDE));
+      assert(FT_insertFile(acPath, NULL, 0) == SUCCESS);
+    }
+    assert(FT_insertDir("1root/w/f123/x") == NOT_A_DIRECTORY);
+    for(i = 0; i < WIDE; i++) {
+      sprintf(acPath, "1root/w/f%03lu", (unsigned long) i);
+      assert(FT_containsFile(acPath) == TRUE);
+    }
+    assert(FT_containsFile("1root/w/f300") == FALSE);
+
+    /* remove all but every tenth child, in scattered order */
+    for(i = 0; i < WIDE; i++) {
+      sprintf(acPath, "1root/w/f%03lu", (unsigned long) (i * 7 % WIDE));
+      if(i * 7 % WIDE % 10 != 0)
+        assert(FT_rmFile(acPath) == SUCCESS);
+    }
+    for(i = 0; i < WIDE; i++) {
+      sprintf(acPath, "1root/w/f%03lu", (unsigned long) i);
+      assert(FT_containsFile(acPath) == (boolean) (i % 10 == 0));
+    }
+
+    pcExpected = malloc(WIDE / 10 * 14 + 1);
+    assert(pcExpected != NULL);
+    *pcExpected = '\0';
+    for(i = 0; i < WIDE; i += 10) {
+      sprintf(acPath, "1root/w/f%03lu\n", (unsigned long) i);
+      strcat(pcExpected, acPath);
+    }
+    assert((temp = FT_toString()) != NULL);
+    assert(strstr(temp, pcExpected) != NULL);
+    free(temp);
+    free(pcExpected);
+    assert(FT_rmDir("1root/w") == SUCCESS);
+  }
+
+  /* independent FT_T handles share nothing with the default FT */
+  {
+    FT_T oFTA, oFTB;
+    boolean bIsFile;
+    size_t ulSize;
+
+    assert((oFTA = FT_new()) != NULL);
+    assert((oFTB = FT_new()) != NULL);
+    assert(FT_insertDirIn(oFTA, "a/b") == SUCCESS);
+    assert(FT_insertFileIn(oFTB, "b/c", "x", 2) == CONFLICTING_PATH);
+    assert(FT_insertDirIn(oFTB, "b") == SUCCESS);
+    assert(FT_insertFileIn(oFTB, "b/c", "x", 2) == SUCCESS);
+    assert(FT_insertDirIn(oFTA, "b") == CONFLICTING_PATH);
+    assert(FT_containsDirIn(oFTA, "a/b") == TRUE);
+    assert(FT_containsDirIn(oFTB, "a/b") == FALSE);
+    assert(FT_containsDir("a/b") == FALSE);
+    assert(FT_statIn(oFTB, "b/c", &bIsFile, &ulSize) == SUCCESS);
+    assert(bIsFile == TRUE && ulSize == 2);
+    assert((temp = FT_toStringIn(oFTA)) != NULL);
+    assert(!strcmp(temp, "a\na/b\n"));
+    free(temp);
+    assert(FT_rmDirIn(oFTB, "b") == SUCCESS);
+    assert((temp = FT_toStringIn(oFTB)) != NULL);
+    assert(!strcmp(temp, ""));
+    free(temp);
+    FT_free(oFTA);
+    FT_free(oFTB);
+    FT_free(NULL);
+  }
+
+  /* FT_rmDirLater removes what FT_rmDir would, with its statuses */
+  {
+    FT_T oFTC;
+
+    assert((oFTC = FT_new()) != NULL);
+    assert(FT_rmDirLaterIn(oFTC, "c") == NO_SUCH_PATH);
+    assert(FT_insertDirIn(oFTC, "c/d/e") == SUCCESS);
+    assert(FT_insertFileIn(oFTC, "c/d/f", NULL, 0) == SUCCESS);
+    assert(FT_insertDirIn(oFTC, "c/g") == SUCCESS);
+    assert(FT_rmDirLaterIn(oFTC, "c/d/f") == NOT_A_DIRECTORY);
+    assert(FT_rmDirLaterIn(oFTC, "x/d") == CONFLICTING_PATH);
+    assert(FT_rmDirLaterIn(oFTC, "c/d") == SUCCESS);
+    assert(FT_containsFileIn(oFTC, "c/d/f") == FALSE);
+    assert(FT_containsDirIn(oFTC, "c/d") == FALSE);
+    assert((temp = FT_toStringIn(oFTC)) != NULL);
+    assert(!strcmp(temp, "c\nc/g\n"));
+    free(temp);
+    assert(FT_rmDirLaterIn(oFTC, "c") == SUCCESS);
+    assert(FT_insertDirIn(oFTC, "c/d") == SUCCESS);
+    FT_free(oFTC);
+  }
+
+  /* missing directories are built in one piece, and each of them can
+     still be removed on its own */
+  {
+    FT_T oFTE;
+
+    assert((oFTE = FT_new()) != NULL);
+    assert(FT_insertFileIn(oFTE, "e/f/g/h", "z", 2) == CONFLICTING_PATH);
+    assert(FT_insertDirIn(oFTE, "e/f/g/h") == SUCCESS);
+    assert(FT_insertFileIn(oFTE, "e/f/i/j/k", "z", 2) == SUCCESS);
+    assert(FT_insertDirIn(oFTE, "e/f/i/j/k/l") == NOT_A_DIRECTORY);
+    assert(FT_insertDirIn(oFTE, "e/f/g") == ALREADY_IN_TREE);
+    assert(FT_containsFileIn(oFTE, "e/f/i/j/k") == TRUE);
+    assert(FT_rmDirIn(oFTE, "e/f/g/h") == SUCCESS);
+    assert(FT_rmDirIn(oFTE, "e/f/i/j") == SUCCESS);
+    assert(FT_insertDirIn(oFTE, "e/f/g/h/m") == SUCCESS);
+    assert((temp = FT_toStringIn(oFTE)) != NULL);
+    assert(!strcmp(temp, "e\ne/f\ne/f/g\ne/f/g/h\ne/f/g/h/m\ne/f/i\n"));
+    free(temp);
+    assert(FT_rmDirIn(oFTE, "e/f/g") == SUCCESS);
+    FT_free(oFTE);
+  }
+
+  /* a bulk load inserts what single inserts would, in any order */
+  {
+    FT_T oFTF;
+    const char *apcSorted[] = { "f", "f/a", "f/a/x", "f/a/y/z", "f/b",
+                                "f/c", "f/c/d" };
+    boolean abIsFile[] = { FALSE, FALSE, TRUE, FALSE, TRUE, FALSE,
+                           TRUE };
+    void *apvContents[] = { NULL, NULL, "x", NULL, "b", NULL, "d" };
+    size_t aulLengths[] = { 0, 0, 2, 0, 2, 0, 2 };
+    const char *apcMixed[] = { "f/c/e", "f/a/w", "f/c/d/g", "f/a/y",
+                               "f/a/b" };
+
+    assert((oFTF = FT_new()) != NULL);
+    assert(FT_bulkLoadIn(oFTF, apcSorted, abIsFile, NULL, NULL, 0) ==
+           SUCCESS);
+    assert(FT_bulkLoadIn(oFTF, apcSorted + 2, abIsFile + 2, NULL, NULL,
+                         1) == CONFLICTING_PATH);
+    assert(FT_bulkLoadIn(oFTF, apcSorted, abIsFile, apvContents,
+                         aulLengths, 7) == SUCCESS);
+    assert(FT_containsDirIn(oFTF, "f/a/y") == TRUE);
+    assert(FT_containsFileIn(oFTF, "f/c/d") == TRUE);
+    assert(!strcmp(FT_getFileContentsIn(oFTF, "f/b"), "b"));
+    assert((temp = FT_toStringIn(oFTF)) != NULL);
+    assert(!strcmp(temp, "f\nf/b\nf/a\nf/a/x\nf/a/y\nf/a/y/z\n"
+                   "f/c\nf/c/d\n"));
+    free(temp);
+    assert(FT_bulkLoadIn(oFTF, apcMixed, NULL, NULL, NULL, 2) ==
+           SUCCESS);
+    assert(FT_bulkLoadIn(oFTF, apcMixed + 2, NULL, NULL, NULL, 3) ==
+           NOT_A_DIRECTORY);
+    assert(FT_bulkLoadIn(oFTF, apcMixed + 3, NULL, NULL, NULL, 2) ==
+           ALREADY_IN_TREE);
+    assert(FT_containsDirIn(oFTF, "f/a/b") == FALSE);
+    assert(FT_bulkLoadIn(oFTF, apcMixed + 4, NULL, NULL, NULL, 1) ==
+           SUCCESS);
+    assert((temp = FT_toStringIn(oFTF)) != NULL);
+    assert(!strcmp(temp, "f\nf/b\nf/a\nf/a/x\nf/a/b\nf/a/w\n"
+                   "f/a/y\nf/a/y/z\nf/c\nf/c/d\nf/c/e\n"));
+    free(temp);
+    assert(FT_rmDirIn(oFTF, "f") == SUCCESS);
+    assert(FT_bulkLoadIn(oFTF, apcMixed, NULL, NULL, NULL, 1) ==
+           SUCCESS);
+    assert(FT_containsDirIn(oFTF, "f/c/e") == TRUE);
+    FT_free(oFTF);
+  }
+  assert(FT_bulkLoad(NULL, NULL, NULL, NULL, 0) == SUCCESS);
+
+  /* a batch gives each change the status its own call would, whether
+     the changes are sorted or, depending on each other, are not */
+  {
+    FT_T oFTO;
+    void *pvOld = "unset";
+    int aiResults[8];
+    FT_Op asSorted[8] = {
+      { FT_OP_REPLACE_CONTENTS, "b/y/f", "new", 4, NULL },
+      { FT_OP_RM_FILE, "b/x/f", NULL, 0, NULL },
+      { FT_OP_INSERT_DIR, "b/w/v", NULL, 0, NULL },
+      { FT_OP_RM_DIR, "b/y/f", NULL, 0, NULL },
+      { FT_OP_INSERT_FILE, "b/x/g", "g", 2, NULL },
+      { FT_OP_RM_DIR, "b/z", NULL, 0, NULL },
+      { FT_OP_RM_FILE, "b/x/d", NULL, 0, NULL },
+      { FT_OP_INSERT_DIR, "b/x/d", NULL, 0, NULL }
+    };
+    FT_Op asOrdered[7] = {
+      { FT_OP_INSERT_DIR, "b/n", NULL, 0, NULL },
+      { FT_OP_INSERT_FILE, "b/n/f", "f", 2, NULL },
+      { FT_OP_REPLACE_CONTENTS, "b/n/f", "g", 2, NULL },
+      { FT_OP_RM_DIR, "b", NULL, 0, NULL },
+      { FT_OP_REPLACE_CONTENTS, "b/n/f", NULL, 0, NULL },
+      { FT_OP_INSERT_FILE, "c", NULL, 0, NULL },
+      { FT_OP_INSERT_DIR, "c/d", NULL, 0, NULL }
+    };
+
+    asSorted[0].ppvOldContents = &pvOld;
+    asOrdered[2].ppvOldContents = &pvOld;
+
+    assert((oFTO = FT_new()) != NULL);
+    assert(FT_insertDirIn(oFTO, "b") == SUCCESS);
+    assert(FT_insertFileIn(oFTO, "b/x/f", NULL, 0) == SUCCESS);
+    assert(FT_insertFileIn(oFTO, "b/y/f", "old", 4) == SUCCESS);
+    assert(FT_insertDirIn(oFTO, "b/x/d") == SUCCESS);
+    assert(FT_applyBatchIn(oFTO, asSorted, 8, aiResults) ==
+           NOT_A_DIRECTORY);
+    assert(aiResults[0] == SUCCESS && !strcmp(pvOld, "old"));
+    assert(aiResults[1] == SUCCESS);
+    assert(aiResults[2] == SUCCESS);
+    assert(aiResults[3] == NOT_A_DIRECTORY);
+    assert(aiResults[4] == SUCCESS);
+    assert(aiResults[5] == NO_SUCH_PATH);
+    assert(aiResults[6] == NOT_A_FILE);
+    assert(aiResults[7] == ALREADY_IN_TREE);
+    assert((temp = FT_toStringIn(oFTO)) != NULL);
+    assert(!strcmp(temp, "b\nb/w\nb/w/v\nb/x\nb/x/g\nb/x/d\n"
+                   "b/y\nb/y/f\n"));
+    free(temp);
+    assert(!strcmp(FT_getFileContentsIn(oFTO, "b/y/f"), "new"));
+
+    assert(FT_applyBatchIn(oFTO, asOrdered, 7, aiResults) ==
+           NO_SUCH_PATH);
+    assert(aiResults[0] == SUCCESS);
+    assert(aiResults[1] == SUCCESS);
+    assert(aiResults[2] == SUCCESS && !strcmp(pvOld, "f"));
+    assert(aiResults[3] == SUCCESS);
+    assert(aiResults[4] == NO_SUCH_PATH);
+    assert(aiResults[5] == CONFLICTING_PATH);
+    assert(aiResults[6] == SUCCESS);
+    assert((temp = FT_toStringIn(oFTO)) != NULL);
+    assert(!strcmp(temp, "c\nc/d\n"));
+    free(temp);
+
+    asOrdered[0].pcPath = "c/d/";
+    asOrdered[1].pcPath = "x/f";
+    asOrdered[2].pcPath = "c/d";
+    asOrdered[3].pcPath = "c/d/e";
+    asOrdered[3].eKind = FT_OP_INSERT_DIR;
+    assert(FT_applyBatchIn(oFTO, asOrdered, 4, aiResults) == BAD_PATH);
+    assert(aiResults[0] == BAD_PATH);
+    assert(aiResults[1] == CONFLICTING_PATH);
+    assert(aiResults[2] == NOT_A_FILE);
+    assert(aiResults[3] == SUCCESS);
+    assert(FT_containsDirIn(oFTO, "c/d/e") == TRUE);
+    assert(FT_applyBatchIn(oFTO, NULL, 0, NULL) == SUCCESS);
+    FT_free(oFTO);
+  }
+  assert(FT_applyBatch(NULL, 0, NULL) == SUCCESS);
+
+  /* an indexed FT finds what it would without the index, and loses
+     removed subtrees from it, whichever way they are removed */
+  {
+    FT_T oFTI;
+    const char *apcLoaded[3] = { "r/l", "r/l/m", "r/l/m/n" };
+    size_t ulSize;
+
+    assert((oFTI = FT_new()) != NULL);
+    assert(FT_insertDirIn(oFTI, "r/a") == SUCCESS);
+    assert(FT_insertFileIn(oFTI, "r/a/f", "f", 2) == SUCCESS);
+    assert(FT_indexPathsIn(oFTI) == SUCCESS);
+    assert(FT_indexPathsIn(oFTI) == SUCCESS);
+    assert(FT_containsDirIn(oFTI, "r/a") == TRUE);
+    assert(FT_containsFileIn(oFTI, "r/a/f") == TRUE);
+    assert(FT_containsDirIn(oFTI, "r/a/f") == FALSE);
+    assert(FT_containsFileIn(oFTI, "r/a") == FALSE);
+    assert(FT_insertDirIn(oFTI, "r/a/b/c/d") == SUCCESS);
+    assert(FT_insertFileIn(oFTI, "r/a/b/c/d/e", "e", 2) == SUCCESS);
+    assert(FT_containsDirIn(oFTI, "r/a/b/c/d") == TRUE);
+    assert(!strcmp(FT_getFileContentsIn(oFTI, "r/a/b/c/d/e"), "e"));
+    assert(FT_statIn(oFTI, "r/a/b/c/d/e", &bIsFile, &ulSize) ==
+           SUCCESS);
+    assert(bIsFile == TRUE && ulSize == 2);
+    assert(FT_statIn(oFTI, "r/a/b/c/x", &bIsFile, &ulSize) ==
+           NO_SUCH_PATH);
+    assert(FT_statIn(oFTI, "x/a/b", &bIsFile, &ulSize) ==
+           CONFLICTING_PATH);
+    assert(FT_statIn(oFTI, "r//a", &bIsFile, &ulSize) == BAD_PATH);
+    assert(FT_containsDirIn(oFTI, "a/b/c/d") == FALSE);
+    assert(FT_containsDirIn(oFTI, "r/a/b/c/d/e/r") == FALSE);
+
+    assert(FT_rmDirIn(oFTI, "r/a/b") == SUCCESS);
+    assert(FT_containsDirIn(oFTI, "r/a/b/c") == FALSE);
+    assert(FT_containsFileIn(oFTI, "r/a/b/c/d/e") == FALSE);
+    assert(FT_insertDirIn(oFTI, "r/a/b/c") == SUCCESS);
+    assert(FT_containsDirIn(oFTI, "r/a/b/c") == TRUE);
+    assert(FT_rmDirLaterIn(oFTI, "r/a/b") == SUCCESS);
+    assert(FT_containsDirIn(oFTI, "r/a/b/c") == FALSE);
+    assert(FT_insertFileIn(oFTI, "r/a/b", NULL, 0) == SUCCESS);
+    assert(FT_containsFileIn(oFTI, "r/a/b") == TRUE);
+    assert(FT_rmFileIn(oFTI, "r/a/b") == SUCCESS);
+    assert(FT_containsFileIn(oFTI, "r/a/b") == FALSE);
+    assert(FT_bulkLoadIn(oFTI, apcLoaded, NULL, NULL, NULL, 3) ==
+           SUCCESS);
+    assert(FT_containsDirIn(oFTI, "r/l/m/n") == TRUE);
+
+    assert(FT_rmDirIn(oFTI, "r") == SUCCESS);
+    assert(FT_containsDirIn(oFTI, "r") == FALSE);
+    assert(FT_statIn(oFTI, "r", &bIsFile, &ulSize) == NO_SUCH_PATH);
+    assert(FT_insertDirIn(oFTI, "q/r") == SUCCESS);
+    assert(FT_containsDirIn(oFTI, "q/r") == TRUE);
+    assert(FT_containsDirIn(oFTI, "r") == FALSE);
+    FT_free(oFTI);
+
+    assert((oFTI = FT_newArena()) != NULL);
+    assert(FT_indexPathsIn(oFTI) == SUCCESS);
+    assert(FT_insertDirIn(oFTI, "r/a/b") == SUCCESS);
+    assert(FT_insertFileIn(oFTI, "r/a/f", NULL, 0) == SUCCESS);
+    assert(FT_containsDirIn(oFTI, "r/a/b") == TRUE);
+    assert(FT_containsFileIn(oFTI, "r/a/f") == TRUE);
+    assert(FT_rmDirIn(oFTI, "r/a/b") == SUCCESS);
+    assert(FT_containsDirIn(oFTI, "r/a/b") == FALSE);
+    FT_free(oFTI);
+  }
+
+  /* a FT with a path filter gives every lookup the answer it would
+     without one, whether the filter rules the path out or not, even
+     once it is too small for the FT and its counters saturate */
+  {
+    FT_T oFTP;
+    char acName[32];
+    size_t ulSize;
+    size_t i;
+
+    assert((oFTP = FT_new()) != NULL);
+    assert(FT_insertDirIn(oFTP, "r/a") == SUCCESS);
+    assert(FT_insertFileIn(oFTP, "r/a/f", "f", 2) == SUCCESS);
+    assert(FT_filterPathsIn(oFTP, 100, 0.01) == SUCCESS);
+    assert(FT_filterPathsIn(oFTP, 1, 0.5) == SUCCESS);
+    assert(FT_containsDirIn(oFTP, "r/a") == TRUE);
+    assert(FT_containsFileIn(oFTP, "r/a/f") == TRUE);
+    assert(FT_containsFileIn(oFTP, "r/a/g") == FALSE);
+    assert(FT_containsDirIn(oFTP, "r/a/f") == FALSE);
+    assert(FT_statIn(oFTP, "x/a", &bIsFile, &ulSize) ==
+           CONFLICTING_PATH);
+    assert(FT_statIn(oFTP, "r/b", &bIsFile, &ulSize) == NO_SUCH_PATH);
+    assert(FT_getFileContentsIn(oFTP, "r/a/g") == NULL);
+    assert(FT_rmFileIn(oFTP, "r/a/g") == NO_SUCH_PATH);
+    assert(FT_rmDirIn(oFTP, "x/a") == CONFLICTING_PATH);
+    assert(FT_insertDirIn(oFTP, "r/a/b/c") == SUCCESS);
+    assert(FT_containsDirIn(oFTP, "r/a/b/c") == TRUE);
+    assert(FT_rmDirIn(oFTP, "r/a/b") == SUCCESS);
+    assert(FT_containsDirIn(oFTP, "r/a/b/c") == FALSE);
+    assert(FT_containsDirIn(oFTP, "r/a/b") == FALSE);
+    assert(FT_insertDirIn(oFTP, "r/a/b/c") == SUCCESS);
+    assert(FT_rmDirLaterIn(oFTP, "r/a/b") == SUCCESS);
+    assert(FT_containsDirIn(oFTP, "r/a/b/c") == FALSE);
+    assert(FT_rmFileIn(oFTP, "r/a/f") == SUCCESS);
+    assert(FT_containsFileIn(oFTP, "r/a/f") == FALSE);
+    assert(FT_rmDirIn(oFTP, "r") == SUCCESS);
+    assert(FT_containsDirIn(oFTP, "r") == FALSE);
+    assert(FT_insertDirIn(oFTP, "q") == SUCCESS);
+    assert(FT_containsDirIn(oFTP, "q") == TRUE);
+    assert(FT_statIn(oFTP, "r/a", &bIsFile, &ulSize) ==
+           CONFLICTING_PATH);
+    FT_free(oFTP);
+
+    assert((oFTP = FT_new()) != NULL);
+    assert(FT_filterPathsIn(oFTP, 1, 0.5) == SUCCESS);
+    assert(FT_insertDirIn(oFTP, "r") == SUCCESS);
+    for(i = 0; i < 20000; i++) {
+      sprintf(acName, "r/f%lu", (unsigned long) i);
+      assert(FT_insertFileIn(oFTP, acName, NULL, 0) == SUCCESS);
+    }
+    for(i = 0; i < 20000; i += 2) {
+      sprintf(acName, "r/f%lu", (unsigned long) i);
+      assert(FT_rmFileIn(oFTP, acName) == SUCCESS);
+    }
+    for(i = 0; i < 20000; i++) {
+      sprintf(acName, "r/f%lu", (unsigned long) i);
+      assert(FT_containsFileIn(oFTP, acName) == (i % 2 == 1));
+    }
+    FT_free(oFTP);
+  }
+
+  /* a FT with a directory cache finds what it would without one,
+     starting from the cached parent once it has been reached, and
+     forgets only the directories that are removed */
+  {
+    FT_T oFTK;
+    size_t ulHits, ulMisses, ulHitsBefore;
+    size_t ulSize;
+
+    assert((oFTK = FT_new()) != NULL);
+    assert(FT_getCacheStatsIn(oFTK, &ulHits, &ulMisses) == SUCCESS);
+    assert(ulHits == 0 && ulMisses == 0);
+    assert(FT_insertDirIn(oFTK, "r/a/b") == SUCCESS);
+    assert(FT_insertFileIn(oFTK, "r/a/b/f", "f", 2) == SUCCESS);
+    assert(FT_insertFileIn(oFTK, "r/a/b/g", "g", 2) == SUCCESS);
+    assert(FT_cacheDirsIn(oFTK, 1) == SUCCESS);
+    assert(FT_cacheDirsIn(oFTK, 64) == SUCCESS);
+
+    assert(FT_containsFileIn(oFTK, "r/a/b/f") == TRUE);
+    assert(FT_getCacheStatsIn(oFTK, &ulHits, &ulMisses) == SUCCESS);
+    assert(ulHits == 0 && ulMisses == 1);
+    assert(!strcmp(FT_getFileContentsIn(oFTK, "r/a/b/g"), "g"));
+    assert(FT_containsDirIn(oFTK, "r/a/b/f") == FALSE);
+    assert(FT_containsFileIn(oFTK, "r/a/b/h") == FALSE);
+    assert(FT_statIn(oFTK, "r/a/b/f", &bIsFile, &ulSize) == SUCCESS);
+    assert(bIsFile == TRUE && ulSize == 2);
+    assert(FT_getCacheStatsIn(oFTK, &ulHits, &ulMisses) == SUCCESS);
+    assert(ulHits == 4 && ulMisses == 1);
+    assert(FT_containsDirIn(oFTK, "r/a") == TRUE);
+    assert(FT_statIn(oFTK, "x/a/b", &bIsFile, &ulSize) ==
+           CONFLICTING_PATH);
+    assert(FT_statIn(oFTK, "r/a/c/d", &bIsFile, &ulSize) ==
+           NO_SUCH_PATH);
+    assert(FT_containsFileIn(oFTK, "r/a/b/f/x") == FALSE);
+    assert(FT_containsDirIn(oFTK, "r/a/b/c/d/e") == FALSE);
+
+    /* removing another directory, even one reached through the
+       cache, leaves the cached parent there */
+    assert(FT_insertDirIn(oFTK, "r/a/x/y/z") == SUCCESS);
+    assert(FT_containsDirIn(oFTK, "r/a/x/y/z") == TRUE);
+    assert(FT_rmDirIn(oFTK, "r/a/x") == SUCCESS);
+    assert(FT_containsDirIn(oFTK, "r/a/x/y/z") == FALSE);
+    assert(FT_getCacheStatsIn(oFTK, &ulHits, &ulMisses) == SUCCESS);
+    ulHitsBefore = ulHits;
+    assert(FT_containsFileIn(oFTK, "r/a/b/f") == TRUE);
+    assert(FT_getCacheStatsIn(oFTK, &ulHits, &ulMisses) == SUCCESS);
+    assert(ulHits == ulHitsBefore + 1);
+
+    /* a cached directory that is removed and recreated is a new node,
+       which the cache must not confuse with the old one */
+    assert(FT_rmDirIn(oFTK, "r/a/b") == SUCCESS);
+    assert(FT_containsFileIn(oFTK, "r/a/b/f") == FALSE);
+    assert(FT_insertFileIn(oFTK, "r/a/b/f", "F", 2) == SUCCESS);
+    assert(!strcmp(FT_getFileContentsIn(oFTK, "r/a/b/f"), "F"));
+    assert(!strcmp(FT_getFileContentsIn(oFTK, "r/a/b/f"), "F"));
+    assert(FT_rmDirLaterIn(oFTK, "r/a/b") == SUCCESS);
+    assert(FT_containsFileIn(oFTK, "r/a/b/f") == FALSE);
+    assert(FT_insertDirIn(oFTK, "r/a/b/c") == SUCCESS);
+    assert(FT_containsDirIn(oFTK, "r/a/b/c") == TRUE);
+    assert(FT_rmFileIn(oFTK, "r/a/b/f") == NO_SUCH_PATH);
+    assert(FT_insertFileIn(oFTK, "r/a/b/c/f", NULL, 0) == SUCCESS);
+    assert(FT_containsFileIn(oFTK, "r/a/b/c/f") == TRUE);
+    assert(FT_rmFileIn(oFTK, "r/a/b/c/f") == SUCCESS);
+    assert(FT_containsFileIn(oFTK, "r/a/b/c/f") == FALSE);
+    assert(FT_containsDirIn(oFTK, "r/a/b/c") == TRUE);
+    assert(FT_rmDirIn(oFTK, "r") == SUCCESS);
+    assert(FT_containsDirIn(oFTK, "r/a/b/c") == FALSE);
+    assert(FT_insertDirIn(oFTK, "r/a/b/c") == SUCCESS);
+    assert(FT_containsDirIn(oFTK, "r/a/b/c") == TRUE);
+    assert(FT_getCacheStatsIn(oFTK, &ulHits, &ulMisses) == SUCCESS);
+    assert(ulHits != 0 && ulMisses != 0);
+    FT_free(oFTK);
+  }
+
+  /* a directory handle reaches the directory's children by name as
+     paths through it would, and goes stale for good once the
+     directory or one above it is removed */
+  {
+    FT_T oFTH;
+    FT_Dir sOpen, sSame, sSub, sOld;
+    FT_Dir sNone = { NULL, 0 };
+    size_t ulSize;
+
+    assert((oFTH = FT_new()) != NULL);
+    assert(FT_openDirIn(oFTH, "r", &sOpen) == NO_SUCH_PATH);
+    assert(FT_insertDirIn(oFTH, "r/a/b") == SUCCESS);
+    assert(FT_insertFileIn(oFTH, "r/a/f", "f", 2) == SUCCESS);
+    assert(FT_openDirIn(oFTH, "r/a/", &sOpen) == BAD_PATH);
+    assert(FT_openDirIn(oFTH, "x/a", &sOpen) == CONFLICTING_PATH);
+    assert(FT_openDirIn(oFTH, "r/c", &sOpen) == NO_SUCH_PATH);
+    assert(FT_openDirIn(oFTH, "r/a/f", &sOpen) == NOT_A_DIRECTORY);
+    assert(FT_openDirIn(oFTH, "r/a", &sOpen) == SUCCESS);
+    assert(FT_openDirIn(oFTH, "r/a", &sSame) == SUCCESS);
+    assert(sSame.psEntry == sOpen.psEntry &&
+           sSame.ulGeneration == sOpen.ulGeneration);
+
+    assert(FT_containsAtIn(oFTH, &sOpen, "f") == TRUE);
+    assert(FT_containsAtIn(oFTH, &sOpen, "b") == TRUE);
+    assert(FT_containsAtIn(oFTH, &sOpen, "g") == FALSE);
+    assert(FT_containsAtIn(oFTH, &sOpen, "b/c") == FALSE);
+    assert(FT_containsAtIn(oFTH, &sOpen, "") == FALSE);
+    assert(FT_insertFileAtIn(oFTH, &sOpen, "g", "g", 2) == SUCCESS);
+    assert(!strcmp(FT_getFileContentsIn(oFTH, "r/a/g"), "g"));
+    assert(FT_insertFileAtIn(oFTH, &sOpen, "g", NULL, 0) ==
+           ALREADY_IN_TREE);
+    assert(FT_insertFileAtIn(oFTH, &sOpen, "b", NULL, 0) ==
+           ALREADY_IN_TREE);
+    assert(FT_insertFileAtIn(oFTH, &sOpen, "", NULL, 0) == BAD_PATH);
+    assert(FT_insertFileAtIn(oFTH, &sOpen, "c/d", NULL, 0) == BAD_PATH);
+    assert(FT_rmAtIn(oFTH, &sOpen, "c/d") == BAD_PATH);
+    assert(FT_rmAtIn(oFTH, &sOpen, "h") == NO_SUCH_PATH);
+    assert(FT_rmAtIn(oFTH, &sOpen, "g") == SUCCESS);
+    assert(FT_containsFileIn(oFTH, "r/a/g") == FALSE);
+    assert(FT_insertFileAtIn(oFTH, &sNone, "g", NULL, 0) ==
+           NO_SUCH_PATH);
+    assert(FT_containsAtIn(oFTH, &sNone, "f") == FALSE);
+    assert(FT_rmAtIn(oFTH, &sNone, "f") == NO_SUCH_PATH);
+
+    /* removing a directory through a handle makes handles to it
+       stale, even once the same path is a directory again */
+    assert(FT_openDirIn(oFTH, "r/a/b", &sSub) == SUCCESS);
+    assert(FT_insertFileAtIn(oFTH, &sSub, "f", NULL, 0) == SUCCESS);
+    assert(FT_rmAtIn(oFTH, &sOpen, "b") == SUCCESS);
+    assert(FT_containsDirIn(oFTH, "r/a/b") == FALSE);
+    assert(FT_containsAtIn(oFTH, &sSub, "f") == FALSE);
+    assert(FT_insertFileAtIn(oFTH, &sSub, "g", NULL, 0) ==
+           NO_SUCH_PATH);
+    assert(FT_insertDirIn(oFTH, "r/a/b") == SUCCESS);
+    sOld = sSub;
+    assert(FT_openDirIn(oFTH, "r/a/b", &sSub) == SUCCESS);
+    assert(FT_insertFileAtIn(oFTH, &sOld, "g", NULL, 0) ==
+           NO_SUCH_PATH);
+    assert(FT_insertFileAtIn(oFTH, &sSub, "g", NULL, 0) == SUCCESS);
+    assert(FT_containsFileIn(oFTH, "r/a/b/g") == TRUE);
+
+    /* as does removing one above it, in the background or not */
+    assert(FT_rmDirLaterIn(oFTH, "r/a") == SUCCESS);
+    assert(FT_containsAtIn(oFTH, &sOpen, "f") == FALSE);
+    assert(FT_containsAtIn(oFTH, &sSub, "g") == FALSE);
+    assert(FT_rmAtIn(oFTH, &sSub, "g") == NO_SUCH_PATH);
+    assert(FT_openDirIn(oFTH, "r", &sOpen) == SUCCESS);
+    assert(FT_insertFileAtIn(oFTH, &sOpen, "f", "F", 2) == SUCCESS);
+    assert(FT_statIn(oFTH, "r/f", &bIsFile, &ulSize) == SUCCESS);
+    assert(bIsFile == TRUE && ulSize == 2);
+    assert(FT_rmDirIn(oFTH, "r") == SUCCESS);
+    assert(FT_containsAtIn(oFTH, &sOpen, "f") == FALSE);
+    assert(FT_insertDirIn(oFTH, "r") == SUCCESS);
+    assert(FT_insertFileAtIn(oFTH, &sOpen, "f", NULL, 0) ==
+           NO_SUCH_PATH);
+    FT_free(oFTH);
+  }
+
+  /* a file handle reads, replaces and stats its file as its path
+     would, and goes stale for good once the file or a directory
+     above it is removed */
+  {
+    FT_T oFTJ;
+    FT_File sOpen, sSame, sOld;
+    FT_File sNone = { NULL, 0 };
+    size_t ulSize = 7;
+
+    assert((oFTJ = FT_new()) != NULL);
+    assert(FT_openFileIn(oFTJ, "r/f", &sOpen) == NO_SUCH_PATH);
+    assert(FT_insertDirIn(oFTJ, "r/a") == SUCCESS);
+    assert(FT_insertFileIn(oFTJ, "r/a/f", "f", 2) == SUCCESS);
+    assert(FT_insertFileIn(oFTJ, "r/a/g", NULL, 0) == SUCCESS);
+    assert(FT_openFileIn(oFTJ, "r/a/f/", &sOpen) == BAD_PATH);
+    assert(FT_openFileIn(oFTJ, "x/a/f", &sOpen) == CONFLICTING_PATH);
+    assert(FT_openFileIn(oFTJ, "r/a/h", &sOpen) == NO_SUCH_PATH);
+    assert(FT_openFileIn(oFTJ, "r/a", &sOpen) == NOT_A_FILE);
+    assert(FT_openFileIn(oFTJ, "r/a/f", &sOpen) == SUCCESS);
+    assert(FT_openFileIn(oFTJ, "r/a/f", &sSame) == SUCCESS);
+    assert(sSame.psEntry == sOpen.psEntry &&
+           sSame.ulGeneration == sOpen.ulGeneration);
+
+    assert(!strcmp(FT_getFileContentsOfIn(oFTJ, &sOpen), "f"));
+    assert(FT_statOfIn(oFTJ, &sOpen, &ulSize) == SUCCESS);
+    assert(ulSize == 2);
+    assert(!strcmp(FT_replaceFileContentsOfIn(oFTJ, &sOpen, "ff", 3),
+                   "f"));
+    assert(!strcmp(FT_getFileContentsIn(oFTJ, "r/a/f"), "ff"));
+    assert(FT_statOfIn(oFTJ, &sSame, &ulSize) == SUCCESS);
+    assert(ulSize == 3);
+    assert(FT_replaceFileContentsIn(oFTJ, "r/a/f", NULL, 0) != NULL);
+    assert(FT_getFileContentsOfIn(oFTJ, &sOpen) == NULL);
+    assert(FT_statOfIn(oFTJ, &sOpen, &ulSize) == SUCCESS);
+    assert(ulSize == 0);
+    /* the largest sizes are reported whole; the contents are never
+       read through the length, so it need not be allocated */
+    assert(FT_replaceFileContentsIn(oFTJ, "r/a/f", "f",
+                                    (size_t)-1 - 1) == NULL);
+    assert(FT_statOfIn(oFTJ, &sOpen, &ulSize) == SUCCESS);
+    assert(ulSize == (size_t)-1 - 1);
+    assert(FT_statIn(oFTJ, "r/a/f", &bIsFile, &ulSize) == SUCCESS);
+    assert(ulSize == (size_t)-1 - 1);
+    assert(FT_replaceFileContentsIn(oFTJ, "r/a/f", NULL, 0) != NULL);
+    assert(FT_getFileContentsOfIn(oFTJ, &sNone) == NULL);
+    assert(FT_replaceFileContentsOfIn(oFTJ, &sNone, "n", 2) == NULL);
+    ulSize = 7;
+    assert(FT_statOfIn(oFTJ, &sNone, &ulSize) == NO_SUCH_PATH);
+    assert(ulSize == 7);
+
+    /* removing the file makes handles to it stale, even once the
+       same path is a file again */
+    assert(FT_rmFileIn(oFTJ, "r/a/f") == SUCCESS);
+    assert(FT_statOfIn(oFTJ, &sOpen, &ulSize) == NO_SUCH_PATH);
+    assert(FT_getFileContentsOfIn(oFTJ, &sOpen) == NULL);
+    assert(FT_replaceFileContentsOfIn(oFTJ, &sOpen, "n", 2) == NULL);
+    assert(FT_insertFileIn(oFTJ, "r/a/f", "n", 2) == SUCCESS);
+    assert(FT_statOfIn(oFTJ, &sSame, &ulSize) == NO_SUCH_PATH);
+    sOld = sOpen;
+    assert(FT_openFileIn(oFTJ, "r/a/f", &sOpen) == SUCCESS);
+    assert(FT_getFileContentsOfIn(oFTJ, &sOld) == NULL);
+    assert(!strcmp(FT_getFileContentsOfIn(oFTJ, &sOpen), "n"));
+
+    /* as does removing a directory above it, in the background or
+       not */
+    assert(FT_openFileIn(oFTJ, "r/a/g", &sSame) == SUCCESS);
+    assert(FT_rmDirLaterIn(oFTJ, "r/a") == SUCCESS);
+    assert(FT_statOfIn(oFTJ, &sOpen, &ulSize) == NO_SUCH_PATH);
+    assert(FT_replaceFileContentsOfIn(oFTJ, &sSame, "n", 2) == NULL);
+    assert(FT_insertFileIn(oFTJ, "r/f", "r", 2) == SUCCESS);
+    assert(FT_openFileIn(oFTJ, "r/f", &sOpen) == SUCCESS);
+    assert(FT_rmDirIn(oFTJ, "r") == SUCCESS);
+    assert(FT_getFileContentsOfIn(oFTJ, &sOpen) == NULL);
+    assert(FT_insertDirIn(oFTJ, "r") == SUCCESS);
+    assert(FT_insertFileIn(oFTJ, "r/f", "r", 2) == SUCCESS);
+    assert(FT_statOfIn(oFTJ, &sOpen, &ulSize) == NO_SUCH_PATH);
+    FT_free(oFTJ);
+  }
+
+  /* a FT in an arena behaves as any other, and is freed whole */
+  {
+    FT_T oFTD;
+    boolean bIsFile;
+    size_t ulSize;
+
+    assert((oFTD = FT_newArena()) != NULL);
+    assert(FT_insertDirIn(oFTD, "d/e/f") == SUCCESS);
+    assert(FT_insertDirIn(oFTD, "d/e/f") == ALREADY_IN_TREE);
+    assert(FT_insertFileIn(oFTD, "d/e/g", "xy", 3) == SUCCESS);
+    assert(FT_insertDirIn(oFTD, "x") == CONFLICTING_PATH);
+    assert(FT_containsDirIn(oFTD, "d/e") == TRUE);
+    assert(FT_containsFileIn(oFTD, "d/e/g") == TRUE);
+    assert(FT_containsDir("d/e") == FALSE);
+    assert(FT_statIn(oFTD, "d/e/g", &bIsFile, &ulSize) == SUCCESS);
+    assert(bIsFile == TRUE && ulSize == 3);
+    assert(FT_rmDirIn(oFTD, "d/e/f") == SUCCESS);
+    assert(FT_insertDirIn(oFTD, "d/e/f/h") == SUCCESS);
+    assert(FT_rmDirLaterIn(oFTD, "d/e/f") == SUCCESS);
+    assert((temp = FT_toStringIn(oFTD)) != NULL);
+    assert(!strcmp(temp, "d\nd/e\nd/e/g\n"));
+    free(temp);
+    FT_free(oFTD);
+  }
+  assert(FT_rmDirLater("1root") == SUCCESS);
+  assert(FT_containsDir("1root") == FALSE);
+
+  assert(FT_destroy() == SUCCESS);
+  assert(FT_initArena() == SUCCESS);
+  assert(FT_initArena() == INITIALIZATION_ERROR);
+  assert(FT_init() == INITIALIZATION_ERROR);
+  assert(FT_indexPaths() == SUCCESS);
+  assert(FT_cacheDirs(16) == SUCCESS);
+  assert(FT_filterPaths(16, 0.01) == SUCCESS);
+  assert(FT_insertDir("1root/2child") == SUCCESS);
+  assert(FT_insertFile("1root/2file", "z", 2) == SUCCESS);
+  assert(FT_containsDir("1root/2child") == TRUE);
+  assert(!strcmp(FT_getFileContents("1root/2file"), "z"));
+  assert(FT_openDir("1root/2file", &sDir) == NOT_A_DIRECTORY);
+  assert(FT_openDir("1root/2child", &sDir) == SUCCESS);
+  assert(FT_insertFileAt(&sDir, "3file", "w", 2) == SUCCESS);
+  assert(FT_containsFile("1root/2child/3file") == TRUE);
+  assert(FT_containsAt(&sDir, "3file") == TRUE);
+  assert(FT_rmAt(&sDir, "3file") == SUCCESS);
+  assert(FT_containsAt(&sDir, "3file") == FALSE);
+  assert(FT_rmDir("1root/2child") == SUCCESS);
+  assert(FT_insertFileAt(&sDir, "3file", NULL, 0) == NO_SUCH_PATH);
+  assert(FT_openFile("1root/2child", &sFile) == NO_SUCH_PATH);
+  assert(FT_openFile("1root/2file", &sFile) == SUCCESS);
+  assert(!strcmp(FT_replaceFileContentsOf(&sFile, "y", 2), "z"));
+  assert(!strcmp(FT_getFileContentsOf(&sFile), "y"));
+  assert(FT_statOf(&sFile, &l) == SUCCESS && l == 2);
+  assert(FT_rmFile("1root/2file") == SUCCESS);
+  assert(FT_getFileContentsOf(&sFile) == NULL);
+
   assert(FT_destroy() == SUCCESS);
+  assert(FT_rmDirLater("1root") == INITIALIZATION_ERROR);
+  assert(FT_bulkLoad(NULL, NULL, NULL, NULL, 0) ==
+         INITIALIZATION_ERROR);
+  assert(FT_applyBatch(NULL, 0, NULL) == INITIALIZATION_ERROR);
+  assert(FT_indexPaths() == INITIALIZATION_ERROR);
+  assert(FT_cacheDirs(16) == INITIALIZATION_ERROR);
+  assert(FT_filterPaths(16, 0.01) == INITIALIZATION_ERROR);
+  assert(FT_getCacheStats(&l, &l) == INITIALIZATION_ERROR);
+  assert(FT_openDir("1root", &sDir) == INITIALIZATION_ERROR);
+  assert(FT_insertFileAt(&sDir, "f", NULL, 0) == INITIALIZATION_ERROR);
+  assert(FT_containsAt(&sDir, "f") == FALSE);
+  assert(FT_rmAt(&sDir, "f") == INITIALIZATION_ERROR);
+  assert(FT_openFile("1root/f", &sFile) == INITIALIZATION_ERROR);
+  assert(FT_getFileContentsOf(&sFile) == NULL);
+  assert(FT_replaceFileContentsOf(&sFile, NULL, 0) == NULL);
+  assert(FT_statOf(&sFile, &l) == INITIALIZATION_ERROR);
   assert(FT_destroy() == INITIALIZATION_ERROR);
   assert(FT_containsDir("1root") == FALSE);
   assert(FT_containsFile("1root") == FALSE);
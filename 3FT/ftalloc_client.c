@@ -0,0 +1,159 @@
+/*--------------------------------------------------------------------*/
+/* ftalloc_client.c                                                   */
+/* Author: Maxwell Lloyd and Venus Dinari                             */
+/*--------------------------------------------------------------------*/
+
+#include <assert.h>
+#include <stddef.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "ft.h"
+
+/*
+  This client must be linked with
+     -Wl,--wrap=malloc,--wrap=calloc,--wrap=realloc
+  so that every allocation made by the FT modules is routed through
+  the wrappers below and counted before reaching the real allocator.
+*/
+
+/* the number of allocation requests made so far */
+static size_t ulAllocs = 0;
+
+/* the number of allocation requests to allow before failing one, or
+   0 to fail none */
+static size_t ulFailIn = 0;
+
+void *__real_malloc(size_t ulSize);
+void *__real_calloc(size_t ulCount, size_t ulSize);
+void *__real_realloc(void *pvOld, size_t ulSize);
+
+/* Counts an allocation request, and returns TRUE if it is to fail. */
+static boolean failNext(void) {
+  ulAllocs++;
+  return (boolean) (ulFailIn != 0 && --ulFailIn == 0);
+}
+
+/* Counts, then fails or forwards to the real malloc. */
+void *__wrap_malloc(size_t ulSize) {
+  if(failNext())
+    return NULL;
+  return __real_malloc(ulSize);
+}
+
+/* Counts, then fails or forwards to the real calloc. */
+void *__wrap_calloc(size_t ulCount, size_t ulSize) {
+  if(failNext())
+    return NULL;
+  return __real_calloc(ulCount, ulSize);
+}
+
+/* Counts, then fails or forwards to the real realloc. */
+void *__wrap_realloc(void *pvOld, size_t ulSize) {
+  if(failNext())
+    return NULL;
+  return __real_realloc(pvOld, ulSize);
+}
+
+/*
+  Fails each allocation in turn while FT_bulkLoad loads ppcPaths, a
+  listing of ulCount directories whose last path has several
+  components not yet in the FT, until the load succeeds. Checks that
+  each failure leaves the FT as it was but for the paths before the
+  last. Uses the default FT, which must be initialized.
+*/
+static void testBulkLoadFailures(const char **ppcPaths,
+                                 size_t ulCount) {
+  char *pcBefore;
+  char *pcAfter;
+  size_t ulFail;
+  int iStatus;
+
+  assert(ulCount > 0);
+
+  for(ulFail = 1; ; ulFail++) {
+    pcBefore = FT_toString();
+    assert(pcBefore != NULL);
+
+    ulFailIn = ulFail;
+    iStatus = FT_bulkLoad(ppcPaths, NULL, NULL, NULL, ulCount);
+    ulFailIn = 0;
+    if(iStatus == SUCCESS)
+      break;
+    assert(iStatus == MEMORY_ERROR);
+
+    /* undo the paths that may have loaded before the failing one */
+    if(ulCount > 1)
+      (void) FT_rmDir(ppcPaths[0]);
+    assert(FT_containsDir(ppcPaths[ulCount - 1]) == FALSE);
+    pcAfter = FT_toString();
+    assert(pcAfter != NULL);
+    assert(!strcmp(pcBefore, pcAfter));
+    free(pcAfter);
+    free(pcBefore);
+  }
+  free(pcBefore);
+  assert(FT_containsDir(ppcPaths[ulCount - 1]) == TRUE);
+}
+
+/* Tests that read-only FT queries, whether they hit, miss, or are
+   rejected, make no heap allocations, and that a bulk load that runs
+   out of memory partway down a path adds none of it. Returns 0. */
+int main(void) {
+  const char *apcBelow[] = {"1root/2sib", "1root/2new/3new/4new/5new"};
+  const char *apcRoot[] = {"1new/2new/3new/4new"};
+  size_t ulBefore;
+  boolean bIsFile;
+  size_t l = 0;
+
+  assert(FT_init() == SUCCESS);
+  assert(FT_insertDir("1root/2child/3gkid/4ggk") == SUCCESS);
+  assert(FT_insertFile("1root/2child/3gkid/4ggk/5file", "hello",
+                       strlen("hello")+1) == SUCCESS);
+  assert(FT_insertFile("1root/2child/2sib", NULL, 0) == SUCCESS);
+
+  ulBefore = ulAllocs;
+
+  /* hits */
+  assert(FT_containsDir("1root/2child/3gkid") == TRUE);
+  assert(FT_containsFile("1root/2child/3gkid/4ggk/5file") == TRUE);
+  assert(!strcmp(FT_getFileContents("1root/2child/3gkid/4ggk/5file"),
+                 "hello"));
+  assert(FT_stat("1root/2child/3gkid/4ggk/5file", &bIsFile, &l) ==
+         SUCCESS);
+  assert(bIsFile == TRUE);
+  assert(l == strlen("hello")+1);
+
+  /* misses at every depth, and the wrong flavor */
+  assert(FT_containsFile("1root/2child/3gkid/4ggk/5nope") == FALSE);
+  assert(FT_containsFile("1root/2nope/3gkid") == FALSE);
+  assert(FT_containsDir("1root/2child/2sib") == FALSE);
+  assert(FT_getFileContents("1root/2child/3gkid") == NULL);
+  assert(FT_stat("1root/2child/3nope", &bIsFile, &l) == NO_SUCH_PATH);
+
+  /* rejected paths */
+  assert(FT_containsFile("1root//2child") == FALSE);
+  assert(FT_stat("1root/2child/", &bIsFile, &l) == BAD_PATH);
+  assert(FT_stat("1other/2child", &bIsFile, &l) == CONFLICTING_PATH);
+
+  /* failed insertions are detected before anything is allocated */
+  assert(FT_insertDir("1root/2child/3gkid") == ALREADY_IN_TREE);
+  assert(FT_insertFile("1root/2child/2sib/3f", NULL, 0) ==
+         NOT_A_DIRECTORY);
+
+  fprintf(stderr, "Allocations made by queries: %lu\n",
+          (unsigned long) (ulAllocs - ulBefore));
+  assert(ulAllocs == ulBefore);
+
+  assert(FT_destroy() == SUCCESS);
+
+  /* failures below an existing root, and while adding the root */
+  assert(FT_init() == SUCCESS);
+  assert(FT_insertDir("1root/2child/3gkid") == SUCCESS);
+  testBulkLoadFailures(apcBelow, 2);
+  assert(FT_destroy() == SUCCESS);
+  assert(FT_init() == SUCCESS);
+  testBulkLoadFailures(apcRoot, 1);
+  assert(FT_destroy() == SUCCESS);
+  return 0;
+}
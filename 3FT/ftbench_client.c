@@ -0,0 +1,903 @@
+/*--------------------------------------------------------------------*/
+/* ftbench_client.c                                                   */
+/* Author: Maxwell Lloyd and Venus Dinari                             */
+/*--------------------------------------------------------------------*/
+
+#define _POSIX_C_SOURCE 200112L
+
+#include <pthread.h>
+#include <stddef.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include "ft.h"
+
+/*
+  This client must be linked with the THREADSAFE build of the FT
+  modules. It times two workloads on one FT from increasing numbers of
+  threads: a lookup-heavy mix over a fixed set of files, and inserts
+  and removals that each thread makes in a subtree of its own while
+  one more thread keeps building and removing a chain beside them.
+  It then times building one large directory from a single thread,
+  and its removal, freed at once and freed in the background; freeing
+  a whole FT on the heap and in an arena; loading the same directory
+  from a sorted listing path by path and in bulk; replacing the
+  contents of files deep in the tree one call at a time and in one
+  batch; inserting and removing many files in one deep directory by
+  path and through a directory handle; getting, replacing and
+  statting the contents of deep files by path and through file
+  handles; looking up files beside such files that are not there
+  without and with a path filter, and such files without and with a
+  directory cache, also while another directory is removed and
+  inserted again between lookups, each in a tree of their own; and
+  looking them up without and with the path index, after which both
+  workloads are measured again on the indexed tree. Built as
+  ftbench_malloc, with SLAB_MALLOC defined, it takes every node, path,
+  DynArray and BTree node straight from malloc instead of from slabs,
+  as a baseline.
+*/
+
+/* the number of directories under the root */
+#define DIR_COUNT 64
+/* the number of files in each directory */
+#define FILE_COUNT 64
+/* the number of operations each thread performs */
+#define OPS_PER_THREAD 200000
+/* out of every 100 operations, the number that are lookups */
+#define READ_PERCENT 95
+/* the number of files each thread inserts and removes per round */
+#define HOME_FILES 256
+/* the number of directories and of files in each that the removal
+   measurement builds */
+#define BIG_DIRS 256
+#define BIG_FILES 1024
+/* the largest number of threads measured */
+#define MAX_THREADS 16
+/* the number of lookups between removals in the directory cache
+   measurement */
+#define CHURN_INTERVAL 16
+/* room for a file's absolute path */
+#define MAX_PATH_LENGTH 32
+
+/* the tree under test */
+static FT_T oFTree;
+/* every file's absolute path */
+static char acPaths[DIR_COUNT * FILE_COUNT][MAX_PATH_LENGTH];
+/* the contents every file holds */
+static char acContents[] = "contents";
+/* the number of operations each thread performed, and how many of
+   those failed; the last slot used is the churning thread's */
+static size_t aulDone[MAX_THREADS + 1];
+static size_t aulFailed[MAX_THREADS + 1];
+
+/* Returns the next value of the xorshift generator whose state is
+   *pulState. */
+static unsigned long nextRandom(unsigned long *pulState) {
+  unsigned long ulX = *pulState;
+
+  ulX ^= ulX << 13;
+  ulX ^= ulX >> 7;
+  ulX ^= ulX << 17;
+  *pulState = ulX;
+  return ulX;
+}
+
+/* Returns the wall-clock time in seconds. */
+static double now(void) {
+  struct timespec sTime;
+
+  (void) clock_gettime(CLOCK_MONOTONIC, &sTime);
+  return (double) sTime.tv_sec + (double) sTime.tv_nsec / 1e9;
+}
+
+/* Performs OPS_PER_THREAD operations on random files, READ_PERCENT of
+   them lookups spread over FT_containsFileIn, FT_getFileContentsIn
+   and FT_statIn, and the rest FT_replaceFileContentsIn. pvThread is
+   the thread's index, which seeds its generator and selects its slots
+   in aulDone and aulFailed. Returns NULL. */
+static void *lookupWorker(void *pvThread) {
+  size_t ulThread = (size_t) pvThread;
+  unsigned long ulState = (unsigned long) ulThread * 2654435761UL + 1;
+  unsigned long ulRandom;
+  const char *pcPath;
+  boolean bIsFile;
+  size_t ulSize;
+  size_t ulFailed = 0;
+  size_t i;
+
+  for(i = 0; i < OPS_PER_THREAD; i++) {
+    ulRandom = nextRandom(&ulState);
+    pcPath = acPaths[(ulRandom >> 8) % (DIR_COUNT * FILE_COUNT)];
+    switch(ulRandom % 100 < READ_PERCENT ? ulRandom % 3 : 3) {
+      case 0:
+        ulFailed += FT_containsFileIn(oFTree, pcPath) != TRUE;
+        break;
+      case 1:
+        ulFailed += FT_getFileContentsIn(oFTree, pcPath) != acContents;
+        break;
+      case 2:
+        ulFailed += FT_statIn(oFTree, pcPath, &bIsFile, &ulSize)
+                    != SUCCESS;
+        break;
+      default:
+        ulFailed += FT_replaceFileContentsIn(oFTree, pcPath,
+                                             acContents,
+                                             sizeof(acContents))
+                    != acContents;
+        break;
+    }
+  }
+  aulDone[ulThread] = i;
+  aulFailed[ulThread] = ulFailed;
+  return NULL;
+}
+
+/* Inserts HOME_FILES files into directory "bench/home<pvThread>",
+   which no other thread touches, removes them again, then removes
+   the directory, until about OPS_PER_THREAD operations are done.
+   pvThread selects the thread's slots in aulDone and aulFailed.
+   Returns NULL. */
+static void *homeWorker(void *pvThread) {
+  size_t ulThread = (size_t) pvThread;
+  char acHome[MAX_PATH_LENGTH];
+  char acFile[MAX_PATH_LENGTH];
+  size_t ulFailed = 0;
+  size_t i = 0;
+  size_t j;
+
+  sprintf(acHome, "bench/home%02lu", (unsigned long) ulThread);
+  while(i < OPS_PER_THREAD) {
+    ulFailed += FT_insertDirIn(oFTree, acHome) != SUCCESS;
+    for(j = 0; j < HOME_FILES; j++) {
+      sprintf(acFile, "bench/home%02lu/f%03lu",
+              (unsigned long) ulThread, (unsigned long) j);
+      ulFailed += FT_insertFileIn(oFTree, acFile, acContents,
+                                  sizeof(acContents)) != SUCCESS;
+    }
+    for(j = 0; j < HOME_FILES; j++) {
+      sprintf(acFile, "bench/home%02lu/f%03lu",
+              (unsigned long) ulThread, (unsigned long) j);
+      ulFailed += FT_rmFileIn(oFTree, acFile) != SUCCESS;
+    }
+    ulFailed += FT_rmDirIn(oFTree, acHome) != SUCCESS;
+    i += 2 * HOME_FILES + 2;
+  }
+  aulDone[ulThread] = i;
+  aulFailed[ulThread] = ulFailed;
+  return NULL;
+}
+
+/* Builds a chain of directories under "bench/tmp", looks down it, and
+   removes the whole chain with one FT_rmDirIn, OPS_PER_THREAD / 4
+   times, so that subtrees are freed while other threads traverse
+   their ancestors. pvThread selects the thread's slots in aulDone and
+   aulFailed. Returns NULL. */
+static void *churnWorker(void *pvThread) {
+  size_t ulThread = (size_t) pvThread;
+  size_t ulFailed = 0;
+  size_t i;
+
+  for(i = 0; i < OPS_PER_THREAD; i += 4) {
+    ulFailed += FT_insertDirIn(oFTree, "bench/tmp/a/b/c/d") != SUCCESS;
+    ulFailed += FT_insertFileIn(oFTree, "bench/tmp/a/b/c/d/e", NULL, 0)
+                != SUCCESS;
+    ulFailed += FT_containsFileIn(oFTree, "bench/tmp/a/b/c/d/e") != TRUE;
+    ulFailed += FT_rmDirIn(oFTree, "bench/tmp") != SUCCESS;
+  }
+  aulDone[ulThread] = i;
+  aulFailed[ulThread] = ulFailed;
+  return NULL;
+}
+
+/* Runs pfWorker on ulThreads threads at once, plus churnWorker on one
+   more if bChurn. Returns the number of operations performed per
+   second, or a negative number if a thread could not be created or
+   an operation failed. */
+static double runRound(void *(*pfWorker)(void *), size_t ulThreads,
+                       boolean bChurn) {
+  pthread_t aThreads[MAX_THREADS + 1];
+  size_t ulAll = ulThreads + (bChurn ? 1 : 0);
+  size_t ulDone = 0;
+  size_t ulFailed = 0;
+  size_t i;
+  double dStart;
+
+  dStart = now();
+  for(i = 0; i < ulAll; i++) {
+    if(pthread_create(&aThreads[i], NULL,
+                      i < ulThreads ? pfWorker : churnWorker,
+                      (void *) i) != 0)
+      return -1;
+  }
+  for(i = 0; i < ulAll; i++) {
+    (void) pthread_join(aThreads[i], NULL);
+    ulDone += aulDone[i];
+    ulFailed += aulFailed[i];
+  }
+  if(ulFailed != 0) {
+    fprintf(stderr, "%lu operations failed\n", (unsigned long) ulFailed);
+    return -1;
+  }
+  return (double) ulDone / (now() - dStart);
+}
+
+/* Runs pfWorker, plus churnWorker if bChurn, on 1, 2, 4, ...
+   MAX_THREADS threads and prints the throughput of each run under
+   heading pcTitle. Returns 0, or 1 if a run failed. */
+static int measure(const char *pcTitle, void *(*pfWorker)(void *),
+                   boolean bChurn) {
+  size_t ulThreads;
+  double dRate;
+  double dBaseRate = 0;
+
+  printf("%s\n", pcTitle);
+  for(ulThreads = 1; ulThreads <= MAX_THREADS; ulThreads *= 2) {
+    dRate = runRound(pfWorker, ulThreads, bChurn);
+    if(dRate < 0)
+      return 1;
+    if(ulThreads == 1)
+      dBaseRate = dRate;
+    printf("%2lu threads: %10.0f ops/s  %5.2fx\n",
+           (unsigned long) ulThreads, dRate, dRate / dBaseRate);
+  }
+  return 0;
+}
+
+/* Builds "bench/big", a directory of BIG_DIRS directories of
+   BIG_FILES files each, in oFTree. Returns TRUE if every insert
+   succeeded. */
+static boolean buildBig(void) {
+  char acPath[MAX_PATH_LENGTH];
+  size_t i, j;
+
+  for(i = 0; i < BIG_DIRS; i++) {
+    sprintf(acPath, "bench/big/d%03lu", (unsigned long) i);
+    if(FT_insertDirIn(oFTree, acPath) != SUCCESS)
+      return FALSE;
+    for(j = 0; j < BIG_FILES; j++) {
+      sprintf(acPath, "bench/big/d%03lu/f%04lu", (unsigned long) i,
+              (unsigned long) j);
+      if(FT_insertFileIn(oFTree, acPath, acContents,
+                         sizeof(acContents)) != SUCCESS)
+        return FALSE;
+    }
+  }
+  return TRUE;
+}
+
+/* Times building "bench/big" from one thread, then its removal by
+   FT_rmDirIn, then building it again and its removal by
+   FT_rmDirLaterIn, as seen by the caller, and prints the times.
+   Returns 0, or 1 if the directory could not be built or removed. */
+static int measureRemoval(void) {
+  double dStart, dBuild, dNow, dRebuild, dLater;
+
+  printf("building and removing a directory of %d nodes:\n",
+         BIG_DIRS * (BIG_FILES + 1) + 1);
+  dStart = now();
+  if(!buildBig())
+    return 1;
+  dBuild = now() - dStart;
+  dStart = now();
+  if(FT_rmDirIn(oFTree, "bench/big") != SUCCESS)
+    return 1;
+  dNow = now() - dStart;
+
+  dStart = now();
+  if(!buildBig())
+    return 1;
+  dRebuild = now() - dStart;
+  dStart = now();
+  if(FT_rmDirLaterIn(oFTree, "bench/big") != SUCCESS)
+    return 1;
+  dLater = now() - dStart;
+
+  printf("first build:     %10.6f s\n", dBuild);
+  printf("FT_rmDirIn:      %10.6f s\n", dNow);
+  printf("second build:    %10.6f s\n", dRebuild);
+  printf("FT_rmDirLaterIn: %10.6f s\n", dLater);
+  return 0;
+}
+
+/* Times building "bench/big" in a new FT on the heap and freeing it
+   with FT_free, then the same for a new FT in an arena, and prints the
+   times. Uses oFTree for each new FT and restores it afterward.
+   Returns 0, or 1 if a tree could not be built. */
+static int measureTeardown(void) {
+  FT_T oFTSaved = oFTree;
+  double adBuild[2], adFree[2], dStart;
+  size_t i;
+
+  printf("building and freeing a FT of %d nodes:\n",
+         BIG_DIRS * (BIG_FILES + 1) + 2);
+  for(i = 0; i < 2; i++) {
+    oFTree = i == 0 ? FT_new() : FT_newArena();
+    dStart = now();
+    if(oFTree == NULL || FT_insertDirIn(oFTree, "bench") != SUCCESS ||
+       !buildBig()) {
+      oFTree = oFTSaved;
+      return 1;
+    }
+    adBuild[i] = now() - dStart;
+    dStart = now();
+    FT_free(oFTree);
+    adFree[i] = now() - dStart;
+  }
+  oFTree = oFTSaved;
+
+  printf("heap build:      %10.6f s\n", adBuild[0]);
+  printf("heap FT_free:    %10.6f s\n", adFree[0]);
+  printf("arena build:     %10.6f s\n", adBuild[1]);
+  printf("arena FT_free:   %10.6f s\n", adFree[1]);
+  return 0;
+}
+
+/* Times loading the sorted listing of "bench/big", with the two
+   directories above it, into a new FT one path at a time and then into
+   another with FT_bulkLoadIn, and prints the times. Returns 0, or 1 if
+   memory ran out or a load failed. */
+static int measureBulkLoad(void) {
+  enum { PATH_COUNT = BIG_DIRS * (BIG_FILES + 1) + 2 };
+  char *pcPaths;
+  const char **ppcPaths;
+  boolean *pbIsFile;
+  FT_T oFTLoaded;
+  double dStart, dEach, dBulk;
+  size_t i, j, ulPath;
+  int iStatus = SUCCESS;
+
+  pcPaths = malloc(PATH_COUNT * MAX_PATH_LENGTH);
+  ppcPaths = malloc(PATH_COUNT * sizeof(const char *));
+  pbIsFile = malloc(PATH_COUNT * sizeof(boolean));
+  if(pcPaths == NULL || ppcPaths == NULL || pbIsFile == NULL)
+    return 1;
+  for(i = 0; i < PATH_COUNT; i++) {
+    ppcPaths[i] = pcPaths + i * MAX_PATH_LENGTH;
+    pbIsFile[i] = FALSE;
+  }
+  sprintf(pcPaths, "bench");
+  sprintf(pcPaths + MAX_PATH_LENGTH, "bench/big");
+  ulPath = 2;
+  for(i = 0; i < BIG_DIRS; i++) {
+    sprintf(pcPaths + ulPath++ * MAX_PATH_LENGTH, "bench/big/d%03lu",
+            (unsigned long) i);
+    for(j = 0; j < BIG_FILES; j++) {
+      pbIsFile[ulPath] = TRUE;
+      sprintf(pcPaths + ulPath++ * MAX_PATH_LENGTH,
+              "bench/big/d%03lu/f%04lu", (unsigned long) i,
+              (unsigned long) j);
+    }
+  }
+
+  printf("loading a sorted listing of %d paths:\n", PATH_COUNT);
+  oFTLoaded = FT_new();
+  dStart = now();
+  for(i = 0; i < PATH_COUNT && oFTLoaded != NULL &&
+        iStatus == SUCCESS; i++)
+    iStatus = pbIsFile[i] ?
+      FT_insertFileIn(oFTLoaded, ppcPaths[i], acContents,
+                      sizeof(acContents)) :
+      FT_insertDirIn(oFTLoaded, ppcPaths[i]);
+  dEach = now() - dStart;
+  FT_free(oFTLoaded);
+
+  oFTLoaded = iStatus == SUCCESS ? FT_new() : NULL;
+  dStart = now();
+  if(oFTLoaded != NULL)
+    iStatus = FT_bulkLoadIn(oFTLoaded, ppcPaths, pbIsFile, NULL, NULL,
+                            PATH_COUNT);
+  dBulk = now() - dStart;
+  FT_free(oFTLoaded);
+
+  free(pcPaths);
+  free(ppcPaths);
+  free(pbIsFile);
+  if(oFTLoaded == NULL || iStatus != SUCCESS)
+    return 1;
+  printf("path by path:    %10.6f s\n", dEach);
+  printf("FT_bulkLoadIn:   %10.6f s\n", dBulk);
+  return 0;
+}
+
+/* Builds DIR_COUNT directories of FILE_COUNT files each deep under
+   a chain of directories, replaces the contents of every file in a
+   scattered order, one call per file and then in one FT_applyBatchIn,
+   and prints both times. Returns 0, or 1 if a change failed. */
+static int measureBatch(void) {
+  enum { OP_COUNT = DIR_COUNT * FILE_COUNT, STRIDE = 1021,
+         DEEP_PATH_LENGTH = 64 };
+  char *pcPaths;
+  FT_Op *psOps;
+  int *piResults;
+  double dStart, dEach, dBatch;
+  size_t i;
+  int iStatus = SUCCESS;
+
+  pcPaths = malloc(OP_COUNT * DEEP_PATH_LENGTH);
+  psOps = malloc(OP_COUNT * sizeof(FT_Op));
+  piResults = malloc(OP_COUNT * sizeof(int));
+  if(pcPaths == NULL || psOps == NULL || piResults == NULL)
+    return 1;
+  for(i = 0; i < OP_COUNT && iStatus == SUCCESS; i++) {
+    sprintf(pcPaths + i * DEEP_PATH_LENGTH,
+            "bench/deep/a/b/c/d/e/f/d%02lu/f%02lu",
+            (unsigned long) (i / FILE_COUNT),
+            (unsigned long) (i % FILE_COUNT));
+    iStatus = FT_insertFileIn(oFTree, pcPaths + i * DEEP_PATH_LENGTH,
+                              acContents, sizeof(acContents));
+  }
+  for(i = 0; i < OP_COUNT; i++) {
+    psOps[i].eKind = FT_OP_REPLACE_CONTENTS;
+    psOps[i].pcPath = pcPaths + i * STRIDE % OP_COUNT * DEEP_PATH_LENGTH;
+    psOps[i].pvContents = acContents;
+    psOps[i].ulLength = sizeof(acContents);
+    psOps[i].ppvOldContents = NULL;
+  }
+
+  printf("replacing the contents of %d files 10 levels deep "
+         "in scattered order:\n", OP_COUNT);
+  dStart = now();
+  for(i = 0; i < OP_COUNT && iStatus == SUCCESS; i++)
+    if(FT_replaceFileContentsIn(oFTree, psOps[i].pcPath, acContents,
+                                sizeof(acContents)) != acContents)
+      iStatus = NO_SUCH_PATH;
+  dEach = now() - dStart;
+
+  dStart = now();
+  if(iStatus == SUCCESS)
+    iStatus = FT_applyBatchIn(oFTree, psOps, OP_COUNT, piResults);
+  dBatch = now() - dStart;
+
+  if(iStatus == SUCCESS)
+    iStatus = FT_rmDirIn(oFTree, "bench/deep");
+  free(pcPaths);
+  free(psOps);
+  free(piResults);
+  if(iStatus != SUCCESS)
+    return 1;
+  printf("file by file:    %10.6f s\n", dEach);
+  printf("FT_applyBatchIn: %10.6f s\n", dBatch);
+  return 0;
+}
+
+/* Inserts HANDLE_FILES files into one directory 10 levels deep and
+   removes them, by path and then through a handle to the directory,
+   and prints the times. Returns 0, or 1 if a change failed. */
+static int measureHandles(void) {
+  enum { HANDLE_FILES = 8 * DIR_COUNT * FILE_COUNT,
+         DEEP_PATH_LENGTH = 64 };
+  const char *pcDir = "bench/deep/a/b/c/d/e/f/g/h";
+  char *pcPaths;
+  FT_Dir sDir;
+  double dStart;
+  double adInserted[2] = { -1, -1 }, adRemoved[2] = { -1, -1 };
+  size_t ulDirLength;
+  size_t i;
+  int iStatus;
+
+  pcPaths = malloc(HANDLE_FILES * DEEP_PATH_LENGTH);
+  if(pcPaths == NULL)
+    return 1;
+  ulDirLength = strlen(pcDir) + 1;
+  for(i = 0; i < HANDLE_FILES; i++)
+    sprintf(pcPaths + i * DEEP_PATH_LENGTH, "%s/f%05lu", pcDir,
+            (unsigned long) i);
+  iStatus = FT_insertDirIn(oFTree, pcDir);
+
+  dStart = now();
+  for(i = 0; i < HANDLE_FILES && iStatus == SUCCESS; i++)
+    iStatus = FT_insertFileIn(oFTree, pcPaths + i * DEEP_PATH_LENGTH,
+                              acContents, sizeof(acContents));
+  adInserted[0] = now() - dStart;
+  dStart = now();
+  for(i = 0; i < HANDLE_FILES && iStatus == SUCCESS; i++)
+    iStatus = FT_rmFileIn(oFTree, pcPaths + i * DEEP_PATH_LENGTH);
+  adRemoved[0] = now() - dStart;
+
+  /* the names alone, after the directory's path */
+  if(iStatus == SUCCESS)
+    iStatus = FT_openDirIn(oFTree, pcDir, &sDir);
+  dStart = now();
+  for(i = 0; i < HANDLE_FILES && iStatus == SUCCESS; i++)
+    iStatus = FT_insertFileAtIn(oFTree, &sDir,
+                                pcPaths + i * DEEP_PATH_LENGTH +
+                                ulDirLength,
+                                acContents, sizeof(acContents));
+  adInserted[1] = now() - dStart;
+  dStart = now();
+  for(i = 0; i < HANDLE_FILES && iStatus == SUCCESS; i++)
+    iStatus = FT_rmAtIn(oFTree, &sDir,
+                        pcPaths + i * DEEP_PATH_LENGTH + ulDirLength);
+  adRemoved[1] = now() - dStart;
+
+  if(iStatus == SUCCESS)
+    iStatus = FT_rmDirIn(oFTree, "bench/deep");
+  free(pcPaths);
+  if(iStatus != SUCCESS)
+    return 1;
+
+  printf("inserting and removing %d files 10 levels deep:\n",
+         HANDLE_FILES);
+  printf("by path:         %10.6f s %10.6f s\n", adInserted[0],
+         adRemoved[0]);
+  printf("by handle:       %10.6f s %10.6f s\n", adInserted[1],
+         adRemoved[1]);
+  return 0;
+}
+
+/* Builds DIR_COUNT directories of FILE_COUNT files each deep under
+   a chain of directories, then gets, replaces and stats the contents
+   of every file FILE_ROUNDS times in a scattered order, by path and
+   then through a handle to each file, and prints the times. Returns
+   0, or 1 if a call failed. */
+static int measureFileHandles(void) {
+  enum { FILE_TOTAL = DIR_COUNT * FILE_COUNT, FILE_ROUNDS = 8,
+         STRIDE = 1021, DEEP_PATH_LENGTH = 64 };
+  char *pcPaths;
+  FT_File *psFiles;
+  double dStart;
+  double adGot[2] = { -1, -1 }, adReplaced[2] = { -1, -1 },
+    adStated[2] = { -1, -1 };
+  boolean bIsFile;
+  size_t ulSize;
+  size_t i;
+  int iStatus = SUCCESS;
+
+  pcPaths = malloc(FILE_TOTAL * DEEP_PATH_LENGTH);
+  psFiles = malloc(FILE_TOTAL * sizeof(FT_File));
+  if(pcPaths == NULL || psFiles == NULL)
+    return 1;
+  for(i = 0; i < FILE_TOTAL && iStatus == SUCCESS; i++) {
+    sprintf(pcPaths + i * DEEP_PATH_LENGTH,
+            "bench/deep/a/b/c/d/e/f/d%02lu/f%02lu",
+            (unsigned long) (i / FILE_COUNT),
+            (unsigned long) (i % FILE_COUNT));
+    iStatus = FT_insertFileIn(oFTree, pcPaths + i * DEEP_PATH_LENGTH,
+                              acContents, sizeof(acContents));
+    if(iStatus == SUCCESS)
+      iStatus = FT_openFileIn(oFTree, pcPaths + i * DEEP_PATH_LENGTH,
+                              &psFiles[i]);
+  }
+
+  dStart = now();
+  for(i = 0; i < FILE_ROUNDS * FILE_TOTAL && iStatus == SUCCESS; i++)
+    if(FT_getFileContentsIn(oFTree, pcPaths + i * STRIDE % FILE_TOTAL *
+                            DEEP_PATH_LENGTH) != acContents)
+      iStatus = NO_SUCH_PATH;
+  adGot[0] = now() - dStart;
+  dStart = now();
+  for(i = 0; i < FILE_ROUNDS * FILE_TOTAL && iStatus == SUCCESS; i++)
+    if(FT_replaceFileContentsIn(oFTree, pcPaths + i * STRIDE %
+                                FILE_TOTAL * DEEP_PATH_LENGTH,
+                                acContents, sizeof(acContents)) !=
+       acContents)
+      iStatus = NO_SUCH_PATH;
+  adReplaced[0] = now() - dStart;
+  dStart = now();
+  for(i = 0; i < FILE_ROUNDS * FILE_TOTAL && iStatus == SUCCESS; i++)
+    iStatus = FT_statIn(oFTree, pcPaths + i * STRIDE % FILE_TOTAL *
+                        DEEP_PATH_LENGTH, &bIsFile, &ulSize);
+  adStated[0] = now() - dStart;
+
+  dStart = now();
+  for(i = 0; i < FILE_ROUNDS * FILE_TOTAL && iStatus == SUCCESS; i++)
+    if(FT_getFileContentsOfIn(oFTree,
+                              &psFiles[i * STRIDE % FILE_TOTAL]) !=
+       acContents)
+      iStatus = NO_SUCH_PATH;
+  adGot[1] = now() - dStart;
+  dStart = now();
+  for(i = 0; i < FILE_ROUNDS * FILE_TOTAL && iStatus == SUCCESS; i++)
+    if(FT_replaceFileContentsOfIn(oFTree,
+                                  &psFiles[i * STRIDE % FILE_TOTAL],
+                                  acContents, sizeof(acContents)) !=
+       acContents)
+      iStatus = NO_SUCH_PATH;
+  adReplaced[1] = now() - dStart;
+  dStart = now();
+  for(i = 0; i < FILE_ROUNDS * FILE_TOTAL && iStatus == SUCCESS; i++)
+    iStatus = FT_statOfIn(oFTree, &psFiles[i * STRIDE % FILE_TOTAL],
+                          &ulSize);
+  adStated[1] = now() - dStart;
+
+  if(iStatus == SUCCESS)
+    iStatus = FT_rmDirIn(oFTree, "bench/deep");
+  free(pcPaths);
+  free(psFiles);
+  if(iStatus != SUCCESS)
+    return 1;
+
+  printf("getting, replacing and statting the contents of %d files "
+         "10 levels deep %d times:\n", FILE_TOTAL, FILE_ROUNDS);
+  printf("by path:         %10.6f s %10.6f s %10.6f s\n", adGot[0],
+         adReplaced[0], adStated[0]);
+  printf("by handle:       %10.6f s %10.6f s %10.6f s\n", adGot[1],
+         adReplaced[1], adStated[1]);
+  return 0;
+}
+
+/* Returns the time FT_containsFileIn takes to look up OPS_PER_THREAD
+   files chosen at random among the ulCount at pcPaths, each at a
+   multiple of ulStride, or a negative time if one is found when
+   bPresent is FALSE or not found when it is TRUE. */
+static double timeLookups(const char *pcPaths, size_t ulCount,
+                          size_t ulStride, boolean bPresent) {
+  unsigned long ulState = 88172645463325252UL;
+  size_t ulFailed = 0;
+  size_t i;
+  double dStart;
+
+  dStart = now();
+  for(i = 0; i < OPS_PER_THREAD; i++)
+    ulFailed += FT_containsFileIn(oFTree, pcPaths +
+                   (nextRandom(&ulState) >> 8) % ulCount * ulStride)
+                != bPresent;
+  return ulFailed == 0 ? now() - dStart : -1;
+}
+
+/* Builds DIR_COUNT directories of FILE_COUNT files each deep under
+   a chain of directories in an FT of their own, times lookups of as
+   many files that are not there, beside them, and of the files that
+   are there, before and after giving the FT a path filter, and prints
+   the results. Returns 0, or 1 if a change or lookup failed. */
+static int measureFilter(void) {
+  enum { FILE_TOTAL = DIR_COUNT * FILE_COUNT, DEEP_PATH_LENGTH = 64 };
+  FT_T oFTSaved = oFTree;
+  char *pcPaths;
+  char *pcMissing;
+  double adMissing[2] = { -1, -1 }, adPresent[2] = { -1, -1 };
+  size_t i;
+  int iStatus = SUCCESS;
+
+  pcPaths = malloc(2 * FILE_TOTAL * DEEP_PATH_LENGTH);
+  pcMissing = pcPaths + FILE_TOTAL * DEEP_PATH_LENGTH;
+  oFTree = FT_new();
+  if(pcPaths == NULL || oFTree == NULL)
+    iStatus = MEMORY_ERROR;
+  else
+    iStatus = FT_insertDirIn(oFTree, "bench");
+  for(i = 0; i < FILE_TOTAL && iStatus == SUCCESS; i++) {
+    sprintf(pcPaths + i * DEEP_PATH_LENGTH,
+            "bench/deep/a/b/c/d/e/f/d%02lu/f%02lu",
+            (unsigned long) (i / FILE_COUNT),
+            (unsigned long) (i % FILE_COUNT));
+    sprintf(pcMissing + i * DEEP_PATH_LENGTH,
+            "bench/deep/a/b/c/d/e/f/d%02lu/g%02lu",
+            (unsigned long) (i / FILE_COUNT),
+            (unsigned long) (i % FILE_COUNT));
+    iStatus = FT_insertFileIn(oFTree, pcPaths + i * DEEP_PATH_LENGTH,
+                              acContents, sizeof(acContents));
+  }
+
+  for(i = 0; i < 2 && iStatus == SUCCESS; i++) {
+    if(i == 1)
+      iStatus = FT_filterPathsIn(oFTree, 2 * FILE_TOTAL, 0.01);
+    if(iStatus == SUCCESS) {
+      adMissing[i] = timeLookups(pcMissing, FILE_TOTAL,
+                                 DEEP_PATH_LENGTH, FALSE);
+      adPresent[i] = timeLookups(pcPaths, FILE_TOTAL,
+                                 DEEP_PATH_LENGTH, TRUE);
+    }
+  }
+  FT_free(oFTree);
+  oFTree = oFTSaved;
+  free(pcPaths);
+  if(adMissing[1] < 0 || adPresent[0] < 0 || adPresent[1] < 0)
+    return 1;
+
+  printf("looking up files 10 levels deep %d times, "
+         "missing and present:\n", OPS_PER_THREAD);
+  printf("level by level:  %10.6f s %10.6f s\n", adMissing[0],
+         adPresent[0]);
+  printf("path filter:     %10.6f s %10.6f s\n", adMissing[1],
+         adPresent[1]);
+  return 0;
+}
+
+/* Does what timeLookups does for files that are there, but also
+   removes the directory pcChurned and inserts it again after every
+   CHURN_INTERVAL lookups, and returns a negative time if that
+   fails. */
+static double timeChurnedLookups(const char *pcPaths, size_t ulCount,
+                                 size_t ulStride,
+                                 const char *pcChurned) {
+  unsigned long ulState = 88172645463325252UL;
+  size_t ulFailed = 0;
+  size_t i;
+  double dStart;
+
+  dStart = now();
+  for(i = 0; i < OPS_PER_THREAD; i++) {
+    ulFailed += FT_containsFileIn(oFTree, pcPaths +
+                   (nextRandom(&ulState) >> 8) % ulCount * ulStride)
+                != TRUE;
+    if(i % CHURN_INTERVAL == CHURN_INTERVAL - 1)
+      ulFailed += (FT_rmDirIn(oFTree, pcChurned) != SUCCESS) +
+                  (FT_insertDirIn(oFTree, pcChurned) != SUCCESS);
+  }
+  return ulFailed == 0 ? now() - dStart : -1;
+}
+
+/* Builds DIR_COUNT directories of FILE_COUNT files each deep under
+   a chain of directories in an FT of their own, times lookups of them
+   before and after giving it a directory cache, alone and with
+   another directory removed and inserted again between them, and
+   prints the results. Returns 0, or 1 if a change or lookup
+   failed. */
+static int measureCache(void) {
+  enum { FILE_TOTAL = DIR_COUNT * FILE_COUNT, DEEP_PATH_LENGTH = 64,
+         CACHE_SLOTS = 1024 };
+  static const char acChurned[] = "bench/deep/a/b/c/d/e/f/churn/x";
+  FT_T oFTSaved = oFTree;
+  char *pcPaths;
+  double dWalked = -1, dCached = -1;
+  double dChurnWalked = -1, dChurnCached = -1;
+  size_t ulHits = 0, ulMisses = 0;
+  size_t ulChurnHits = 0, ulChurnMisses = 0;
+  size_t i;
+  int iStatus = SUCCESS;
+
+  pcPaths = malloc(FILE_TOTAL * DEEP_PATH_LENGTH);
+  oFTree = FT_new();
+  if(pcPaths == NULL || oFTree == NULL)
+    iStatus = MEMORY_ERROR;
+  else
+    iStatus = FT_insertDirIn(oFTree, "bench");
+  for(i = 0; i < FILE_TOTAL && iStatus == SUCCESS; i++) {
+    sprintf(pcPaths + i * DEEP_PATH_LENGTH,
+            "bench/deep/a/b/c/d/e/f/d%02lu/f%02lu",
+            (unsigned long) (i / FILE_COUNT),
+            (unsigned long) (i % FILE_COUNT));
+    iStatus = FT_insertFileIn(oFTree, pcPaths + i * DEEP_PATH_LENGTH,
+                              acContents, sizeof(acContents));
+  }
+
+  if(iStatus == SUCCESS)
+    iStatus = FT_insertDirIn(oFTree, acChurned);
+
+  if(iStatus == SUCCESS) {
+    dWalked = timeLookups(pcPaths, FILE_TOTAL, DEEP_PATH_LENGTH, TRUE);
+    dChurnWalked = timeChurnedLookups(pcPaths, FILE_TOTAL,
+                                      DEEP_PATH_LENGTH, acChurned);
+  }
+  if(dWalked >= 0 && dChurnWalked >= 0)
+    iStatus = FT_cacheDirsIn(oFTree, CACHE_SLOTS);
+  if(dWalked >= 0 && dChurnWalked >= 0 && iStatus == SUCCESS) {
+    dCached = timeLookups(pcPaths, FILE_TOTAL, DEEP_PATH_LENGTH, TRUE);
+    (void) FT_getCacheStatsIn(oFTree, &ulHits, &ulMisses);
+    dChurnCached = timeChurnedLookups(pcPaths, FILE_TOTAL,
+                                      DEEP_PATH_LENGTH, acChurned);
+    (void) FT_getCacheStatsIn(oFTree, &ulChurnHits, &ulChurnMisses);
+    ulChurnHits -= ulHits;
+    ulChurnMisses -= ulMisses;
+  }
+  FT_free(oFTree);
+  oFTree = oFTSaved;
+  free(pcPaths);
+  if(dWalked < 0 || dCached < 0 || dChurnWalked < 0 ||
+     dChurnCached < 0)
+    return 1;
+
+  printf("looking up files 10 levels deep %d times:\n", OPS_PER_THREAD);
+  printf("level by level:  %10.6f s\n", dWalked);
+  printf("directory cache: %10.6f s (%lu hits, %lu misses)\n", dCached,
+         (unsigned long) ulHits, (unsigned long) ulMisses);
+  printf("looking up files 10 levels deep %d times, removing another "
+         "directory every %d:\n", OPS_PER_THREAD, CHURN_INTERVAL);
+  printf("level by level:  %10.6f s\n", dChurnWalked);
+  printf("directory cache: %10.6f s (%lu hits, %lu misses)\n",
+         dChurnCached, (unsigned long) ulChurnHits,
+         (unsigned long) ulChurnMisses);
+  return 0;
+}
+
+/* Builds DIR_COUNT directories of FILE_COUNT files each deep under
+   a chain of directories, times lookups of them before and after
+   indexing the tree by path, then measures both workloads again on
+   the indexed tree, and prints the results. Returns 0, or 1 if a
+   change or lookup failed. */
+static int measureIndex(void) {
+  enum { FILE_TOTAL = DIR_COUNT * FILE_COUNT, DEEP_PATH_LENGTH = 64 };
+  char *pcPaths;
+  double dWalked, dIndexed;
+  size_t i;
+  int iStatus = SUCCESS;
+
+  pcPaths = malloc(FILE_TOTAL * DEEP_PATH_LENGTH);
+  if(pcPaths == NULL)
+    return 1;
+  for(i = 0; i < FILE_TOTAL && iStatus == SUCCESS; i++) {
+    sprintf(pcPaths + i * DEEP_PATH_LENGTH,
+            "bench/deep/a/b/c/d/e/f/d%02lu/f%02lu",
+            (unsigned long) (i / FILE_COUNT),
+            (unsigned long) (i % FILE_COUNT));
+    iStatus = FT_insertFileIn(oFTree, pcPaths + i * DEEP_PATH_LENGTH,
+                              acContents, sizeof(acContents));
+  }
+
+  dWalked = iStatus == SUCCESS ?
+    timeLookups(pcPaths, FILE_TOTAL, DEEP_PATH_LENGTH, TRUE) : -1;
+  if(dWalked >= 0)
+    iStatus = FT_indexPathsIn(oFTree);
+  dIndexed = iStatus == SUCCESS ?
+    timeLookups(pcPaths, FILE_TOTAL, DEEP_PATH_LENGTH, TRUE) : -1;
+  if(dIndexed >= 0)
+    iStatus = FT_rmDirIn(oFTree, "bench/deep");
+  free(pcPaths);
+  if(dWalked < 0 || dIndexed < 0 || iStatus != SUCCESS)
+    return 1;
+
+  printf("looking up files 10 levels deep %d times:\n", OPS_PER_THREAD);
+  printf("level by level:  %10.6f s\n", dWalked);
+  printf("path index:      %10.6f s\n", dIndexed);
+  if(measure("lookups (95%) and replacements (5%), path index:",
+             lookupWorker, FALSE) != 0)
+    return 1;
+  return measure("inserts and removals in disjoint subtrees, "
+                 "path index:", homeWorker, TRUE);
+}
+
+/* Builds an FT of DIR_COUNT directories of FILE_COUNT files each,
+   measures both workloads on it, and prints the results to stdout.
+   Returns 0, or 1 if the tree could not be built or a run failed. */
+int main(void) {
+  char acDir[MAX_PATH_LENGTH];
+  size_t i, j;
+  int iStatus;
+
+  oFTree = FT_new();
+  if(oFTree == NULL || FT_insertDirIn(oFTree, "bench") != SUCCESS) {
+    fprintf(stderr, "could not build the tree\n");
+    return 1;
+  }
+  for(i = 0; i < DIR_COUNT; i++) {
+    sprintf(acDir, "bench/d%02lu", (unsigned long) i);
+    iStatus = FT_insertDirIn(oFTree, acDir);
+    for(j = 0; j < FILE_COUNT && iStatus == SUCCESS; j++) {
+      sprintf(acPaths[i * FILE_COUNT + j], "%s/f%02lu", acDir,
+              (unsigned long) j);
+      iStatus = FT_insertFileIn(oFTree, acPaths[i * FILE_COUNT + j],
+                                acContents, sizeof(acContents));
+    }
+    if(iStatus != SUCCESS) {
+      fprintf(stderr, "could not build the tree\n");
+      return 1;
+    }
+  }
+
+#ifdef SLAB_MALLOC
+  printf("objects from malloc, not slabs\n");
+#endif
+  printf("%d files, %d operations per thread, %ld online processors\n",
+         DIR_COUNT * FILE_COUNT, OPS_PER_THREAD,
+         sysconf(_SC_NPROCESSORS_ONLN));
+  if(measure("lookups (95%) and replacements (5%):", lookupWorker,
+             FALSE) != 0)
+    return 1;
+  if(measure("inserts and removals in disjoint subtrees:", homeWorker,
+             TRUE) != 0)
+    return 1;
+  if(measureRemoval() != 0)
+    return 1;
+  if(measureTeardown() != 0)
+    return 1;
+  if(measureBulkLoad() != 0)
+    return 1;
+  if(measureBatch() != 0)
+    return 1;
+  if(measureHandles() != 0)
+    return 1;
+  if(measureFileHandles() != 0)
+    return 1;
+  if(measureFilter() != 0)
+    return 1;
+  if(measureCache() != 0)
+    return 1;
+  if(measureIndex() != 0)
+    return 1;
+
+  FT_free(oFTree);
+  return 0;
+}
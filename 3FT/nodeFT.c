@@ -3,327 +3,2395 @@
 /* Author: Maxwell Lloyd and Venus Dinari                             */
 /*--------------------------------------------------------------------*/
 
+#ifdef THREADSAFE
+#define _POSIX_C_SOURCE 200112L
+#include <pthread.h>
+#endif
 #include <stdlib.h>
 #include <assert.h>
+#include <limits.h>
 #include <string.h>
-#include "dynarray.h"
+#include "arena.h"
+#include "atom.h"
+#include "btree.h"
+#include "epoch.h"
 #include "nodeFT.h"
+#include "slab.h"
 
 
-/* A node in a FT */
+/*
+  A directory's children are kept in a BTree sorted by name, so that
+  adding or removing one takes O(log n) time at any size. Once a
+  directory has more than INDEX_THRESHOLD children, an open-addressing
+  hash index keyed by name atom is also built over them, so that
+  lookups take expected constant time. The index is dropped again when
+  the directory shrinks below half the threshold.
+
+  In the THREADSAFE build, lookups that hold no lock probe only the
+  index, so every directory with children is indexed and no index is
+  ever dropped. A removed child leaves a vacated marker in its slot
+  rather than moving other entries, so that a concurrent probe never
+  misses an entry that is present, and a replaced index is retired to
+  the epoch collector rather than freed.
+*/
+#ifdef THREADSAFE
+enum { INDEX_THRESHOLD = 0 };
+#else
+enum { INDEX_THRESHOLD = 64 };
+#endif
+enum { INDEX_MIN_SIZE = 8 };
+
+/* A hash index of a directory's children. */
+struct Index {
+   /* the arena the index was allocated from, or NULL */
+   struct Arena *psArena;
+   /* the chain whose block holds the index, which is then freed with
+      the block, or NULL */
+   struct Chain *psChain;
+   /* the number of slots, a power of 2 */
+   size_t ulSize;
+   /* the number of slots that hold a child or are vacated */
+   size_t ulUsed;
+#ifdef THREADSAFE
+   /* the index's bookkeeping once retired */
+   struct EpochEntry sRetired;
+#endif
+   /* each slot is NULL if never used, &sVacated if its child was
+      removed, or a child */
+   Node_T aoNSlots[];
+};
+
+/*
+  The header of a block holding a chain of nodes made by Node_newChain,
+  each the parent of the next, followed in an arena by their names.
+  The block is freed when the last of its nodes and their indexes is,
+  so it can outlive the nodes removed from it, and a retired index
+  keeps it alive until the epoch collector is done with it.
+*/
+struct Chain {
+   /* the number of the chain's nodes and indexes not yet freed, each
+      of which holds a share of the block */
+   size_t ulLive;
+   /* the size of the block, header included */
+   size_t ulSize;
+};
+
+/*
+  An index of every node of a tree by absolute path, so that a lookup
+  is a single probe however deep the node is. It is an Index like a
+  directory's, but keyed by each node's ulPathHash, and the nodes of
+  the whole tree share it. Each node in it keeps a copy of its
+  absolute path, so a hit is confirmed by a single comparison. The
+  nodes of a subtree detached by Node_detach stay in it until they are
+  freed, so while any such subtree is waiting hits are confirmed by
+  climbing to the root instead. Writers in different subtrees add to
+  it at once, so changes are serialized by a lock of its own; lookups
+  take none.
+*/
+struct PathIndex {
+   /* the table of nodes, replaced whole as it grows */
+   struct Index *psTable;
+   /* the number of nodes in psTable */
+   size_t ulCount;
+   /* the number of nodes that room has been made for, by
+      Node_reservePaths, that have not yet been added */
+   size_t ulReserved;
+   /* the number of subtrees detached by Node_detach and not yet
+      freed, changed atomically */
+   size_t ulDetached;
+#ifdef THREADSAFE
+   /* serializes changes to the fields above but ulDetached */
+   pthread_mutex_t sLock;
+#endif
+};
+
+/* The multiplier that mixes each name into a path's hash */
+enum { PATH_HASH_PRIME = 16777619 };
+
+/*
+  A cache of directories recently reached by lookups, so that the
+  next lookup below one of them can start there instead of at the
+  root. It is direct-mapped by each directory's ulPathHash, and a
+  fill replaces whatever its slot held. A hit is confirmed by its path
+  hash and depth, and then by its names up to the root, and the lookup
+  goes on from it; only the CACHE_PROBES deepest directories on a path
+  are looked for.
+
+  Each node of a cached tree points to the cache, and removing a
+  directory evicts only the directories it frees. Node_free marks each
+  one removed, so that its slot is no longer trusted, and retires it
+  twice: once every lookup that might still cache it has ended, its
+  slot is cleared, and once every lookup that might have read the
+  slot has ended, it is freed. A subtree detached by Node_detach is
+  not marked until it is freed, but has no path up to the root.
+
+  In the THREADSAFE build lookups fill slots while others read them.
+  Each slot has a sequence number, odd while a fill writes it, and a
+  slot that changes while it is read counts as empty.
+*/
+enum { CACHE_PROBES = 3 };
+
+/*
+  A counting Bloom filter over the absolute paths of a tree's nodes,
+  so that most lookups of a path that is in no node are answered
+  without a traversal. Each node's ulPathHash chooses a block of
+  FILTER_BLOCK counters, the size of a cache line, and ulHashes of the
+  counters in it by double hashing, so that a lookup reads one line
+  of memory rather than one per counter. Packing a path's counters in
+  one block costs precision, so a filter has more counters per path
+  than an unblocked one, and at most FILTER_MAX_HASHES hashes, past
+  which a block is too crowded for more to help. The node adds 1 to
+  each before it is linked in and takes 1 away as it is freed, so a
+  path any of whose counters is 0 is in no node of the tree. A counter
+  that reaches UCHAR_MAX stays there, as it no longer knows how many
+  nodes share it, so saturation can only make the filter answer
+  "maybe" more often.
+*/
+enum { FILTER_BLOCK = 64, FILTER_MAX_HASHES = 8 };
+
+struct PathFilter {
+   /* the counters, a power of 2 of them */
+   unsigned char *pucCounters;
+   /* the number of counters, less 1 */
+   size_t ulMask;
+   /* the number of counters each path sets */
+   size_t ulHashes;
+};
+
+/* A slot of a DirCache. */
+struct DirSlot {
+   /* odd while a fill is writing the field below */
+   size_t ulSeq;
+   /* the directory cached, or NULL */
+   Node_T oNDir;
+};
+
+struct DirCache {
+   /* the slots, a power of 2 of them */
+   struct DirSlot *psSlots;
+   /* the number of slots, less 1 */
+   size_t ulMask;
+   /* the number of lookups that started from a cached directory,
+      and of those that had to start from the root */
+   size_t ulHits;
+   size_t ulMisses;
+};
+
+/*
+  A table of handles through which clients reach nodes again without
+  looking up their paths. A node has at most one entry, shared by
+  every handle opened to it. Node_free frees the entry as it frees the
+  node, while it still holds the node's lock, and advances the entry's
+  generation, so that a handle holding an older generation is known
+  to be stale even once the entry is reused. Entries are allocated
+  HANDLE_CHUNK at a time and not freed until the table is, so a stale
+  handle can always be read.
+
+  Node_detach leaves a subtree's entries alone, so that it still takes
+  constant time. Instead, the table counts detaches, and an entry
+  whose node has not been seen in the tree since the last one is
+  checked by climbing to the root.
+*/
+enum { HANDLE_CHUNK = 64 };
+
+/* An entry of a HandleTable. */
+struct NodeHandle {
+   /* the node, or NULL if the entry is free */
+   Node_T oNNode;
+   /* the number of times the entry has been freed */
+   size_t ulGeneration;
+   /* the table's count of detaches when oNNode was last seen in the
+      tree */
+   size_t ulSeen;
+   /* the table the entry belongs to */
+   struct HandleTable *psTable;
+   /* the next free entry, if this one is free */
+   struct NodeHandle *psNextFree;
+};
+
+/* A block of entries of a HandleTable. */
+struct HandleChunk {
+   /* the block allocated before this one, or NULL */
+   struct HandleChunk *psNext;
+   struct NodeHandle asEntries[HANDLE_CHUNK];
+};
+
+struct HandleTable {
+   /* every block of entries, the latest first */
+   struct HandleChunk *psChunks;
+   /* the free entries, linked through psNextFree */
+   struct NodeHandle *psFree;
+   /* the number of subtrees detached from the tree */
+   size_t ulDetaches;
+#ifdef THREADSAFE
+   /* serializes changes to the entries and the free list */
+   pthread_mutex_t sLock;
+#endif
+};
+
+/*
+  A node in a FT. A node stores only its own name and a link to its
+  parent; its absolute path is the chain of names from the root down,
+  and is reconstructed on demand.
+
+  The nodes of a tree whose root was made by Node_newChain or
+  Node_newChild with a non-NULL psArena, with their names, children
+  and indexes, all live in that tree's arena.
+  Such a node's name is an unshared copy of an atom (see Atom_copy),
+  so that releasing the arena leaves no reference behind in the atom
+  table; names are therefore matched by characters when the pointers
+  differ.
+*/
 struct node {
-   /* the object corresponding to the node's absolute path */
-   Path_T oPPath;
-   /* this node's parent */
+   /* the atom for the final component of the node's absolute path,
+      or a copy of it in psArena */
+   const char *pcName;
+   /* the arena holding this node, or NULL if it is on the heap */
+   struct Arena *psArena;
+   /* the block this node shares with the rest of its chain, or NULL
+      if it was allocated alone */
+   struct Chain *psChain;
+   /* the number of components in the node's absolute path */
+   size_t ulDepth;
+   /* the number of nodes in the subtree rooted here, this one
+      included */
+   size_t ulSubtree;
+   /* a hash of the node's absolute path, as Node_hashPath computes it */
+   size_t ulPathHash;
+   /* the path index the node is in, or NULL if it is in none */
+   struct PathIndex *psPaths;
+   /* the node's absolute path while its tree has a path index, from
+      psArena if it has one, or NULL */
+   char *pcPath;
+   /* the path filter the node is counted in, or NULL if none */
+   struct PathFilter *psFilter;
+   /* the directory cache of the node's tree, or NULL if none */
+   struct DirCache *psDirs;
+   /* the entry of the handle table the node is open in, or NULL */
+   struct NodeHandle *psHandle;
+   /* this node's parent; or, for the root of a detached tree waiting
+      for the reclaimer, the root queued after it */
    Node_T oNParent;
    /* the object containing links to this node's children */
-   DynArray_T oDChildren;
+   BTree_T oBChildren;
+   /* the hash index of this node's children, or NULL if not indexed */
+   struct Index *psIndex;
    /* the objects file contents (if a file) */
    void * filecontents;
    /* length of the file */
    size_t length;
    /* TRUE for file, FALSE for directory */
    boolean nodetype;
+   /* TRUE once Node_free has retired the node, if it is a directory
+      that psDirs may hold; read atomically by lookups through it */
+   boolean bRemoved;
+#ifdef THREADSAFE
+   /* guards the children and contents; see Node_lockShared */
+   pthread_rwlock_t sLock;
+   /* the node's bookkeeping once retired by Node_free */
+   struct EpochEntry sRetired;
+#endif
 };
 
+/* the marker left in the index slot of a removed child */
+static struct node sVacated;
+
+/* every node is allocated from this slab */
+static struct Slab sNodeSlab = SLAB_INITIALIZER(sizeof(struct node));
+
+#ifdef THREADSAFE
+/*
+  Detached trees handed to Node_freeLater wait in a queue, linked
+  through their roots' parent fields, for a single reclaimer thread
+  that is started the first time one is queued.
+*/
+/* guards the fields below */
+static pthread_mutex_t sQueueLock = PTHREAD_MUTEX_INITIALIZER;
+/* signaled when a tree is queued, and when the queue is drained */
+static pthread_cond_t sQueueCond = PTHREAD_COND_INITIALIZER;
+/* the first and last roots queued, or NULL if none is */
+static Node_T oNQueueHead;
+static Node_T oNQueueTail;
+/* the number of trees queued or being freed */
+static size_t ulPending;
+/* TRUE once the reclaimer thread is running */
+static boolean bReclaimerStarted;
+#endif
+
+
+/*
+  Compares the name of oNFirst with atom pcName. Names are usually the
+  same atoms, so a match is mostly found with a single pointer
+  comparison; characters are compared otherwise.
+  Returns <0, 0, or >0 if oNFirst is "less than", "equal to", or
+  "greater than" pcName, respectively.
+*/
+static int Node_compareName(const Node_T oNFirst, const char *pcName) {
+   assert(oNFirst != NULL);
+   assert(pcName != NULL);
+
+   if(oNFirst->pcName == pcName)
+      return 0;
+   return strcmp(oNFirst->pcName, pcName);
+}
+
+/*
+  Returns TRUE if oNNode is named pcName, an atom or a copy of one,
+  and FALSE otherwise. Characters are compared only if the pointers
+  differ and the hashes match.
+*/
+static boolean Node_isNamed(const Node_T oNNode, const char *pcName) {
+   assert(oNNode != NULL);
+   assert(pcName != NULL);
+
+   if(oNNode->pcName == pcName)
+      return TRUE;
+   return (boolean) (Atom_getHash(oNNode->pcName) ==
+                     Atom_getHash(pcName) &&
+                     strcmp(oNNode->pcName, pcName) == 0);
+}
+
+/*
+  The characters of a path component being looked up, which need not
+  be '\0'-terminated, and their hash as Atom_hash computes it.
+*/
+struct Component {
+   const char *pcStr;
+   size_t ulLength;
+   size_t ulHash;
+};
+
+/*
+  Compares the name of oNFirst with the component *psComponent,
+  ordering them as Node_compareName does.
+  Returns <0, 0, or >0 if oNFirst is "less than", "equal to", or
+  "greater than" the component, respectively.
+*/
+static int Node_compareComponent(const Node_T oNFirst,
+                                 const struct Component *psComponent) {
+   size_t ulLength;
+   int iCmp;
+
+   assert(oNFirst != NULL);
+   assert(psComponent != NULL);
+
+   ulLength = Atom_getLength(oNFirst->pcName);
+   iCmp = memcmp(oNFirst->pcName, psComponent->pcStr,
+                 ulLength < psComponent->ulLength ?
+                 ulLength : psComponent->ulLength);
+   if(iCmp != 0)
+      return iCmp;
+   if(ulLength != psComponent->ulLength)
+      return ulLength < psComponent->ulLength ? -1 : 1;
+   return 0;
+}
+
+/*
+  Returns the number of slots for an index of ulCount children: the
+  smallest power of 2 above 4 * ulCount, and at least INDEX_MIN_SIZE.
+*/
+static size_t Node_indexSize(size_t ulCount) {
+   size_t ulSize;
+
+   for(ulSize = INDEX_MIN_SIZE; ulSize <= 4 * ulCount; ulSize *= 2)
+      ;
+   return ulSize;
+}
+
+/*
+  Returns the slot of psIndex that holds the child named pcName, or
+  the empty slot that ends its probe run if there is no such child.
+  Vacated slots are probed past.
+*/
+static size_t Node_probeIndex(struct Index *psIndex,
+                              const char *pcName) {
+   Node_T oNSlot;
+   size_t ulMask;
+   size_t ulSlot;
+
+   assert(psIndex != NULL);
+   assert(pcName != NULL);
+
+   ulMask = psIndex->ulSize - 1;
+   ulSlot = Atom_getHash(pcName) & ulMask;
+   while((oNSlot = psIndex->aoNSlots[ulSlot]) != NULL &&
+         (oNSlot == &sVacated || !Node_isNamed(oNSlot, pcName)))
+      ulSlot = (ulSlot + 1) & ulMask;
+   return ulSlot;
+}
+
+/*
+  Adds oNChild, which it must not already hold, to the index pvIndex,
+  which must have room. Takes the first vacated or empty slot of the
+  probe run. Has the signature BTree_map expects.
+*/
+static void Node_indexChild(Node_T oNChild, void *pvIndex) {
+   struct Index *psIndex = pvIndex;
+   size_t ulMask;
+   size_t ulSlot;
+
+   assert(oNChild != NULL);
+   assert(psIndex != NULL);
+
+   ulMask = psIndex->ulSize - 1;
+   ulSlot = Atom_getHash(oNChild->pcName) & ulMask;
+   while(psIndex->aoNSlots[ulSlot] != NULL &&
+         psIndex->aoNSlots[ulSlot] != &sVacated)
+      ulSlot = (ulSlot + 1) & ulMask;
+   if(psIndex->aoNSlots[ulSlot] == NULL)
+      psIndex->ulUsed++;
+
+   /* oNChild is fully initialized before readers can see it */
+   EPOCH_PUBLISH(psIndex->aoNSlots[ulSlot], oNChild);
+}
+
+/*
+  Gives up one share of psChain's block, which came from psArena if
+  that is not NULL, and frees the block if it was the last.
+*/
+static void Node_releaseChain(struct Chain *psChain,
+                              struct Arena *psArena) {
+   size_t ulLive;
+
+   assert(psChain != NULL);
+
+#ifdef THREADSAFE
+   ulLive = __atomic_sub_fetch(&psChain->ulLive, 1, __ATOMIC_ACQ_REL);
+#else
+   ulLive = --psChain->ulLive;
+#endif
+   if(ulLive != 0)
+      return;
+   if(psArena != NULL)
+      Arena_free(psArena, psChain, psChain->ulSize);
+   else
+      free(psChain);
+}
+
+/*
+  Frees index pvIndex, or does nothing if it is NULL. An index in a
+  chain's block gives up its share of the block instead. Has the
+  signature Epoch_retire expects.
+*/
+static void Node_freeIndex(void *pvIndex) {
+   struct Index *psIndex = pvIndex;
+
+   if(psIndex == NULL)
+      return;
+   if(psIndex->psChain != NULL)
+      Node_releaseChain(psIndex->psChain, psIndex->psArena);
+   else if(psIndex->psArena != NULL)
+      Arena_free(psIndex->psArena, psIndex,
+                 sizeof(struct Index) +
+                 psIndex->ulSize * sizeof(Node_T));
+   else
+      free(psIndex);
+}
+
+/*
+  Frees psIndex, which is no longer its directory's index, once no
+  reader can still be probing it.
+*/
+static void Node_retireIndex(struct Index *psIndex) {
+   assert(psIndex != NULL);
+#ifdef THREADSAFE
+   Epoch_retire(&psIndex->sRetired, Node_freeIndex, psIndex);
+#else
+   Node_freeIndex(psIndex);
+#endif
+}
+
+/*
+  Replaces oNParent's index, if any, with one of ulSize slots holding
+  all of oNParent's children. Returns SUCCESS, or MEMORY_ERROR if the
+  new index could not be allocated, in which case oNParent is
+  unchanged.
+*/
+static int Node_buildIndex(Node_T oNParent, size_t ulSize) {
+   struct Index *psOld;
+   struct Index *psNew;
+
+   assert(oNParent != NULL);
+   assert(ulSize > 2 * Node_getNumChildren(oNParent));
+
+   if(oNParent->psArena != NULL) {
+      psNew = Arena_alloc(oNParent->psArena,
+                          sizeof(struct Index) + ulSize * sizeof(Node_T));
+      if(psNew != NULL)
+         memset(psNew->aoNSlots, 0, ulSize * sizeof(Node_T));
+   }
+   else
+      psNew = calloc(1, sizeof(struct Index) + ulSize * sizeof(Node_T));
+   if(psNew == NULL)
+      return MEMORY_ERROR;
+   psNew->psArena = oNParent->psArena;
+   psNew->psChain = NULL;
+   psNew->ulSize = ulSize;
+   psNew->ulUsed = 0;
+   BTree_map(oNParent->oBChildren,
+             (void (*)(void *, void *)) Node_indexChild, psNew);
+
+   /* swap it in whole, so readers see one index or the other */
+   psOld = oNParent->psIndex;
+   EPOCH_PUBLISH(oNParent->psIndex, psNew);
+   if(psOld != NULL)
+      Node_retireIndex(psOld);
+   return SUCCESS;
+}
+
+/*
+  Marks the slot of oNParent's index that holds oNChild vacated.
+  Other entries stay where they are, so no probe that is already
+  under way passes an empty slot before reaching its entry.
+*/
+static void Node_unindex(Node_T oNParent, Node_T oNChild) {
+   size_t ulSlot;
+
+   assert(oNParent != NULL);
+   assert(oNParent->psIndex != NULL);
+   assert(oNChild != NULL);
+
+   ulSlot = Node_probeIndex(oNParent->psIndex, oNChild->pcName);
+   assert(oNParent->psIndex->aoNSlots[ulSlot] == oNChild);
+
+   EPOCH_PUBLISH(oNParent->psIndex->aoNSlots[ulSlot], &sVacated);
+}
+
+/*
+  Returns the hash of the path made by adding a component whose name
+  has hash ulNameHash to a path whose hash is ulPathHash, or to no
+  path if ulPathHash is 0.
+*/
+static size_t Node_hashPath(size_t ulPathHash, size_t ulNameHash) {
+   return (ulPathHash ^ ulNameHash) * (size_t) PATH_HASH_PRIME;
+}
+
+/* Acquires psPaths's lock, in the THREADSAFE build. */
+static void Node_lockPaths(struct PathIndex *psPaths) {
+   assert(psPaths != NULL);
+#ifdef THREADSAFE
+   (void) pthread_mutex_lock(&psPaths->sLock);
+#endif
+}
+
+/* Releases psPaths's lock, in the THREADSAFE build. */
+static void Node_unlockPaths(struct PathIndex *psPaths) {
+   assert(psPaths != NULL);
+#ifdef THREADSAFE
+   (void) pthread_mutex_unlock(&psPaths->sLock);
+#endif
+}
+
+/*
+  Adds oNNode, which it must not already hold, to the path table
+  psTable, which must have room, as Node_indexChild does by name.
+*/
+static void Node_insertPath(struct Index *psTable, Node_T oNNode) {
+   size_t ulMask;
+   size_t ulSlot;
+
+   assert(psTable != NULL);
+   assert(oNNode != NULL);
+
+   ulMask = psTable->ulSize - 1;
+   ulSlot = oNNode->ulPathHash & ulMask;
+   while(psTable->aoNSlots[ulSlot] != NULL &&
+         psTable->aoNSlots[ulSlot] != &sVacated)
+      ulSlot = (ulSlot + 1) & ulMask;
+   if(psTable->aoNSlots[ulSlot] == NULL)
+      psTable->ulUsed++;
+   EPOCH_PUBLISH(psTable->aoNSlots[ulSlot], oNNode);
+}
+
+/*
+  Makes room in psPaths for ulCount more nodes, replacing its table
+  with a larger one if that would be more than half full. Must be
+  called with psPaths's lock held. Returns SUCCESS, or MEMORY_ERROR if
+  the larger table could not be allocated.
+*/
+static int Node_growPaths(struct PathIndex *psPaths, size_t ulCount) {
+   struct Index *psOld;
+   struct Index *psNew;
+   Node_T oNSlot;
+   size_t ulSize;
+   size_t ulSlot;
+
+   assert(psPaths != NULL);
+
+   psOld = psPaths->psTable;
+   ulCount += psPaths->ulReserved;
+   if(2 * (psOld->ulUsed + ulCount) < psOld->ulSize)
+      return SUCCESS;
+
+   /* at most half full, rather than a quarter as a directory's, since
+      the table has a slot per node of the whole tree */
+   ulSize = Node_indexSize((psPaths->ulCount + ulCount + 1) / 2);
+   psNew = calloc(1, sizeof(struct Index) + ulSize * sizeof(Node_T));
+   if(psNew == NULL)
+      return MEMORY_ERROR;
+   psNew->psArena = NULL;
+   psNew->psChain = NULL;
+   psNew->ulSize = ulSize;
+   psNew->ulUsed = 0;
+   for(ulSlot = 0; ulSlot < psOld->ulSize; ulSlot++) {
+      oNSlot = psOld->aoNSlots[ulSlot];
+      if(oNSlot != NULL && oNSlot != &sVacated)
+         Node_insertPath(psNew, oNSlot);
+   }
+
+   /* swap it in whole, so readers see one table or the other */
+   EPOCH_PUBLISH(psPaths->psTable, psNew);
+   Node_retireIndex(psOld);
+   return SUCCESS;
+}
+
+/*
+  Makes room in psPaths for ulCount nodes to be added by Node_addPaths,
+  so that adding them cannot fail. Returns SUCCESS, or MEMORY_ERROR if
+  the room could not be made.
+*/
+static int Node_reservePaths(struct PathIndex *psPaths, size_t ulCount) {
+   int iStatus;
+
+   assert(psPaths != NULL);
+
+   Node_lockPaths(psPaths);
+   iStatus = Node_growPaths(psPaths, ulCount);
+   if(iStatus == SUCCESS)
+      psPaths->ulReserved += ulCount;
+   Node_unlockPaths(psPaths);
+   return iStatus;
+}
+
+/* Gives back room for ulCount nodes reserved in psPaths and unused. */
+static void Node_unreservePaths(struct PathIndex *psPaths,
+                                size_t ulCount) {
+   assert(psPaths != NULL);
+
+   Node_lockPaths(psPaths);
+   psPaths->ulReserved -= ulCount;
+   Node_unlockPaths(psPaths);
+}
+
+/*
+  Returns the node after oNCurr in a pre-order walk of the subtree
+  rooted at oNTop, or NULL if oNCurr is the last. Climbs by parent
+  links rather than keeping a stack, so it takes constant memory.
+*/
+static Node_T Node_nextInSubtree(Node_T oNTop, Node_T oNCurr) {
+   size_t ulChildID;
+
+   assert(oNTop != NULL);
+   assert(oNCurr != NULL);
+
+   if(BTree_getLength(oNCurr->oBChildren) != 0)
+      return BTree_get(oNCurr->oBChildren, 0);
+   for(; oNCurr != oNTop; oNCurr = oNCurr->oNParent) {
+      ulChildID = Node_getChildID(oNCurr) + 1;
+      if(ulChildID < BTree_getLength(oNCurr->oNParent->oBChildren))
+         return BTree_get(oNCurr->oNParent->oBChildren, ulChildID);
+   }
+   return NULL;
+}
+
+/* Frees oNNode's copy of its absolute path, if it has one. */
+static void Node_freePath(Node_T oNNode) {
+   assert(oNNode != NULL);
+
+   if(oNNode->pcPath == NULL)
+      return;
+   if(oNNode->psArena != NULL)
+      Arena_free(oNNode->psArena, oNNode->pcPath,
+                 strlen(oNNode->pcPath) + 1);
+   else
+      free(oNNode->pcPath);
+   oNNode->pcPath = NULL;
+}
+
+/*
+  Gives each node of the subtree rooted at oNTop a copy of its
+  absolute path, built from its parent's, which oNTop's parent must
+  already have unless oNTop is a root. Returns SUCCESS, or
+  MEMORY_ERROR after freeing the copies it made.
+*/
+static int Node_copyPaths(Node_T oNTop) {
+   Node_T oNCurr;
+   Node_T oNFailed;
+   size_t ulPrefix;
+   size_t ulLength;
+
+   assert(oNTop != NULL);
+
+   for(oNCurr = oNTop; oNCurr != NULL;
+       oNCurr = Node_nextInSubtree(oNTop, oNCurr)) {
+      ulPrefix = oNCurr->oNParent == NULL ? 0 :
+         strlen(oNCurr->oNParent->pcPath) + 1;
+      ulLength = ulPrefix + Atom_getLength(oNCurr->pcName);
+      if(oNCurr->psArena != NULL)
+         oNCurr->pcPath = Arena_alloc(oNCurr->psArena, ulLength + 1);
+      else
+         oNCurr->pcPath = malloc(ulLength + 1);
+      if(oNCurr->pcPath == NULL)
+         break;
+      if(ulPrefix != 0) {
+         memcpy(oNCurr->pcPath, oNCurr->oNParent->pcPath, ulPrefix - 1);
+         oNCurr->pcPath[ulPrefix - 1] = '/';
+      }
+      memcpy(oNCurr->pcPath + ulPrefix, oNCurr->pcName,
+             ulLength - ulPrefix + 1);
+   }
+   if(oNCurr == NULL)
+      return SUCCESS;
+
+   /* free the copies made before the one that failed */
+   oNFailed = oNCurr;
+   for(oNCurr = oNTop; oNCurr != oNFailed;
+       oNCurr = Node_nextInSubtree(oNTop, oNCurr))
+      Node_freePath(oNCurr);
+   return MEMORY_ERROR;
+}
+
+/* Frees the copies Node_copyPaths made for the subtree at oNTop. */
+static void Node_dropPaths(Node_T oNTop) {
+   Node_T oNCurr;
+
+   assert(oNTop != NULL);
+
+   for(oNCurr = oNTop; oNCurr != NULL;
+       oNCurr = Node_nextInSubtree(oNTop, oNCurr))
+      Node_freePath(oNCurr);
+}
+
+/*
+  Adds every node of the subtree rooted at oNTop to psPaths, which
+  must have been reserved room for them, and records in each that it
+  is there. Each node must have a copy of its path from
+  Node_copyPaths.
+*/
+static void Node_addPaths(struct PathIndex *psPaths, Node_T oNTop) {
+   Node_T oNCurr;
+
+   assert(psPaths != NULL);
+   assert(oNTop != NULL);
+
+   Node_lockPaths(psPaths);
+   for(oNCurr = oNTop; oNCurr != NULL;
+       oNCurr = Node_nextInSubtree(oNTop, oNCurr)) {
+      oNCurr->psPaths = psPaths;
+      Node_insertPath(psPaths->psTable, oNCurr);
+      psPaths->ulCount++;
+      psPaths->ulReserved--;
+   }
+   Node_unlockPaths(psPaths);
+}
+
+/*
+  Removes oNNode from the path index it is in, if any, leaving a
+  vacated marker as Node_unindex does.
+*/
+static void Node_removePath(Node_T oNNode) {
+   struct PathIndex *psPaths;
+   struct Index *psTable;
+   size_t ulMask;
+   size_t ulSlot;
+
+   assert(oNNode != NULL);
+
+   psPaths = oNNode->psPaths;
+   if(psPaths == NULL)
+      return;
+
+   Node_lockPaths(psPaths);
+   psTable = psPaths->psTable;
+   ulMask = psTable->ulSize - 1;
+   for(ulSlot = oNNode->ulPathHash & ulMask;
+       psTable->aoNSlots[ulSlot] != oNNode;
+       ulSlot = (ulSlot + 1) & ulMask)
+      assert(psTable->aoNSlots[ulSlot] != NULL);
+   EPOCH_PUBLISH(psTable->aoNSlots[ulSlot], &sVacated);
+   psPaths->ulCount--;
+   Node_unlockPaths(psPaths);
+}
+
+/*
+  Adds ulDelta, which may be the negation of a count, to *pulDetached,
+  the number of detached subtrees waiting to be freed that a path
+  index still holds nodes of.
+*/
+static void Node_countDetached(size_t *pulDetached, size_t ulDelta) {
+   assert(pulDetached != NULL);
+
+#ifdef THREADSAFE
+   (void) __atomic_fetch_add(pulDetached, ulDelta, __ATOMIC_SEQ_CST);
+#else
+   *pulDetached += ulDelta;
+#endif
+}
+
+/*
+  Returns TRUE if *pulDetached, as Node_countDetached keeps it, is not
+  0. A lookup reads it before the nodes it finds, so that a subtree
+  detached since has begun after the lookup.
+*/
+static boolean Node_anyDetached(size_t *pulDetached) {
+   assert(pulDetached != NULL);
+
+#ifdef THREADSAFE
+   return (boolean) (__atomic_load_n(pulDetached, __ATOMIC_SEQ_CST) !=
+                     0);
+#else
+   return (boolean) (*pulDetached != 0);
+#endif
+}
+
+/*
+  Returns TRUE if oNNode's copy of its absolute path is the ulLength
+  characters at pcPath.
+*/
+static boolean Node_matchesPath(Node_T oNNode, const char *pcPath,
+                                size_t ulLength) {
+   assert(oNNode != NULL);
+   assert(oNNode->pcPath != NULL);
+   assert(pcPath != NULL);
+
+   return (boolean) (strncmp(oNNode->pcPath, pcPath, ulLength) == 0 &&
+                     oNNode->pcPath[ulLength] == '\0');
+}
+
+/*
+  Returns the hash Node_hashPath gives the node with the absolute path
+  psView describes, computed from the path's characters alone.
+*/
+static size_t Node_hashView(const struct PathView *psView) {
+   const char *pcComponent;
+   size_t ulPathHash = 0;
+   size_t ulOffset = 0;
+   size_t ulLength = 0;
+
+   assert(psView != NULL);
+
+   while((pcComponent = PathView_nextComponent(psView, &ulOffset,
+                                               &ulLength)) != NULL)
+      ulPathHash = Node_hashPath(ulPathHash,
+                                 Atom_hash(pcComponent, ulLength));
+   return ulPathHash;
+}
+
+/*
+  Sets *pulSlot and *pulStep to the first of the counters a path
+  filter uses within its block for path hash ulPathHash, and the step
+  to the next, both taken from the high bits of the hash remixed,
+  which the block's index, its low bits, does not determine. The step
+  grows by 1 more at each counter, so that two paths sharing a block
+  seldom share all their counters.
+*/
+static void Node_filterProbe(size_t ulPathHash, size_t *pulSlot,
+                             size_t *pulStep) {
+   size_t ulMixed;
+
+   assert(pulSlot != NULL);
+   assert(pulStep != NULL);
+
+   ulMixed = ulPathHash * (size_t) PATH_HASH_PRIME;
+   *pulSlot = ulMixed >> (sizeof(size_t) * CHAR_BIT - 6);
+   *pulStep = ulMixed >> (sizeof(size_t) * CHAR_BIT / 2) | 1;
+}
+
+/* Returns the block of psFilter's counters for path hash ulPathHash. */
+static unsigned char *Node_filterBlock(struct PathFilter *psFilter,
+                                       size_t ulPathHash) {
+   assert(psFilter != NULL);
+
+   return &psFilter->pucCounters[ulPathHash & psFilter->ulMask &
+                                 ~(size_t) (FILTER_BLOCK - 1)];
+}
+
+/*
+  Adds 1 to each of psFilter's counters for path hash ulPathHash if
+  bAdd is TRUE, and takes 1 away otherwise, leaving saturated counters
+  as they are. Writers in different subtrees share counters, so in the
+  THREADSAFE build they are updated atomically.
+*/
+static void Node_countPath(struct PathFilter *psFilter,
+                           size_t ulPathHash, boolean bAdd) {
+   unsigned char *pucBlock;
+   unsigned char *pucCounter;
+   unsigned char ucCount;
+   size_t ulStep;
+   size_t ulSlot;
+   size_t i;
+
+   assert(psFilter != NULL);
+
+   pucBlock = Node_filterBlock(psFilter, ulPathHash);
+   Node_filterProbe(ulPathHash, &ulSlot, &ulStep);
+   for(i = 0; i < psFilter->ulHashes; ulSlot += ulStep, ulStep += i, i++) {
+      pucCounter = &pucBlock[ulSlot & (FILTER_BLOCK - 1)];
+#ifdef THREADSAFE
+      ucCount = __atomic_load_n(pucCounter, __ATOMIC_RELAXED);
+      do {
+         if(ucCount == UCHAR_MAX)
+            break;
+         assert(bAdd || ucCount != 0);
+      } while(!__atomic_compare_exchange_n(pucCounter, &ucCount,
+                 (unsigned char) (bAdd ? ucCount + 1 : ucCount - 1), 1,
+                 __ATOMIC_RELAXED, __ATOMIC_RELAXED));
+#else
+      ucCount = *pucCounter;
+      assert(bAdd || ucCount != 0);
+      if(ucCount != UCHAR_MAX)
+         *pucCounter = (unsigned char) (bAdd ? ucCount + 1 : ucCount - 1);
+#endif
+   }
+}
+
+/*
+  Counts every node of the subtree rooted at oNTop in psFilter and
+  records in each that it is counted there, if bAdd is TRUE; or, if
+  bAdd is FALSE, takes each back out of psFilter. No other thread may
+  be changing the subtree.
+*/
+static void Node_filterSubtree(struct PathFilter *psFilter,
+                               Node_T oNTop, boolean bAdd) {
+   Node_T oNCurr;
+
+   assert(psFilter != NULL);
+   assert(oNTop != NULL);
+
+   for(oNCurr = oNTop; oNCurr != NULL;
+       oNCurr = Node_nextInSubtree(oNTop, oNCurr)) {
+      Node_countPath(psFilter, oNCurr->ulPathHash, bAdd);
+      oNCurr->psFilter = bAdd ? psFilter : NULL;
+   }
+}
+
+/* Takes oNNode out of the path filter it is counted in, if any. */
+static void Node_unfilter(Node_T oNNode) {
+   assert(oNNode != NULL);
+
+   if(oNNode->psFilter != NULL) {
+      Node_countPath(oNNode->psFilter, oNNode->ulPathHash, FALSE);
+      oNNode->psFilter = NULL;
+   }
+}
+
+/* Acquires psTable's lock, in the THREADSAFE build. */
+static void Node_lockHandles(struct HandleTable *psTable) {
+   assert(psTable != NULL);
+#ifdef THREADSAFE
+   (void) pthread_mutex_lock(&psTable->sLock);
+#endif
+}
+
+/* Releases psTable's lock, in the THREADSAFE build. */
+static void Node_unlockHandles(struct HandleTable *psTable) {
+   assert(psTable != NULL);
+#ifdef THREADSAFE
+   (void) pthread_mutex_unlock(&psTable->sLock);
+#endif
+}
+
+/*
+  Frees oNNode's handle entry, if it has one, making every handle to
+  it stale. oNNode must be locked exclusively, so that a handle
+  operation that locks it afterwards sees the new generation.
+*/
+static void Node_closeHandle(Node_T oNNode) {
+   struct NodeHandle *psHandle;
+   struct HandleTable *psTable;
+
+   assert(oNNode != NULL);
+
+   psHandle = oNNode->psHandle;
+   if(psHandle == NULL)
+      return;
+   psTable = psHandle->psTable;
+   Node_lockHandles(psTable);
+   /* the generation goes first, so that a reader that finds another
+      node in the entry once it is reused also finds the generation
+      it opened superseded */
+   EPOCH_PUBLISH(psHandle->ulGeneration, psHandle->ulGeneration + 1);
+   EPOCH_PUBLISH(psHandle->oNNode, NULL);
+   psHandle->psNextFree = psTable->psFree;
+   psTable->psFree = psHandle;
+   Node_unlockHandles(psTable);
+   oNNode->psHandle = NULL;
+}
+
+/*
+  Returns TRUE if oNNode's absolute path is the ulEnd characters at
+  pcPath and oNNode is in the tree whose root is oNRoot, comparing
+  names from the end of the path while climbing to the root. Parent
+  links are read as Node_freeLater may change them, so this may run
+  without locks inside an epoch read-side section.
+*/
+static boolean Node_hasPath(Node_T oNNode, Node_T oNRoot,
+                            const char *pcPath, size_t ulEnd) {
+   size_t ulLength;
+   Node_T oNParent;
+
+   assert(oNNode != NULL);
+   assert(pcPath != NULL);
+
+   for(;;) {
+      ulLength = Atom_getLength(oNNode->pcName);
+      if(ulLength > ulEnd ||
+         memcmp(pcPath + ulEnd - ulLength, oNNode->pcName,
+                ulLength) != 0)
+         return FALSE;
+      ulEnd -= ulLength;
+      if(oNNode->ulDepth == 1)
+         return (boolean) (ulEnd == 0 && oNNode == oNRoot);
+
+      /* a detached root's link may lead anywhere but up this path */
+      oNParent = EPOCH_READ(oNNode->oNParent);
+      if(ulEnd == 0 || pcPath[ulEnd - 1] != '/' || oNParent == NULL ||
+         oNParent->ulDepth + 1 != oNNode->ulDepth)
+         return FALSE;
+      ulEnd--;
+      oNNode = oNParent;
+   }
+}
+
+/*
+  Returns the directory in psCache's slot for path hash ulPathHash,
+  or NULL if the slot is empty, is being filled, or holds a directory
+  that Node_free has retired. A directory returned is not freed before
+  the caller's epoch read-side section ends, but may have any path;
+  the caller must confirm that it has the one wanted.
+*/
+static Node_T Node_readSlot(struct DirCache *psCache,
+                            size_t ulPathHash) {
+   struct DirSlot *psSlot;
+   size_t ulSeq;
+   Node_T oNDir;
+
+   assert(psCache != NULL);
+
+   psSlot = &psCache->psSlots[ulPathHash & psCache->ulMask];
+#ifdef THREADSAFE
+   ulSeq = __atomic_load_n(&psSlot->ulSeq, __ATOMIC_ACQUIRE);
+   oNDir = __atomic_load_n(&psSlot->oNDir, __ATOMIC_RELAXED);
+   __atomic_thread_fence(__ATOMIC_ACQUIRE);
+   if((ulSeq & 1) != 0 ||
+      __atomic_load_n(&psSlot->ulSeq, __ATOMIC_RELAXED) != ulSeq)
+      return NULL;
+   /* a directory not yet marked is retired only after this section
+      began, so it stays until the section ends */
+   if(oNDir != NULL &&
+      __atomic_load_n(&oNDir->bRemoved, __ATOMIC_ACQUIRE))
+      return NULL;
+#else
+   (void) ulSeq;
+   oNDir = psSlot->oNDir;
+#endif
+   return oNDir;
+}
+
+/*
+  Caches directory oNDir in psCache. Leaves the slot to another fill
+  already writing it.
+*/
+static void Node_fillSlot(struct DirCache *psCache, Node_T oNDir) {
+   struct DirSlot *psSlot;
+   size_t ulSeq;
+
+   assert(psCache != NULL);
+   assert(oNDir != NULL);
+
+   psSlot = &psCache->psSlots[oNDir->ulPathHash & psCache->ulMask];
+#ifdef THREADSAFE
+   ulSeq = __atomic_load_n(&psSlot->ulSeq, __ATOMIC_RELAXED);
+   if((ulSeq & 1) != 0 ||
+      !__atomic_compare_exchange_n(&psSlot->ulSeq, &ulSeq, ulSeq + 1, 0,
+                                   __ATOMIC_ACQUIRE, __ATOMIC_RELAXED))
+      return;
+   __atomic_thread_fence(__ATOMIC_RELEASE);
+   __atomic_store_n(&psSlot->oNDir, oNDir, __ATOMIC_RELAXED);
+   __atomic_store_n(&psSlot->ulSeq, ulSeq + 2, __ATOMIC_RELEASE);
+#else
+   (void) ulSeq;
+   psSlot->oNDir = oNDir;
+#endif
+}
+
+/*
+  Empties psCache's slot for directory oNDir if it holds oNDir. A fill
+  writing the slot meanwhile replaces oNDir anyway.
+*/
+static void Node_clearSlot(struct DirCache *psCache, Node_T oNDir) {
+   struct DirSlot *psSlot;
+   size_t ulSeq;
+
+   assert(psCache != NULL);
+   assert(oNDir != NULL);
+
+   psSlot = &psCache->psSlots[oNDir->ulPathHash & psCache->ulMask];
+#ifdef THREADSAFE
+   ulSeq = __atomic_load_n(&psSlot->ulSeq, __ATOMIC_ACQUIRE);
+   if((ulSeq & 1) != 0 ||
+      __atomic_load_n(&psSlot->oNDir, __ATOMIC_RELAXED) != oNDir ||
+      !__atomic_compare_exchange_n(&psSlot->ulSeq, &ulSeq, ulSeq + 1, 0,
+                                   __ATOMIC_ACQUIRE, __ATOMIC_RELAXED))
+      return;
+   __atomic_thread_fence(__ATOMIC_RELEASE);
+   __atomic_store_n(&psSlot->oNDir, NULL, __ATOMIC_RELAXED);
+   __atomic_store_n(&psSlot->ulSeq, ulSeq + 2, __ATOMIC_RELEASE);
+#else
+   (void) ulSeq;
+   if(psSlot->oNDir == oNDir)
+      psSlot->oNDir = NULL;
+#endif
+}
+
+/* Adds 1 to *pulCounter, one of psCache's hit and miss counts. */
+static void Node_countLookup(size_t *pulCounter) {
+   assert(pulCounter != NULL);
+
+#ifdef THREADSAFE
+   (void) __atomic_fetch_add(pulCounter, 1, __ATOMIC_RELAXED);
+#else
+   (*pulCounter)++;
+#endif
+}
+
+/*
+  Adds ulDelta, which may be the negation of a size, to the subtree
+  size of oNNode and of each of its ancestors. Writers in different
+  subtrees share ancestors whose locks they no longer hold, so in the
+  THREADSAFE build the sizes are updated atomically.
+*/
+static void Node_addToSubtrees(Node_T oNNode, size_t ulDelta) {
+   for(; oNNode != NULL; oNNode = oNNode->oNParent) {
+#ifdef THREADSAFE
+      (void) __atomic_fetch_add(&oNNode->ulSubtree, ulDelta,
+                                __ATOMIC_RELAXED);
+#else
+      oNNode->ulSubtree += ulDelta;
+#endif
+   }
+}
+
+/*
+  Links new child oNChild, with the subtree already built below it,
+  into oNParent's children. Returns SUCCESS if
+  the new child was added successfully, MEMORY_ERROR if allocation
+  fails adding oNChild, or NOT_A_DIRECTORY if oNParent is a file.
+*/
+static int Node_addChild(Node_T oNParent, Node_T oNChild) {
+   struct Index *psIndex;
+   size_t ulCount;
+   size_t ulIndex;
+
+   assert(oNParent != NULL);
+   assert(oNChild != NULL);
+
+   if(oNParent->nodetype == TRUE){
+      return NOT_A_DIRECTORY;
+   }
+
+   ulCount = Node_getNumChildren(oNParent);
+
+   /* build the index once the directory outgrows the threshold, and
+      rebuild it before it is half full, vacated slots included */
+   psIndex = oNParent->psIndex;
+   if(psIndex == NULL ? ulCount + 1 > INDEX_THRESHOLD :
+      2 * (psIndex->ulUsed + 1) >= psIndex->ulSize) {
+      if(Node_buildIndex(oNParent, Node_indexSize(ulCount + 1)) !=
+         SUCCESS)
+         return MEMORY_ERROR;
+   }
+
+   /* copy the new nodes' paths and make room for them in the path
+      index before linking them in, and count them in the path filter
+      before they can be found */
+   if(oNParent->psPaths != NULL) {
+      if(Node_copyPaths(oNChild) != SUCCESS)
+         return MEMORY_ERROR;
+      if(Node_reservePaths(oNParent->psPaths, oNChild->ulSubtree) !=
+         SUCCESS) {
+         Node_dropPaths(oNChild);
+         return MEMORY_ERROR;
+      }
+   }
+   if(oNParent->psFilter != NULL)
+      Node_filterSubtree(oNParent->psFilter, oNChild, TRUE);
+
+   /* a child that sorts after the others, as when children are added
+      in order, is appended without searching */
+   if(ulCount == 0 ||
+      Node_compareName(BTree_get(oNParent->oBChildren, ulCount - 1),
+                       oNChild->pcName) < 0)
+      ulIndex = ulCount;
+   else
+      (void) BTree_bsearch(oNParent->oBChildren,
+               (char *) oNChild->pcName, &ulIndex,
+               (int (*)(const void*,const void*)) Node_compareName);
+   if(!BTree_addAt(oNParent->oBChildren, ulIndex, oNChild)) {
+      if(oNParent->psPaths != NULL)
+         Node_unreservePaths(oNParent->psPaths, oNChild->ulSubtree);
+      Node_dropPaths(oNChild);
+      if(oNParent->psFilter != NULL)
+         Node_filterSubtree(oNParent->psFilter, oNChild, FALSE);
+      return MEMORY_ERROR;
+   }
+
+   if(oNParent->psIndex != NULL)
+      Node_indexChild(oNChild, oNParent->psIndex);
+   if(oNParent->psPaths != NULL)
+      Node_addPaths(oNParent->psPaths, oNChild);
+   Node_addToSubtrees(oNParent, oNChild->ulSubtree);
+   return SUCCESS;
+}
+
+/*
+  Unlinks child oNChild from oNParent's children.
+*/
+static void Node_removeChild(Node_T oNParent, Node_T oNChild) {
+   struct Index *psIndex;
+   size_t ulIndex;
+   size_t ulCount;
+
+   assert(oNParent != NULL);
+   assert(oNChild != NULL);
+
+   if(BTree_bsearch(oNParent->oBChildren,
+         (char *) oNChild->pcName, &ulIndex,
+         (int (*)(const void*,const void*)) Node_compareName))
+      (void) BTree_removeAt(oNParent->oBChildren, ulIndex);
+
+   psIndex = oNParent->psIndex;
+   if(psIndex == NULL)
+      return;
+   Node_unindex(oNParent, oNChild);
+   ulCount = Node_getNumChildren(oNParent);
+
+#ifndef THREADSAFE
+   /* demote once small enough */
+   if(ulCount < INDEX_THRESHOLD / 2) {
+      oNParent->psIndex = NULL;
+      Node_retireIndex(psIndex);
+      return;
+   }
+#endif
+
+   /* shrink once mostly empty; if the smaller index cannot be
+      allocated, the larger one is still correct */
+   if(psIndex->ulSize > 4 * Node_indexSize(ulCount))
+      (void) Node_buildIndex(oNParent, Node_indexSize(ulCount));
+}
+
+/*
+  Returns TRUE if oNParent's path is a prefix of oPPath, comparing
+  oNParent and each of its ancestors with the component of oPPath at
+  the same level, and FALSE otherwise.
+*/
+static boolean Node_isAncestorOf(Node_T oNParent, Path_T oPPath) {
+   Node_T oNCurr;
+   const char *pcComponent;
+
+   assert(oNParent != NULL);
+   assert(oPPath != NULL);
+
+   for(oNCurr = oNParent; oNCurr != NULL; oNCurr = oNCurr->oNParent) {
+      /* a component beyond oPPath's depth is NULL, never a name */
+      pcComponent = Path_getComponent(oPPath, oNCurr->ulDepth - 1);
+      if(pcComponent == NULL || !Node_isNamed(oNCurr, pcComponent))
+         return FALSE;
+   }
+   return TRUE;
+}
+
+/*
+  Returns ulSize, the size of a copy of a name, rounded up so that the
+  copy after it in a chain's block is aligned as Atom_copy requires.
+*/
+static size_t Node_alignName(size_t ulSize) {
+   return (ulSize + sizeof(size_t) - 1) / sizeof(size_t) *
+      sizeof(size_t);
+}
+
+/*
+  Frees the memory of oNNode itself and its name, to its arena if it
+  has one. A node of a chain gives up only its share of the chain's
+  block.
+*/
+static void Node_freeStorage(Node_T oNNode) {
+   assert(oNNode != NULL);
+
+   if(oNNode->psChain != NULL) {
+      if(oNNode->psArena == NULL)
+         Atom_free(oNNode->pcName);
+      Node_releaseChain(oNNode->psChain, oNNode->psArena);
+   }
+   else if(oNNode->psArena != NULL)
+      Arena_free(oNNode->psArena, oNNode,
+                 sizeof(struct node) + Atom_copySize(oNNode->pcName));
+   else {
+      Atom_free(oNNode->pcName);
+      Slab_free(&sNodeSlab, oNNode);
+   }
+}
+
+/*
+  Frees node pvNode, which has no children left, with its lock, index,
+  path and name. Has the signature Epoch_retire expects.
+*/
+static void Node_reclaim(void *pvNode) {
+   Node_T oNNode = pvNode;
+
+   assert(oNNode != NULL);
+
+#ifdef THREADSAFE
+   (void) pthread_rwlock_destroy(&oNNode->sLock);
+#endif
+   BTree_free(oNNode->oBChildren);
+   Node_freeIndex(oNNode->psIndex);
+   Node_freePath(oNNode);
+   Node_freeStorage(oNNode);
+}
+
+/*
+  Initializes the fields of psNew, whose storage, arena, chain and name
+  are already set, as a node of depth ulDepth with parent oNParent,
+  which is a file with contents pvContents of length ulLength if
+  bIsFile is TRUE and a directory otherwise. Does not link it into
+  oNParent. Returns SUCCESS, or MEMORY_ERROR after undoing its own
+  work if its children or lock could not be set up.
+*/
+static int Node_init(struct node *psNew, Node_T oNParent,
+                     size_t ulDepth, boolean bIsFile, void *pvContents,
+                     size_t ulLength) {
+   assert(psNew != NULL);
+
+   psNew->oBChildren = BTree_newIn(psNew->psArena);
+   if(psNew->oBChildren == NULL)
+      return MEMORY_ERROR;
+   psNew->ulDepth = ulDepth;
+   psNew->ulSubtree = 1;
+   psNew->ulPathHash = Node_hashPath(
+      oNParent == NULL ? 0 : oNParent->ulPathHash,
+      Atom_getHash(psNew->pcName));
+   psNew->psPaths = NULL;
+   psNew->pcPath = NULL;
+   psNew->psFilter = NULL;
+   psNew->psDirs = oNParent == NULL ? NULL : oNParent->psDirs;
+   psNew->psHandle = NULL;
+   psNew->oNParent = oNParent;
+   psNew->psIndex = NULL;
+   psNew->nodetype = bIsFile;
+   psNew->bRemoved = FALSE;
+   psNew->filecontents = pvContents;
+   psNew->length = ulLength;
+#ifdef THREADSAFE
+   if(pthread_rwlock_init(&psNew->sLock, NULL) != 0) {
+      BTree_free(psNew->oBChildren);
+      return MEMORY_ERROR;
+   }
+#endif
+   return SUCCESS;
+}
+
+/*
+  Creates a node named by atom pcName at depth ulDepth, from psArena if
+  it is not NULL, and links it into oNParent if that is not NULL,
+  without checking that it belongs there. Returns SUCCESS and sets
+  *poNResult to the node, or sets *poNResult to NULL and returns
+  MEMORY_ERROR, or NOT_A_DIRECTORY if oNParent is a file.
+*/
+static int Node_build(const char *pcName, size_t ulDepth,
+                      Node_T oNParent, struct Arena *psArena,
+                      boolean bIsFile, void *pvContents,
+                      size_t ulLength, Node_T *poNResult) {
+   struct node *psNew;
+   int iStatus;
+
+   assert(pcName != NULL);
+   assert(poNResult != NULL);
+
+   /* allocate space for a new node, with its name if in an arena */
+   if(psArena != NULL)
+      psNew = Arena_alloc(psArena,
+                          sizeof(struct node) + Atom_copySize(pcName));
+   else
+      psNew = Slab_alloc(&sNodeSlab);
+   if(psNew == NULL) {
+      *poNResult = NULL;
+      return MEMORY_ERROR;
+   }
+
+   /* initialize the new node */
+   psNew->psArena = psArena;
+   psNew->psChain = NULL;
+   if(psArena != NULL)
+      psNew->pcName = Atom_copy(pcName, psNew + 1);
+   else
+      psNew->pcName = Atom_retain(pcName);
+   iStatus = Node_init(psNew, oNParent, ulDepth, bIsFile, pvContents,
+                       ulLength);
+   if(iStatus != SUCCESS) {
+      Node_freeStorage(psNew);
+      *poNResult = NULL;
+      return iStatus;
+   }
+
+   /* Link into parent's children list */
+   if(oNParent != NULL) {
+      iStatus = Node_addChild(oNParent, psNew);
+      if(iStatus != SUCCESS) {
+         Node_reclaim(psNew);
+         *poNResult = NULL;
+         return iStatus;
+      }
+   }
+
+   *poNResult = psNew;
+
+   return SUCCESS;
+}
+
+int Node_newChain(Path_T oPPath, Node_T oNParent, struct Arena *psArena,
+                  boolean bIsFile, void *pvContents, size_t ulLength,
+                  Node_T *poNFirst) {
+   struct Chain *psChain;
+   struct node *psNodes;
+   struct Index *psIndex;
+   char *pcIndexes;
+   char *pcNames;
+   const char *pcName;
+   Node_T oNExisting;
+   size_t ulDepth, ulFirst, ulCount, ulSize, ulIndexSize, i;
+   boolean bLast;
+   int iStatus = SUCCESS;
+
+   assert(oPPath != NULL);
+   assert(poNFirst != NULL);
+
+   *poNFirst = NULL;
+   ulDepth = Path_getDepth(oPPath);
+
+   /* validate oNParent once; the nodes below it are new, and empty */
+   if(oNParent != NULL) {
+      psArena = oNParent->psArena;
+      if(!Node_isAncestorOf(oNParent, oPPath))
+         return CONFLICTING_PATH;
+      if(ulDepth <= oNParent->ulDepth)
+         return NO_SUCH_PATH;
+      if(oNParent->nodetype == TRUE)
+         return NOT_A_DIRECTORY;
+      if(Node_getChildByName(oNParent,
+            Path_getComponent(oPPath, oNParent->ulDepth), &oNExisting) ==
+         SUCCESS)
+         return ALREADY_IN_TREE;
+      ulFirst = oNParent->ulDepth + 1;
+   }
+   else if(ulDepth == 0)
+      return NO_SUCH_PATH;
+   else
+      ulFirst = 1;
+
+   /* a single node is allocated on its own */
+   ulCount = ulDepth - ulFirst + 1;
+   if(ulCount == 1)
+      return Node_build(Path_getComponent(oPPath, ulDepth - 1), ulDepth,
+                        oNParent, psArena, bIsFile, pvContents,
+                        ulLength, poNFirst);
+
+   /* allocate the whole chain in one block: the nodes, then the
+      indexes of all but the last if every parent needs one, then
+      their names if in an arena */
+   ulIndexSize = sizeof(struct Index) + INDEX_MIN_SIZE * sizeof(Node_T);
+   ulSize = sizeof(struct Chain) + ulCount * sizeof(struct node);
+   if(INDEX_THRESHOLD == 0)
+      ulSize += (ulCount - 1) * ulIndexSize;
+   if(psArena != NULL)
+      for(i = ulFirst - 1; i < ulDepth; i++)
+         ulSize += Node_alignName(
+            Atom_copySize(Path_getComponent(oPPath, i)));
+   psChain = psArena != NULL ? Arena_alloc(psArena, ulSize) :
+      malloc(ulSize);
+   if(psChain == NULL)
+      return MEMORY_ERROR;
+   /* the build holds a share of its own until the end, so that a
+      failure frees the block exactly when the last part is undone */
+   psChain->ulLive = 1;
+   psChain->ulSize = ulSize;
+   psNodes = (struct node *) (psChain + 1);
+   pcIndexes = (char *) (psNodes + ulCount);
+   pcNames = INDEX_THRESHOLD == 0 ?
+      pcIndexes + (ulCount - 1) * ulIndexSize : pcIndexes;
+
+   /* build the nodes top down, each the only child of the one above */
+   for(i = 0; i < ulCount; i++) {
+      pcName = Path_getComponent(oPPath, ulFirst - 1 + i);
+      psNodes[i].psArena = psArena;
+      psNodes[i].psChain = psChain;
+      psChain->ulLive++;
+      if(psArena != NULL) {
+         psNodes[i].pcName = Atom_copy(pcName, pcNames);
+         pcNames += Node_alignName(Atom_copySize(pcName));
+      }
+      else
+         psNodes[i].pcName = Atom_retain(pcName);
+
+      bLast = (boolean) (i + 1 == ulCount);
+      iStatus = Node_init(&psNodes[i],
+                          i == 0 ? oNParent : &psNodes[i - 1],
+                          ulFirst + i, (boolean) (bLast && bIsFile),
+                          bLast ? pvContents : NULL,
+                          bLast ? ulLength : 0);
+      if(iStatus != SUCCESS) {
+         Node_freeStorage(&psNodes[i]);
+         break;
+      }
+      psNodes[i].ulSubtree = ulCount - i;
+      if(INDEX_THRESHOLD == 0 && !bLast) {
+         psIndex = (struct Index *) pcIndexes;
+         pcIndexes += ulIndexSize;
+         psIndex->psArena = psArena;
+         psIndex->psChain = psChain;
+         psIndex->ulSize = INDEX_MIN_SIZE;
+         psIndex->ulUsed = 0;
+         memset(psIndex->aoNSlots, 0, INDEX_MIN_SIZE * sizeof(Node_T));
+         psNodes[i].psIndex = psIndex;
+         psChain->ulLive++;
+      }
+
+      /* an empty B-tree has room for a first child without
+         allocating, but is not relied on to */
+      if(i != 0) {
+         if(!BTree_add(psNodes[i - 1].oBChildren, &psNodes[i])) {
+            Node_reclaim(&psNodes[i]);
+            iStatus = MEMORY_ERROR;
+            break;
+         }
+         if(psNodes[i - 1].psIndex != NULL)
+            Node_indexChild(&psNodes[i], psNodes[i - 1].psIndex);
+      }
+   }
+
+   /* link the chain in only once it is complete */
+   if(iStatus == SUCCESS && oNParent != NULL)
+      iStatus = Node_addChild(oNParent, &psNodes[0]);
+   if(iStatus != SUCCESS) {
+      /* undo the nodes built, bottom up */
+      while(i-- > 0)
+         Node_reclaim(&psNodes[i]);
+      Node_releaseChain(psChain, psArena);
+      return iStatus;
+   }
+
+   Node_releaseChain(psChain, psArena);
+   *poNFirst = &psNodes[0];
+   return SUCCESS;
+}
+
+int Node_newChild(Node_T oNParent, struct Arena *psArena,
+                  const char *pcStr, size_t ulLength, boolean bIsFile,
+                  void *pvContents, size_t ulContentLength,
+                  Node_T *poNResult) {
+   struct Component sComponent;
+   const char *pcName;
+   size_t ulCount;
+   size_t ulDepth = 1;
+   int iStatus;
+
+   assert(pcStr != NULL);
+   assert(poNResult != NULL);
+
+   *poNResult = NULL;
+   if(oNParent != NULL) {
+      if(oNParent->nodetype == TRUE)
+         return NOT_A_DIRECTORY;
+      psArena = oNParent->psArena;
+      ulDepth = oNParent->ulDepth + 1;
+
+      /* a name after the last child's cannot be taken; any other is
+         looked up */
+      sComponent.pcStr = pcStr;
+      sComponent.ulLength = ulLength;
+      ulCount = Node_getNumChildren(oNParent);
+      if(ulCount != 0 &&
+         Node_compareComponent(BTree_get(oNParent->oBChildren,
+                                         ulCount - 1),
+                               &sComponent) >= 0 &&
+         Node_getChildByComponent(oNParent, pcStr, ulLength,
+                                  poNResult) == SUCCESS)
+         return ALREADY_IN_TREE;
+   }
+
+   iStatus = Atom_new(pcStr, ulLength, &pcName);
+   if(iStatus != SUCCESS)
+      return iStatus;
+   iStatus = Node_build(pcName, ulDepth, oNParent, psArena, bIsFile,
+                        pvContents, ulContentLength, poNResult);
+   Atom_free(pcName);
+   return iStatus;
+}
 
+#ifdef THREADSAFE
 /*
-  Links new child oNChild into oNParent's children array at index
-  ulIndex. Returns SUCCESS if the new child was added successfully,
-  or  MEMORY_ERROR if allocation fails adding oNChild to the array. Returns NOT_A_DIRECTORY if oNParent is a file.
+  Clears the slot of the directory cache that may hold node pvNode,
+  which no lookup can cache again, and retires it again to be freed.
+  Has the signature Epoch_retire expects.
 */
-static int Node_addChild(Node_T oNParent, Node_T oNChild,
-                         size_t ulIndex) {
-   assert(oNParent != NULL);
-   assert(oNChild != NULL);
+static void Node_evict(void *pvNode) {
+   Node_T oNNode = pvNode;
 
-   if(oNParent->nodetype == TRUE){
-      return NOT_A_DIRECTORY;
-   }
+   assert(oNNode != NULL);
+   assert(oNNode->psDirs != NULL);
 
-   if(DynArray_addAt(oNParent->oDChildren, ulIndex, oNChild))
-      return SUCCESS;
-   else
-      return MEMORY_ERROR;
+   Node_clearSlot(oNNode->psDirs, oNNode);
+   Epoch_retire(&oNNode->sRetired, Node_reclaim, oNNode);
 }
+#endif
 
 /*
-  Compares the string representation of oNfirst with a string
-  pcSecond representing a node's path.
-  Returns <0, 0, or >0 if oNFirst is "less than", "equal to", or
-  "greater than" pcSecond, respectively.
+  Frees oNNode, which has been unlinked from the tree, once no reader
+  that holds no lock can still be looking at it. A directory that a
+  directory cache may hold is marked removed and evicted first.
 */
-static int Node_compareString(const Node_T oNFirst,
-                                 const char *pcSecond) {
-   assert(oNFirst != NULL);
-   assert(pcSecond != NULL);
+static void Node_retire(Node_T oNNode) {
+   assert(oNNode != NULL);
+#ifdef THREADSAFE
+   if(oNNode->psDirs != NULL && oNNode->nodetype == FALSE) {
+      __atomic_store_n(&oNNode->bRemoved, TRUE, __ATOMIC_RELEASE);
+      Epoch_retire(&oNNode->sRetired, Node_evict, oNNode);
+   }
+   else
+      Epoch_retire(&oNNode->sRetired, Node_reclaim, oNNode);
+#else
+   if(oNNode->psDirs != NULL && oNNode->nodetype == FALSE)
+      Node_clearSlot(oNNode->psDirs, oNNode);
+   Node_reclaim(oNNode);
+#endif
+}
+
+size_t Node_free(Node_T oNNode) {
+   Node_T oNParent;
+   Node_T oNCurr;
+   Node_T oNNext;
+   size_t ulChildren;
+   size_t ulCount = 1;
+
+   assert(oNNode != NULL);
 
-   return Path_compareString(oNFirst->oPPath, pcSecond);
+   /* detach the subtree from the rest of the tree, once */
+   oNParent = oNNode->oNParent;
+   if(oNParent != NULL)
+      Node_removeChild(oNParent, oNNode);
+
+   /* free the subtree in post-order without recursion: descend into
+      the last remaining child until reaching a node with none, free
+      that node, and climb back to its parent. Taking the last child
+      shifts no siblings, and the parent's hash index is about to be
+      freed whole, so it is not maintained along the way. Each node is
+      locked on the way down, so threads already inside the subtree
+      drain out below it before anything they hold is freed; readers
+      that take no locks are waited for by Node_retire instead. */
+   oNCurr = oNNode;
+   Node_lockExclusive(oNCurr);
+   for(;;) {
+      ulChildren = BTree_getLength(oNCurr->oBChildren);
+      if(ulChildren != 0) {
+         oNCurr = BTree_removeAt(oNCurr->oBChildren, ulChildren - 1);
+         Node_lockExclusive(oNCurr);
+         continue;
+      }
+      if(oNCurr == oNNode)
+         break;
+
+      oNNext = oNCurr->oNParent;
+      Node_closeHandle(oNCurr);
+      Node_unlock(oNCurr);
+      Node_removePath(oNCurr);
+      Node_unfilter(oNCurr);
+      Node_retire(oNCurr);
+      ulCount++;
+      oNCurr = oNNext;
+   }
+
+   /* every thread that was inside has drained out, having counted
+      what it added, so the subtree's size is final */
+   assert(oNNode->ulSubtree == ulCount);
+   if(oNParent != NULL)
+      Node_addToSubtrees(oNParent, (size_t) 0 - ulCount);
+   Node_closeHandle(oNNode);
+   Node_unlock(oNNode);
+   Node_removePath(oNNode);
+   Node_unfilter(oNNode);
+   Node_retire(oNNode);
+   return ulCount;
 }
 
+size_t Node_detach(Node_T oNNode) {
+   assert(oNNode != NULL);
+
+   /* its nodes stay in the path index until Node_freeLater is done,
+      so lookups must tell them from the tree's from now on */
+   if(oNNode->psPaths != NULL)
+      Node_countDetached(&oNNode->psPaths->ulDetached, 1);
+   if(oNNode->oNParent != NULL) {
+      Node_removeChild(oNNode->oNParent, oNNode);
+      Node_addToSubtrees(oNNode->oNParent,
+                         (size_t) 0 - oNNode->ulSubtree);
+      /* lookups by path may be climbing through it */
+      EPOCH_PUBLISH(oNNode->oNParent, NULL);
+   }
+   return oNNode->ulSubtree;
+}
 
 /*
-  Creates a new node with path oPPath and parent oNParent.  Returns an
-  int SUCCESS status and sets *poNResult to be the new node if
-  successful. Otherwise, sets *poNResult to NULL and returns status:
-  * MEMORY_ERROR if memory could not be allocated to complete request
-  * CONFLICTING_PATH if oNParent's path is not an ancestor of oPPath
-  * NO_SUCH_PATH if oPPath is of depth 0
-                 or oNParent's path is not oPPath's direct parent
-                 or oNParent is NULL but oPPath is not of depth 1
-  * ALREADY_IN_TREE if oNParent already has a child with this path
+  Frees the tree rooted at oNRoot, which Node_detach detached, and
+  stops counting it in its path index.
 */
-int Node_newDir(Path_T oPPath, Node_T oNParent, Node_T *poNResult) {
-   struct node *psNew;
-   Path_T oPParentPath = NULL;
-   Path_T oPNewPath = NULL;
-   size_t ulParentDepth;
-   size_t ulIndex;
-   int iStatus;
+static void Node_freeDetached(Node_T oNRoot) {
+   struct PathIndex *psPaths;
 
-   assert(oPPath != NULL);
+   assert(oNRoot != NULL);
 
-   /* allocate space for a new node */
-   psNew = malloc(sizeof(struct node));
-   if(psNew == NULL) {
-      *poNResult = NULL;
-      return MEMORY_ERROR;
+   psPaths = oNRoot->psPaths;
+   (void) Node_free(oNRoot);
+   if(psPaths != NULL)
+      Node_countDetached(&psPaths->ulDetached, (size_t) 0 - 1);
+}
+
+#ifdef THREADSAFE
+/*
+  Frees the trees queued by Node_freeLater, one at a time, for as
+  long as the process runs. Has the signature pthread_create expects.
+*/
+static void *Node_reclaimer(void *pvUnused) {
+   Node_T oNRoot;
+
+   (void) pvUnused;
+
+   (void) pthread_mutex_lock(&sQueueLock);
+   for(;;) {
+      while(oNQueueHead == NULL)
+         (void) pthread_cond_wait(&sQueueCond, &sQueueLock);
+      oNRoot = oNQueueHead;
+      oNQueueHead = oNRoot->oNParent;
+      if(oNQueueHead == NULL)
+         oNQueueTail = NULL;
+      (void) pthread_mutex_unlock(&sQueueLock);
+
+      EPOCH_PUBLISH(oNRoot->oNParent, NULL);
+      Node_freeDetached(oNRoot);
+
+      (void) pthread_mutex_lock(&sQueueLock);
+      if(--ulPending == 0)
+         (void) pthread_cond_broadcast(&sQueueCond);
    }
+   return NULL;
+}
 
-   /* set the new node's path */
-   iStatus = Path_dup(oPPath, &oPNewPath);
-   if(iStatus != SUCCESS) {
-      free(psNew);
-      *poNResult = NULL;
-      return iStatus;
+/*
+  Starts the reclaimer thread unless it is running. Must be called
+  with sQueueLock held. Returns TRUE if the thread is running.
+*/
+static boolean Node_startReclaimer(void) {
+   pthread_t sThread;
+
+   if(!bReclaimerStarted &&
+      pthread_create(&sThread, NULL, Node_reclaimer, NULL) == 0) {
+      (void) pthread_detach(sThread);
+      bReclaimerStarted = TRUE;
+   }
+   return bReclaimerStarted;
+}
+#endif
+
+void Node_freeLater(Node_T oNNode) {
+   assert(oNNode != NULL);
+   assert(oNNode->oNParent == NULL);
+
+#ifdef THREADSAFE
+   (void) pthread_mutex_lock(&sQueueLock);
+   if(Node_startReclaimer()) {
+      if(oNQueueTail == NULL)
+         oNQueueHead = oNNode;
+      else
+         EPOCH_PUBLISH(oNQueueTail->oNParent, oNNode);
+      oNQueueTail = oNNode;
+      ulPending++;
+      (void) pthread_cond_broadcast(&sQueueCond);
+      (void) pthread_mutex_unlock(&sQueueLock);
+      return;
    }
-   psNew->oPPath = oPNewPath;
+   (void) pthread_mutex_unlock(&sQueueLock);
+#endif
 
-   /* validate and set the new node's parent */
-   if(oNParent != NULL) {
-      size_t ulSharedDepth;
-
-      oPParentPath = oNParent->oPPath;
-      ulParentDepth = Path_getDepth(oPParentPath);
-      ulSharedDepth = Path_getSharedPrefixDepth(psNew->oPPath,
-                                                oPParentPath);
-      /* parent must be an ancestor of child */
-      if(ulSharedDepth < ulParentDepth) {
-         Path_free(psNew->oPPath);
-         free(psNew);
-         *poNResult = NULL;
-         return CONFLICTING_PATH;
-      }
+   /* there is no thread to hand the tree to */
+   Node_freeDetached(oNNode);
+}
 
-      /* parent must be exactly one level up from child */
-      if(Path_getDepth(psNew->oPPath) != ulParentDepth + 1) {
-         Path_free(psNew->oPPath);
-         free(psNew);
-         *poNResult = NULL;
-         return NO_SUCH_PATH;
-      }
+void Node_waitForReclaimer(void) {
+#ifdef THREADSAFE
+   (void) pthread_mutex_lock(&sQueueLock);
+   while(ulPending != 0)
+      (void) pthread_cond_wait(&sQueueCond, &sQueueLock);
+   (void) pthread_mutex_unlock(&sQueueLock);
+#endif
+}
 
-      /* parent must not already have child with this path */
-      if(Node_hasChild(oNParent, oPPath, &ulIndex)) {
-         Path_free(psNew->oPPath);
-         free(psNew);
-         *poNResult = NULL;
-         return ALREADY_IN_TREE;
-      }
+struct PathIndex *Node_newPathIndex(void) {
+   struct PathIndex *psPaths;
+
+   psPaths = malloc(sizeof(struct PathIndex));
+   if(psPaths == NULL)
+      return NULL;
+   psPaths->psTable = calloc(1, sizeof(struct Index) +
+                             INDEX_MIN_SIZE * sizeof(Node_T));
+   if(psPaths->psTable == NULL) {
+      free(psPaths);
+      return NULL;
    }
-   else {
-      /* new node must be root */
-      /* can only create one "level" at a time */
-      if(Path_getDepth(psNew->oPPath) != 1) {
-         Path_free(psNew->oPPath);
-         free(psNew);
-         *poNResult = NULL;
-         return NO_SUCH_PATH;
-      }
+#ifdef THREADSAFE
+   if(pthread_mutex_init(&psPaths->sLock, NULL) != 0) {
+      free(psPaths->psTable);
+      free(psPaths);
+      return NULL;
    }
-   psNew->oNParent = oNParent;
+#endif
+   psPaths->psTable->psArena = NULL;
+   psPaths->psTable->psChain = NULL;
+   psPaths->psTable->ulSize = INDEX_MIN_SIZE;
+   psPaths->psTable->ulUsed = 0;
+   psPaths->ulCount = 0;
+   psPaths->ulReserved = 0;
+   psPaths->ulDetached = 0;
+   return psPaths;
+}
 
-   /* initialize the new node */
-   psNew->oDChildren = DynArray_new(0);
-   if(psNew->oDChildren == NULL) {
-      Path_free(psNew->oPPath);
-      free(psNew);
-      *poNResult = NULL;
+void Node_freePathIndex(struct PathIndex *psPaths) {
+   if(psPaths == NULL)
+      return;
+#ifdef THREADSAFE
+   (void) pthread_mutex_destroy(&psPaths->sLock);
+#endif
+   free(psPaths->psTable);
+   free(psPaths);
+}
+
+int Node_indexPaths(Node_T oNRoot, struct PathIndex *psPaths) {
+   assert(oNRoot != NULL);
+   assert(oNRoot->oNParent == NULL);
+   assert(psPaths != NULL);
+
+   if(Node_copyPaths(oNRoot) != SUCCESS)
+      return MEMORY_ERROR;
+   if(Node_reservePaths(psPaths, oNRoot->ulSubtree) != SUCCESS) {
+      Node_dropPaths(oNRoot);
       return MEMORY_ERROR;
    }
-   psNew->nodetype = FALSE; 
-   psNew->filecontents = NULL;
-   psNew->length = 0;
+   Node_addPaths(psPaths, oNRoot);
+   return SUCCESS;
+}
 
-   /* Link into parent's children list */
-   if(oNParent != NULL) {
-      iStatus = Node_addChild(oNParent, psNew, ulIndex);
-      if(iStatus != SUCCESS) {
-         Path_free(psNew->oPPath);
-         free(psNew);
-         *poNResult = NULL;
-         return iStatus;
+int Node_findPath(struct PathIndex *psPaths, Node_T oNRoot,
+                  const struct PathView *psView, Node_T *poNResult) {
+   struct Index *psTable;
+   Node_T oNSlot;
+   const char *pcPath;
+   size_t ulLength;
+   size_t ulPathHash;
+   size_t ulDepth;
+   size_t ulMask;
+   size_t ulSlot;
+   boolean bDetached;
+
+   assert(psPaths != NULL);
+   assert(psView != NULL);
+   assert(poNResult != NULL);
+
+   pcPath = PathView_getPathname(psView);
+   ulLength = PathView_getStrLength(psView);
+   ulPathHash = Node_hashView(psView);
+   ulDepth = PathView_getDepth(psView);
+
+   bDetached = Node_anyDetached(&psPaths->ulDetached);
+
+   *poNResult = NULL;
+   psTable = EPOCH_READ(psPaths->psTable);
+   ulMask = psTable->ulSize - 1;
+   for(ulSlot = ulPathHash & ulMask;
+       (oNSlot = EPOCH_READ(psTable->aoNSlots[ulSlot])) != NULL;
+       ulSlot = (ulSlot + 1) & ulMask) {
+      if(oNSlot != &sVacated && oNSlot->ulPathHash == ulPathHash &&
+         oNSlot->ulDepth == ulDepth &&
+         (bDetached ? Node_hasPath(oNSlot, oNRoot, pcPath, ulLength) :
+          Node_matchesPath(oNSlot, pcPath, ulLength))) {
+         *poNResult = oNSlot;
+         return SUCCESS;
       }
    }
+   return NO_SUCH_PATH;
+}
 
-   *poNResult = psNew;
+struct PathFilter *Node_newPathFilter(size_t ulPaths, double dRate) {
+   struct PathFilter *psFilter;
+   size_t ulHashes;
+   size_t ulSize;
+   double dReached;
+
+   /* an unblocked filter of m counters with k per path, for n paths,
+      is best with k = (m / n) ln 2, when it is wrong for a fraction
+      2^-k of the paths not in it; blocked, it needs m / n = 5 k / 2,
+      rather than k / ln 2, to be as precise; so k is the first with
+      2^-k <= dRate, and m the first power of 2 >= 5 k n / 2 */
+   for(ulHashes = 1, dReached = 0.5;
+       dReached > dRate && ulHashes < FILTER_MAX_HASHES;
+       ulHashes++, dReached /= 2)
+      ;
+   for(ulSize = FILTER_BLOCK;
+       ulSize / 5 * 2 / ulHashes < ulPaths &&
+       ulSize < ((size_t) -1 >> 1);
+       ulSize *= 2)
+      ;
+
+   psFilter = malloc(sizeof(struct PathFilter));
+   if(psFilter == NULL)
+      return NULL;
+   psFilter->pucCounters = calloc(ulSize, 1);
+   if(psFilter->pucCounters == NULL) {
+      free(psFilter);
+      return NULL;
+   }
+   psFilter->ulMask = ulSize - 1;
+   psFilter->ulHashes = ulHashes;
+   return psFilter;
+}
 
-   return SUCCESS;
+void Node_freePathFilter(struct PathFilter *psFilter) {
+   if(psFilter == NULL)
+      return;
+   free(psFilter->pucCounters);
+   free(psFilter);
 }
 
-int Node_newFile(Path_T oPPath, Node_T oNParent, Node_T *poNResult, void* contents, size_t ulLength) {
-   struct node *psNew;
-   Path_T oPParentPath = NULL;
-   Path_T oPNewPath = NULL;
-   size_t ulParentDepth;
-   size_t ulIndex;
-   int iStatus;
+void Node_filterPaths(Node_T oNRoot, struct PathFilter *psFilter) {
+   assert(oNRoot != NULL);
+   assert(oNRoot->oNParent == NULL);
+   assert(psFilter != NULL);
 
-   assert(oPPath != NULL);
+   Node_filterSubtree(psFilter, oNRoot, TRUE);
+}
 
-   /* allocate space for a new node */
-   psNew = malloc(sizeof(struct node));
-   if(psNew == NULL) {
-      *poNResult = NULL;
-      return MEMORY_ERROR;
+boolean Node_mayHavePath(struct PathFilter *psFilter,
+                         const struct PathView *psView) {
+   unsigned char *pucBlock;
+   unsigned char *pucCounter;
+   size_t ulPathHash;
+   size_t ulStep;
+   size_t ulSlot;
+   size_t i;
+
+   assert(psFilter != NULL);
+   assert(psView != NULL);
+
+   ulPathHash = Node_hashView(psView);
+   pucBlock = Node_filterBlock(psFilter, ulPathHash);
+   Node_filterProbe(ulPathHash, &ulSlot, &ulStep);
+   for(i = 0; i < psFilter->ulHashes; ulSlot += ulStep, ulStep += i, i++) {
+      pucCounter = &pucBlock[ulSlot & (FILTER_BLOCK - 1)];
+#ifdef THREADSAFE
+      if(__atomic_load_n(pucCounter, __ATOMIC_RELAXED) == 0)
+         return FALSE;
+#else
+      if(*pucCounter == 0)
+         return FALSE;
+#endif
    }
+   return TRUE;
+}
 
-   /* set the new node's path */
-   iStatus = Path_dup(oPPath, &oPNewPath);
-   if(iStatus != SUCCESS) {
-      free(psNew);
-      *poNResult = NULL;
-      return iStatus;
+struct DirCache *Node_newDirCache(size_t ulSlots) {
+   struct DirCache *psCache;
+   size_t ulSize;
+
+   for(ulSize = INDEX_MIN_SIZE; ulSize < ulSlots; ulSize *= 2)
+      ;
+   psCache = malloc(sizeof(struct DirCache));
+   if(psCache == NULL)
+      return NULL;
+   psCache->psSlots = calloc(ulSize, sizeof(struct DirSlot));
+   if(psCache->psSlots == NULL) {
+      free(psCache);
+      return NULL;
    }
-   psNew->oPPath = oPNewPath;
+   psCache->ulMask = ulSize - 1;
+   psCache->ulHits = 0;
+   psCache->ulMisses = 0;
+   return psCache;
+}
 
-   /* validate and set the new node's parent */
-   if(oNParent != NULL) {
-      size_t ulSharedDepth;
-
-      oPParentPath = oNParent->oPPath;
-      ulParentDepth = Path_getDepth(oPParentPath);
-      ulSharedDepth = Path_getSharedPrefixDepth(psNew->oPPath,
-                                                oPParentPath);
-      /* parent must be an ancestor of child */
-      if(ulSharedDepth < ulParentDepth) {
-         Path_free(psNew->oPPath);
-         free(psNew);
-         *poNResult = NULL;
-         return CONFLICTING_PATH;
-      }
+void Node_freeDirCache(struct DirCache *psCache) {
+   if(psCache == NULL)
+      return;
+   free(psCache->psSlots);
+   free(psCache);
+}
 
-      /* parent must be exactly one level up from child */
-      if(Path_getDepth(psNew->oPPath) != ulParentDepth + 1) {
-         Path_free(psNew->oPPath);
-         free(psNew);
-         *poNResult = NULL;
-         return NO_SUCH_PATH;
-      }
+void Node_cacheDirs(Node_T oNRoot, struct DirCache *psCache) {
+   Node_T oNCurr;
 
-      /* parent must not already have child with this path */
-      if(Node_hasChild(oNParent, oPPath, &ulIndex)) {
-         Path_free(psNew->oPPath);
-         free(psNew);
-         *poNResult = NULL;
-         return ALREADY_IN_TREE;
-      }
+   assert(oNRoot != NULL);
+   assert(oNRoot->oNParent == NULL);
+   assert(psCache != NULL);
+
+   for(oNCurr = oNRoot; oNCurr != NULL;
+       oNCurr = Node_nextInSubtree(oNRoot, oNCurr))
+      oNCurr->psDirs = psCache;
+}
+
+void Node_getDirCacheStats(struct DirCache *psCache, size_t *pulHits,
+                           size_t *pulMisses) {
+   assert(psCache != NULL);
+   assert(pulHits != NULL);
+   assert(pulMisses != NULL);
+
+#ifdef THREADSAFE
+   *pulHits = __atomic_load_n(&psCache->ulHits, __ATOMIC_RELAXED);
+   *pulMisses = __atomic_load_n(&psCache->ulMisses, __ATOMIC_RELAXED);
+#else
+   *pulHits = psCache->ulHits;
+   *pulMisses = psCache->ulMisses;
+#endif
+}
+
+int Node_findCached(struct DirCache *psCache, Node_T oNRoot,
+                    const struct PathView *psView, Node_T *poNResult) {
+   size_t aulHashes[CACHE_PROBES + 1];
+   size_t aulOffsets[CACHE_PROBES + 1];
+   const char *pcComponent;
+   Node_T oNCurr = NULL;
+   Node_T oNDeepest = NULL;
+   size_t ulPathHash = 0;
+   size_t ulOffset = 0;
+   size_t ulLength = 0;
+   size_t ulDepth = 0;
+   size_t ulLevel;
+
+   assert(psCache != NULL);
+   assert(oNRoot != NULL);
+   assert(psView != NULL);
+   assert(poNResult != NULL);
+
+   *poNResult = NULL;
+
+   /* hash every prefix, keeping the deepest few and where each ends */
+   while((pcComponent = PathView_nextComponent(psView, &ulOffset,
+                                               &ulLength)) != NULL) {
+      ulPathHash = Node_hashPath(ulPathHash,
+                                 Atom_hash(pcComponent, ulLength));
+      ulDepth++;
+      aulHashes[ulDepth % (CACHE_PROBES + 1)] = ulPathHash;
+      aulOffsets[ulDepth % (CACHE_PROBES + 1)] = ulOffset;
+   }
+
+   /* start from the deepest cached directory above the path's last
+      component; the root is never cached, as it is at hand */
+   for(ulLevel = ulDepth - 1;
+       ulLevel >= 2 && ulLevel + CACHE_PROBES >= ulDepth; ulLevel--) {
+      ulPathHash = aulHashes[ulLevel % (CACHE_PROBES + 1)];
+      ulOffset = aulOffsets[ulLevel % (CACHE_PROBES + 1)];
+      oNCurr = Node_readSlot(psCache, ulPathHash);
+      if(oNCurr != NULL && oNCurr->ulPathHash == ulPathHash &&
+         oNCurr->ulDepth == ulLevel &&
+         Node_hasPath(oNCurr, oNRoot, PathView_getPathname(psView),
+                      ulOffset - 1))
+         break;
+      oNCurr = NULL;
    }
+
+   if(oNCurr != NULL)
+      Node_countLookup(&psCache->ulHits);
    else {
-      /* new node must be root */
-      /* can only create one "level" at a time */
-      if(Path_getDepth(psNew->oPPath) != 1) {
-         Path_free(psNew->oPPath);
-         free(psNew);
-         *poNResult = NULL;
+      if(ulDepth > 2)
+         Node_countLookup(&psCache->ulMisses);
+      ulOffset = 0;
+      pcComponent = PathView_nextComponent(psView, &ulOffset,
+                                           &ulLength);
+      if(Atom_getLength(oNRoot->pcName) != ulLength ||
+         memcmp(oNRoot->pcName, pcComponent, ulLength) != 0)
          return NO_SUCH_PATH;
-      }
+      oNCurr = oNRoot;
+   }
+   ulLevel = oNCurr->ulDepth;
+
+   while((pcComponent = PathView_nextComponent(psView, &ulOffset,
+                                               &ulLength)) != NULL) {
+      oNDeepest = oNCurr;
+      if(Node_getChildByComponent(oNCurr, pcComponent, ulLength,
+                                  &oNCurr) != SUCCESS)
+         break;
    }
-   psNew->oNParent = oNParent;
 
-   /* initialize the new node */
-   psNew->oDChildren = DynArray_new(0);
-   if(psNew->oDChildren == NULL) {
-      Path_free(psNew->oPPath);
-      free(psNew);
-      *poNResult = NULL;
-      return MEMORY_ERROR;
+   /* cache the deepest directory reached above the last component;
+      files are never cached, as Node_retire evicts only directories */
+   if(oNDeepest != NULL && oNDeepest->ulDepth > ulLevel &&
+      oNDeepest->nodetype == FALSE && oNDeepest->psDirs == psCache)
+      Node_fillSlot(psCache, oNDeepest);
+
+   if(oNCurr == NULL)
+      return NO_SUCH_PATH;
+   *poNResult = oNCurr;
+   return SUCCESS;
+}
+
+struct HandleTable *Node_newHandleTable(void) {
+   struct HandleTable *psTable;
+
+   psTable = malloc(sizeof(struct HandleTable));
+   if(psTable == NULL)
+      return NULL;
+#ifdef THREADSAFE
+   if(pthread_mutex_init(&psTable->sLock, NULL) != 0) {
+      free(psTable);
+      return NULL;
    }
-   psNew->nodetype = TRUE; /* add parameter for yp*/
-   psNew->filecontents = contents;
-   psNew->length = ulLength;
+#endif
+   psTable->psChunks = NULL;
+   psTable->psFree = NULL;
+   psTable->ulDetaches = 0;
+   return psTable;
+}
 
-   /* Link into parent's children list */
-   if(oNParent != NULL) {
-      iStatus = Node_addChild(oNParent, psNew, ulIndex);
-      if(iStatus != SUCCESS) {
-         Path_free(psNew->oPPath);
-         free(psNew);
-         *poNResult = NULL;
-         return iStatus;
-      }
+void Node_freeHandleTable(struct HandleTable *psTable) {
+   struct HandleChunk *psChunk;
+
+   if(psTable == NULL)
+      return;
+   while((psChunk = psTable->psChunks) != NULL) {
+      psTable->psChunks = psChunk->psNext;
+      free(psChunk);
    }
+#ifdef THREADSAFE
+   (void) pthread_mutex_destroy(&psTable->sLock);
+#endif
+   free(psTable);
+}
 
-   *poNResult = psNew;
+int Node_openHandle(struct HandleTable *psTable, Node_T oNNode,
+                    struct NodeHandle **ppsHandle,
+                    size_t *pulGeneration) {
+   struct NodeHandle *psHandle;
+   struct HandleChunk *psChunk;
+   size_t i;
 
+   assert(psTable != NULL);
+   assert(oNNode != NULL);
+   assert(ppsHandle != NULL);
+   assert(pulGeneration != NULL);
+
+   Node_lockHandles(psTable);
+   psHandle = oNNode->psHandle;
+   if(psHandle == NULL) {
+      /* with no entry free, add a block of them to the free list */
+      if(psTable->psFree == NULL) {
+         psChunk = malloc(sizeof(struct HandleChunk));
+         if(psChunk == NULL) {
+            Node_unlockHandles(psTable);
+            return MEMORY_ERROR;
+         }
+         for(i = 0; i < HANDLE_CHUNK; i++) {
+            psChunk->asEntries[i].oNNode = NULL;
+            psChunk->asEntries[i].ulGeneration = 0;
+            psChunk->asEntries[i].ulSeen = 0;
+            psChunk->asEntries[i].psTable = psTable;
+            psChunk->asEntries[i].psNextFree =
+               i + 1 < HANDLE_CHUNK ? &psChunk->asEntries[i + 1] :
+               NULL;
+         }
+         psChunk->psNext = psTable->psChunks;
+         psTable->psChunks = psChunk;
+         psTable->psFree = &psChunk->asEntries[0];
+      }
+      psHandle = psTable->psFree;
+      psTable->psFree = psHandle->psNextFree;
+      EPOCH_PUBLISH(psHandle->ulSeen, EPOCH_READ(psTable->ulDetaches));
+      EPOCH_PUBLISH(psHandle->oNNode, oNNode);
+      oNNode->psHandle = psHandle;
+   }
+   *ppsHandle = psHandle;
+   *pulGeneration = psHandle->ulGeneration;
+   Node_unlockHandles(psTable);
    return SUCCESS;
 }
 
+void Node_countDetach(struct HandleTable *psTable) {
+   assert(psTable != NULL);
 
-size_t Node_free(Node_T oNNode) {
-   size_t ulIndex;
-   size_t ulCount = 0;
+   EPOCH_PUBLISH(psTable->ulDetaches, psTable->ulDetaches + 1);
+}
 
-   assert(oNNode != NULL);
+Node_T Node_resolveHandle(struct NodeHandle *psHandle,
+                          size_t ulGeneration, Node_T oNRoot) {
+   struct HandleTable *psTable;
+   Node_T oNNode;
+   Node_T oNCurr;
+   size_t ulDetaches;
+   size_t i;
 
-   /* remove from parent's list */
-   if(oNNode->oNParent != NULL) {
-      if(DynArray_bsearch(
-            oNNode->oNParent->oDChildren,
-            oNNode, &ulIndex,
-            (int (*)(const void *, const void *)) Node_compare)
-        )
-         (void) DynArray_removeAt(oNNode->oNParent->oDChildren,
-                                  ulIndex);
-   }
+   if(psHandle == NULL)
+      return NULL;
+
+   /* the node is read first: a reused entry's new node is published
+      after its generation advances */
+   oNNode = EPOCH_READ(psHandle->oNNode);
+   if(oNNode == NULL ||
+      EPOCH_READ(psHandle->ulGeneration) != ulGeneration)
+      return NULL;
 
-   /* recursively remove children */
-   while(DynArray_getLength(oNNode->oDChildren) != 0) {
-      ulCount += Node_free(DynArray_get(oNNode->oDChildren, 0));
+   /* since a detach, the node may be in a subtree waiting to be
+      freed: its ancestors then lead somewhere other than the root */
+   psTable = psHandle->psTable;
+   ulDetaches = EPOCH_READ(psTable->ulDetaches);
+   if(EPOCH_READ(psHandle->ulSeen) != ulDetaches) {
+      for(oNCurr = oNNode, i = 1; oNCurr != NULL && i < oNNode->ulDepth;
+          i++)
+         oNCurr = EPOCH_READ(oNCurr->oNParent);
+      if(oNCurr == NULL || oNCurr != oNRoot)
+         return NULL;
+      EPOCH_PUBLISH(psHandle->ulSeen, ulDetaches);
    }
-   DynArray_free(oNNode->oDChildren);
+   return oNNode;
+}
 
-   /* remove path */
-   Path_free(oNNode->oPPath);
+boolean Node_isHandleCurrent(struct NodeHandle *psHandle,
+                             size_t ulGeneration) {
+   assert(psHandle != NULL);
 
-   /* finally, free the struct node */
-   free(oNNode);
-   ulCount++;
-   return ulCount;
+   return (boolean) (EPOCH_READ(psHandle->ulGeneration) == ulGeneration);
+}
+
+size_t Node_getDepth(Node_T oNNode) {
+   assert(oNNode != NULL);
+
+   return oNNode->ulDepth;
 }
 
-Path_T Node_getPath(Node_T oNNode) {
+size_t Node_getPathLength(Node_T oNNode) {
+   size_t ulLength = 0;
+
    assert(oNNode != NULL);
 
-   return oNNode->oPPath;
+   /* each name is followed by a delimiter, except the last */
+   for(; oNNode != NULL; oNNode = oNNode->oNParent)
+      ulLength += Atom_getLength(oNNode->pcName) + 1;
+   return ulLength - 1;
+}
+
+char *Node_writePath(Node_T oNNode, char *pcDest) {
+   char *pcEnd;
+   size_t ulLength;
+
+   assert(oNNode != NULL);
+   assert(pcDest != NULL);
+
+   /* fill in names from the end of the path back to the root */
+   pcEnd = pcDest + Node_getPathLength(oNNode);
+   *pcEnd = '\0';
+   for(; oNNode != NULL; oNNode = oNNode->oNParent) {
+      ulLength = Atom_getLength(oNNode->pcName);
+      pcEnd -= ulLength;
+      memcpy(pcEnd, oNNode->pcName, ulLength);
+      if(pcEnd != pcDest)
+         *--pcEnd = '/';
+   }
+   return pcDest;
 }
 
-boolean Node_hasChild(Node_T oNParent, Path_T oPPath,
-                         size_t *pulChildID) {
+int Node_getChildByComponent(Node_T oNParent, const char *pcStr,
+                             size_t ulLength, Node_T *poNResult) {
+   struct Component sComponent;
+   struct Index *psIndex;
+   Node_T oNChild;
+   size_t ulMask;
+   size_t ulSlot;
+#ifndef THREADSAFE
+   size_t ulIndex;
+#endif
+
    assert(oNParent != NULL);
-   assert(oPPath != NULL);
-   assert(pulChildID != NULL);
+   assert(pcStr != NULL);
+   assert(poNResult != NULL);
+
+   sComponent.pcStr = pcStr;
+   sComponent.ulLength = ulLength;
+   sComponent.ulHash = Atom_hash(pcStr, ulLength);
+
+   *poNResult = NULL;
+   psIndex = EPOCH_READ(oNParent->psIndex);
+   if(psIndex != NULL) {
+      /* probe as Node_probeIndex does, matching by characters */
+      ulMask = psIndex->ulSize - 1;
+      for(ulSlot = sComponent.ulHash & ulMask;
+          (oNChild = EPOCH_READ(psIndex->aoNSlots[ulSlot])) != NULL;
+          ulSlot = (ulSlot + 1) & ulMask) {
+         if(oNChild != &sVacated &&
+            Atom_getHash(oNChild->pcName) == sComponent.ulHash &&
+            Node_compareComponent(oNChild, &sComponent) == 0) {
+            *poNResult = oNChild;
+            break;
+         }
+      }
+   }
+#ifndef THREADSAFE
+   /* in the THREADSAFE build a directory without an index has no
+      children, and a caller holding no lock must not search the
+      BTree while another thread changes it */
+   else if(BTree_bsearch(oNParent->oBChildren, &sComponent, &ulIndex,
+              (int (*)(const void*,const void*)) Node_compareComponent))
+      *poNResult = BTree_get(oNParent->oBChildren, ulIndex);
+#endif
+
+   if(*poNResult == NULL)
+      return NO_SUCH_PATH;
+   return SUCCESS;
+}
+
+int Node_getChildByName(Node_T oNParent, const char *pcName,
+                        Node_T *poNResult) {
+   size_t ulIndex;
+
+   assert(oNParent != NULL);
+   assert(pcName != NULL);
+   assert(poNResult != NULL);
+
+   if(oNParent->psIndex != NULL)
+      *poNResult = oNParent->psIndex->aoNSlots[
+         Node_probeIndex(oNParent->psIndex, pcName)];
+   else if(BTree_bsearch(oNParent->oBChildren, (char *) pcName,
+              &ulIndex,
+              (int (*)(const void*,const void*)) Node_compareName))
+      *poNResult = BTree_get(oNParent->oBChildren, ulIndex);
+   else
+      *poNResult = NULL;
+
+   if(*poNResult == NULL)
+      return NO_SUCH_PATH;
+   return SUCCESS;
+}
+
+size_t Node_getChildID(Node_T oNNode) {
+   size_t ulChildID;
+
+   assert(oNNode != NULL);
+   assert(oNNode->oNParent != NULL);
 
-   /* *pulChildID is the index into oNParent->oDChildren */
-   return DynArray_bsearch(oNParent->oDChildren,
-            (char*) Path_getPathname(oPPath), pulChildID,
-            (int (*)(const void*,const void*)) Node_compareString);
+   /* oNNode is always found among its parent's children */
+   (void) BTree_bsearch(oNNode->oNParent->oBChildren,
+            (char *) oNNode->pcName, &ulChildID,
+            (int (*)(const void*,const void*)) Node_compareName);
+   return ulChildID;
 }
 
 size_t Node_getNumChildren(Node_T oNParent) {
    assert(oNParent != NULL);
 
-   return DynArray_getLength(oNParent->oDChildren);
+   return BTree_getLength(oNParent->oBChildren);
 }
 
 int  Node_getChild(Node_T oNParent, size_t ulChildID,
@@ -332,28 +2400,27 @@ int  Node_getChild(Node_T oNParent, size_t ulChildID,
    assert(oNParent != NULL);
    assert(poNResult != NULL);
 
-   /* ulChildID is the index into oNParent->oDChildren */
+   /* ulChildID is the index into oNParent->oBChildren */
    if(ulChildID >= Node_getNumChildren(oNParent)) {
       *poNResult = NULL;
       return NO_SUCH_PATH;
    }
    else {
-      *poNResult = DynArray_get(oNParent->oDChildren, ulChildID);
+      *poNResult = BTree_get(oNParent->oBChildren, ulChildID);
       return SUCCESS;
    }
 }
 
-Node_T Node_getParent(Node_T oNNode) {
+const char *Node_getName(Node_T oNNode) {
    assert(oNNode != NULL);
 
-   return oNNode->oNParent;
+   return oNNode->pcName;
 }
 
-int Node_compare(Node_T oNFirst, Node_T oNSecond) {
-   assert(oNFirst != NULL);
-   assert(oNSecond != NULL);
+Node_T Node_getParent(Node_T oNNode) {
+   assert(oNNode != NULL);
 
-   return Path_comparePath(oNFirst->oPPath, oNSecond->oPPath);
+   return oNNode->oNParent;
 }
 
 char *Node_toString(Node_T oNNode) {
@@ -361,11 +2428,11 @@ char *Node_toString(Node_T oNNode) {
 
    assert(oNNode != NULL);
 
-   copyPath = malloc(Path_getStrLength(Node_getPath(oNNode))+1);
+   copyPath = malloc(Node_getPathLength(oNNode)+1);
    if(copyPath == NULL)
       return NULL;
    else
-      return strcpy(copyPath, Path_getPathname(Node_getPath(oNNode)));
+      return Node_writePath(oNNode, copyPath);
 }
 
 /*--------------------------------------------------------------------*/
@@ -381,15 +2448,15 @@ boolean Node_type(Node_T oNNode){
 void* Node_data(Node_T oNNode){
    assert(oNNode != NULL);
 
-   return oNNode->filecontents;
+   return EPOCH_READ(oNNode->filecontents);
 }
 
 /*--------------------------------------------------------------------*/
 
-boolean Node_len(Node_T oNNode){
+size_t Node_len(Node_T oNNode){
    assert(oNNode != NULL);
 
-   return oNNode->length;
+   return EPOCH_READ(oNNode->length);
 }
 
 /*--------------------------------------------------------------------*/
@@ -397,6 +2464,27 @@ boolean Node_len(Node_T oNNode){
 void Node_changeData(Node_T oNNode, void* newData, size_t newLength){
    assert(oNNode != NULL);
 
-   oNNode->filecontents = newData;
-   oNNode->length = newLength;
-}
\ No newline at end of file
+   EPOCH_PUBLISH(oNNode->filecontents, newData);
+   EPOCH_PUBLISH(oNNode->length, newLength);
+}
+
+void Node_lockShared(Node_T oNNode) {
+   assert(oNNode != NULL);
+#ifdef THREADSAFE
+   (void) pthread_rwlock_rdlock(&oNNode->sLock);
+#endif
+}
+
+void Node_lockExclusive(Node_T oNNode) {
+   assert(oNNode != NULL);
+#ifdef THREADSAFE
+   (void) pthread_rwlock_wrlock(&oNNode->sLock);
+#endif
+}
+
+void Node_unlock(Node_T oNNode) {
+   assert(oNNode != NULL);
+#ifdef THREADSAFE
+   (void) pthread_rwlock_unlock(&oNNode->sLock);
+#endif
+}
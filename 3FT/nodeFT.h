@@ -11,60 +11,324 @@
 #include "path.h"
 
 
-/* A Node_T is a node in a Directory Tree */
+/*
+  A Node_T is a node in a Directory Tree. In the THREADSAFE build each
+  node has a reader-writer lock guarding its children and contents,
+  which lookups by name and reads of contents do not need. Only
+  Node_free takes it itself.
+*/
 typedef struct node *Node_T;
 
+struct Arena;
+
 /*
-  Creates a new Dir in the Directory Tree, with path oPPath and
-  parent oNParent. Returns an int SUCCESS status and sets *poNResult
-  to be the new node if successful. Otherwise, sets *poNResult to NULL
-  and returns status:
+  Creates a node for every component of oPPath below oNParent, each a
+  Dir except the last, which is a File with contents pvContents of
+  length ulLength if bIsFile is TRUE. If oNParent is NULL the nodes
+  start at the root and come from psArena, if that is not NULL;
+  otherwise they come from wherever oNParent's did. A failure leaves
+  the tree unchanged. Returns
+  an int SUCCESS status and sets *poNFirst to the highest new node if
+  successful. Otherwise, sets *poNFirst to NULL and returns status:
   * MEMORY_ERROR if memory could not be allocated to complete request
   * CONFLICTING_PATH if oNParent's path is not an ancestor of oPPath
   * NO_SUCH_PATH if oPPath is of depth 0
-                 or oNParent's path is not oPPath's direct parent
-                 or oNParent is NULL but oPPath is not of depth 1
-  * ALREADY_IN_TREE if oNParent already has a child with this path
+                 or oPPath is no deeper than oNParent's path
+  * ALREADY_IN_TREE if oNParent already has a child with the next
+                    component of oPPath
+  * NOT_A_DIRECTORY if oNParent is a file
 */
-int Node_newDir(Path_T oPPath, Node_T oNParent, Node_T *poNResult);
-
+int Node_newChain(Path_T oPPath, Node_T oNParent, struct Arena *psArena,
+                  boolean bIsFile, void *pvContents, size_t ulLength,
+                  Node_T *poNFirst);
 
 /*
-  Creates a new File in the Directory Tree, with path oPPath and
-  parent oNParent. Gives the file to have value contents and with 
-  length ulLength. Returns an int SUCCESS status and sets *poNResult
-  to be the new node if successful. Otherwise, sets *poNResult to NULL
-  and returns status:
-  * MEMORY_ERROR if memory could not be allocated to complete request
-  * CONFLICTING_PATH if oNParent's path is not an ancestor of oPPath
-  * NO_SUCH_PATH if oPPath is of depth 0
-                 or oNParent's path is not oPPath's direct parent
-                 or oNParent is NULL but oPPath is not of depth 1
-  * ALREADY_IN_TREE if oNParent already has a child with this path
+  Creates a child of oNParent named by the ulLength characters at
+  pcStr, which need not be '\0'-terminated: a File with contents
+  pvContents of length ulContentLength if bIsFile is TRUE, and a Dir
+  otherwise. If oNParent is NULL, creates a root instead, from psArena
+  if that is not NULL. A name that sorts after every existing child's,
+  as when children are added in order, is appended without a search.
+  Returns an int SUCCESS status and sets *poNResult to the new node if
+  successful. Otherwise, returns status:
+  * MEMORY_ERROR if memory could not be allocated to complete request,
+                 setting *poNResult to NULL
+  * NOT_A_DIRECTORY if oNParent is a file, setting *poNResult to NULL
+  * ALREADY_IN_TREE if oNParent already has a child with that name,
+                    setting *poNResult to that child
 */
-int Node_newFile(Path_T oPPath, Node_T oNParent, Node_T *poNResult, void* contents, size_t ulLength);
+int Node_newChild(Node_T oNParent, struct Arena *psArena,
+                  const char *pcStr, size_t ulLength, boolean bIsFile,
+                  void *pvContents, size_t ulContentLength,
+                  Node_T *poNResult);
 
 /*
   Destroys and frees all memory allocated for the subtree rooted at
   oNNode, i.e., deletes this node and all its descendents. Returns the
-  number of nodes deleted.
+  number of nodes deleted. Does not recurse, so a subtree of any
+  depth can be freed.
+  In the THREADSAFE build the caller must hold the lock of oNNode's
+  parent (if any) exclusively and no lock in the subtree. The memory
+  is reclaimed through the epoch collector (see epoch.h).
 */
 size_t Node_free(Node_T oNNode);
 
-/* Returns the path object representing oNNode's absolute path. */
-Path_T Node_getPath(Node_T oNNode);
+/*
+  Unlinks the subtree rooted at oNNode from its parent, if any,
+  without visiting it, to be freed later by Node_freeLater. Returns
+  the number of nodes in it.
+  In the THREADSAFE build the caller must hold the lock of oNNode's
+  parent (if any) exclusively, and no other thread may hold or be
+  waiting for any node lock in the tree; lookups that take no locks
+  may run.
+*/
+size_t Node_detach(Node_T oNNode);
+
+/*
+  Frees the tree rooted at oNNode, which has no parent, as Node_free
+  does, but in the THREADSAFE build hands it to a background thread
+  and returns at once. Frees it before returning in the other build,
+  or if the thread cannot be started.
+*/
+void Node_freeLater(Node_T oNNode);
+
+/*
+  Waits until every tree passed to Node_freeLater so far has been
+  freed. Their nodes may still wait for the epoch collector.
+*/
+void Node_waitForReclaimer(void);
+
+/*
+  A path index maps the absolute path of every node of one tree to the
+  node. Each node in it keeps a copy of its absolute path. Nodes added
+  below an indexed tree's nodes join the index, and freed nodes leave
+  it; a detached subtree stays in it until freed, but is not found.
+*/
+struct PathIndex;
+
+/*
+  Returns a new, empty path index, or NULL if memory could not be
+  allocated.
+*/
+struct PathIndex *Node_newPathIndex(void);
+
+/*
+  Frees psPaths, or does nothing if it is NULL. Nodes still in it
+  must not be used with it again; the nodes themselves are untouched.
+*/
+void Node_freePathIndex(struct PathIndex *psPaths);
+
+/*
+  Adds every node of the tree rooted at oNRoot, which has no parent,
+  to psPaths. Returns SUCCESS, or MEMORY_ERROR, adding none of them,
+  if memory could not be allocated.
+  In the THREADSAFE build no other thread may be changing the tree.
+*/
+int Node_indexPaths(Node_T oNRoot, struct PathIndex *psPaths);
+
+/*
+  Looks up the node in psPaths with the absolute path psView describes
+  in the tree whose root is oNRoot. Returns an int SUCCESS status and
+  sets *poNResult to the node, if found. Otherwise, sets *poNResult to
+  NULL and returns status:
+  * NO_SUCH_PATH if no such node is in the index
+  Does not allocate memory. In the THREADSAFE build the caller need
+  hold no lock, provided it is inside an epoch read-side section (see
+  epoch.h) until it is done with the result.
+*/
+int Node_findPath(struct PathIndex *psPaths, Node_T oNRoot,
+                  const struct PathView *psView, Node_T *poNResult);
+
+/*
+  A path filter is a counting Bloom filter over the absolute paths of
+  every node of one tree. Nodes added below a counted tree's nodes are
+  counted, and freed nodes are uncounted.
+*/
+struct PathFilter;
 
 /*
-  Returns TRUE if oNParent has a child with path oPPath. Returns
-  FALSE if it does not.
+  Returns a new, empty path filter sized as FT_filterPaths describes,
+  or NULL if memory could not be allocated.
+*/
+struct PathFilter *Node_newPathFilter(size_t ulPaths, double dRate);
 
-  If oNParent has such a child, stores in *pulChildID the child's
-  identifier (as used in Node_getChild). If oNParent does not have
-  such a child, stores in *pulChildID the identifier that such a
-  child _would_ have if inserted.
+/*
+  Frees psFilter, or does nothing if it is NULL. Nodes still counted
+  in it must not be used with it again; the nodes are untouched.
 */
-boolean Node_hasChild(Node_T oNParent, Path_T oPPath,
-                         size_t *pulChildID);
+void Node_freePathFilter(struct PathFilter *psFilter);
+
+/*
+  Counts every node of the tree rooted at oNRoot, which has no parent,
+  in psFilter. Does not allocate memory. In the THREADSAFE build no
+  other thread may be changing the tree.
+*/
+void Node_filterPaths(Node_T oNRoot, struct PathFilter *psFilter);
+
+/*
+  Returns FALSE if no node counted in psFilter has the absolute path
+  psView describes, and TRUE if one may. In the THREADSAFE build the
+  caller need hold no lock.
+*/
+boolean Node_mayHavePath(struct PathFilter *psFilter,
+                         const struct PathView *psView);
+
+/*
+  A directory cache holds, in a fixed number of slots, directories
+  that lookups have recently reached, so that later lookups below them
+  can start there. Nodes added below a cached tree's nodes use it too,
+  and Node_free evicts only the directories it frees.
+*/
+struct DirCache;
+
+/*
+  Returns a new, empty directory cache of at least ulSlots slots, or
+  NULL if memory could not be allocated.
+*/
+struct DirCache *Node_newDirCache(size_t ulSlots);
+
+/*
+  Frees psCache, or does nothing if it is NULL. The nodes that use it
+  must be freed first, and in the THREADSAFE build Epoch_barrier
+  called since.
+*/
+void Node_freeDirCache(struct DirCache *psCache);
+
+/*
+  Makes psCache the directory cache of every node of the tree rooted
+  at oNRoot, which has no parent. Does not allocate memory.
+  In the THREADSAFE build no other thread may be changing the tree.
+*/
+void Node_cacheDirs(Node_T oNRoot, struct DirCache *psCache);
+
+/*
+  Stores in *pulHits and *pulMisses the number of lookups through
+  psCache that did and did not start from a cached directory. Lookups
+  of paths of two components or fewer count as neither.
+*/
+void Node_getDirCacheStats(struct DirCache *psCache, size_t *pulHits,
+                           size_t *pulMisses);
+
+/*
+  Does what Node_findPath does, but by a lookup at each level below
+  the deepest directory of the path in psCache, or below oNRoot, and
+  caches the deepest directory it reaches. Does not allocate memory.
+  In the THREADSAFE build the caller need hold no lock, provided it is
+  inside an epoch read-side section (see epoch.h) until it is done
+  with the result.
+*/
+int Node_findCached(struct DirCache *psCache, Node_T oNRoot,
+                    const struct PathView *psView, Node_T *poNResult);
+
+/*
+  A handle table holds an entry, named by its address and a
+  generation, for each node of one tree that a client has opened.
+  Node_free frees the entries of the nodes it frees and advances their
+  generations, making handles to them stale. A detached subtree keeps
+  its entries until freed, but once Node_countDetach has been called
+  they are no longer resolved.
+*/
+struct HandleTable;
+struct NodeHandle;
+
+/*
+  Returns a new, empty handle table, or NULL if memory could not be
+  allocated.
+*/
+struct HandleTable *Node_newHandleTable(void);
+
+/*
+  Frees psTable and all its entries, or does nothing if it is NULL.
+  Handles to them must not be used again; the nodes are untouched.
+*/
+void Node_freeHandleTable(struct HandleTable *psTable);
+
+/*
+  Opens a handle to oNNode in psTable, sharing oNNode's entry if it
+  has one already: stores the entry in *ppsHandle and its generation
+  in *pulGeneration, and returns SUCCESS, or returns MEMORY_ERROR if
+  a new entry was needed and memory could not be allocated.
+  In the THREADSAFE build the caller must hold oNNode's lock, shared
+  or exclusively.
+*/
+int Node_openHandle(struct HandleTable *psTable, Node_T oNNode,
+                    struct NodeHandle **ppsHandle,
+                    size_t *pulGeneration);
+
+/*
+  Records in psTable that a subtree of its tree has been detached by
+  Node_detach. In the THREADSAFE build the caller must keep other
+  threads from detaching subtrees meanwhile.
+*/
+void Node_countDetach(struct HandleTable *psTable);
+
+/*
+  Returns the node that the handle with entry psHandle and generation
+  ulGeneration was opened to, or NULL if psHandle is NULL or the node
+  has since been freed or detached from the tree whose root is oNRoot.
+  In the THREADSAFE build the caller need hold no lock, provided it is
+  inside an epoch read-side section (see epoch.h) until it is done
+  with the result, which may be freed meanwhile unless the caller
+  locks it and then checks it with Node_isHandleCurrent.
+*/
+Node_T Node_resolveHandle(struct NodeHandle *psHandle,
+                          size_t ulGeneration, Node_T oNRoot);
+
+/*
+  Returns TRUE if the node the handle with entry psHandle and
+  generation ulGeneration was opened to has not been freed. Once the
+  caller holds the node's lock, the answer holds until it lets go.
+*/
+boolean Node_isHandleCurrent(struct NodeHandle *psHandle,
+                             size_t ulGeneration);
+
+/*
+  Returns the number of components in oNNode's absolute path, i.e.,
+  1 for the root, 2 for its children, and so on.
+*/
+size_t Node_getDepth(Node_T oNNode);
+
+/*
+  Returns the length (not including trailing '\0') of oNNode's
+  absolute path, walking up to the root.
+*/
+size_t Node_getPathLength(Node_T oNNode);
+
+/*
+  Reconstructs oNNode's absolute path into pcDest, which must have
+  room for at least Node_getPathLength(oNNode) + 1 characters, and
+  returns pcDest. Does not allocate memory, so a caller can reuse one
+  buffer to reconstruct the paths of many nodes.
+*/
+char *Node_writePath(Node_T oNNode, char *pcDest);
+
+/*
+  Returns an int SUCCESS status and sets *poNResult to be the child
+  of oNParent named pcName, which must be an atom (see atom.h), if one
+  exists. Otherwise, sets *poNResult to NULL and returns status:
+  * NO_SUCH_PATH if oNParent has no child named pcName
+  Takes expected constant time in large directories, and does not
+  allocate memory.
+*/
+int Node_getChildByName(Node_T oNParent, const char *pcName,
+                        Node_T *poNResult);
+
+/*
+  Does what Node_getChildByName does for the child whose name is the
+  ulLength characters at pcStr, which need not be '\0'-terminated or
+  an atom.
+  In the THREADSAFE build the caller need hold no lock, provided it is
+  inside an epoch read-side section (see epoch.h) from before it
+  reached oNParent until it is done with the result.
+*/
+int Node_getChildByComponent(Node_T oNParent, const char *pcStr,
+                             size_t ulLength, Node_T *poNResult);
+
+/*
+  Returns oNNode's identifier among its parent's children (as used in
+  Node_getChild). oNNode must not be the root.
+*/
+size_t Node_getChildID(Node_T oNNode);
 
 /* Returns the number of children that oNParent has. */
 size_t Node_getNumChildren(Node_T oNParent);
@@ -74,22 +338,22 @@ size_t Node_getNumChildren(Node_T oNParent);
   node of oNParent with identifier ulChildID, if one exists.
   Otherwise, sets *poNResult to NULL and returns status:
   * NO_SUCH_PATH if ulChildID is not a valid child for oNParent
+  Identifiers number the children in order of name.
 */
 int Node_getChild(Node_T oNParent, size_t ulChildID,
                   Node_T *poNResult);
 
 /*
-  Returns a the parent node of oNNode.
-  Returns NULL if oNNode is the root and thus has no parent.
+  Returns the name of oNNode: the atom for the final component of
+  its absolute path.
 */
-Node_T Node_getParent(Node_T oNNode);
+const char *Node_getName(Node_T oNNode);
 
 /*
-  Compares oNFirst and oNSecond lexicographically based on their paths.
-  Returns <0, 0, or >0 if onFirst is "less than", "equal to", or
-  "greater than" oNSecond, respectively.
+  Returns a the parent node of oNNode.
+  Returns NULL if oNNode is the root and thus has no parent.
 */
-int Node_compare(Node_T oNFirst, Node_T oNSecond);
+Node_T Node_getParent(Node_T oNNode);
 
 /*
   Returns a string representation for oNNode, or NULL if
@@ -106,9 +370,10 @@ char *Node_toString(Node_T oNNode);
 boolean Node_type(Node_T oNNode);
 
 /*
-   Returns the length of the data in oNNode
+   Returns the length of the data in oNNode. In the THREADSAFE build
+   this and Node_data may be called without oNNode's lock.
 */
-boolean Node_len(Node_T oNNode);
+size_t Node_len(Node_T oNNode);
 
 /*
    Returns the data located in oNNode only if it is a file.
@@ -121,6 +386,25 @@ void* Node_data(Node_T oNNode);
 */
 void Node_changeData(Node_T oNNode, void* newData, size_t newLength);
 
+/*
+  Acquires oNNode's lock for reading its children or contents, in the
+  THREADSAFE build; otherwise does nothing. Locks are taken parent
+  before child.
+*/
+void Node_lockShared(Node_T oNNode);
+
+/*
+  Acquires oNNode's lock for changing its children or contents, in the
+  THREADSAFE build; otherwise does nothing.
+*/
+void Node_lockExclusive(Node_T oNNode);
+
+/*
+  Releases oNNode's lock, in the THREADSAFE build; otherwise does
+  nothing.
+*/
+void Node_unlock(Node_T oNNode);
+
 
 
 #endif
@@ -90,7 +90,59 @@ size_t Path_getSharedPrefixDepth(Path_T oPPath1, Path_T oPPath2);
   ulLevel. This count is from 0, so with level 0 the root of oPPath
   would be returned.
   Returns NULL if ulLevel is greater than oPPath's maxium level.
+  The component is an atom (see atom.h), so components of any two
+  paths are equal exactly when they are the same pointer.
 */
 const char *Path_getComponent(Path_T oPPath, size_t ulLevel);
 
+/*
+  A read-only view of an absolute path held in a caller-owned string.
+  Unlike a Path_T, a view owns no memory: the caller declares it
+  (typically on the stack), fills it in with PathView_init, and may
+  use it only as long as the string it describes is unchanged.
+  The fields should be read through the PathView_* functions.
+*/
+struct PathView {
+   /* The caller's string, which uses '/' as the component delimiter */
+   const char *pcPath;
+   /* The string length of pcPath */
+   size_t ulLength;
+   /* The number of components in pcPath */
+   size_t ulDepth;
+};
+
+/*
+  Validates pcPath in a single pass and sets *psView to describe it,
+  without allocating memory. Returns SUCCESS if pcPath is well-formed.
+  Otherwise, leaves *psView unchanged and returns status:
+  * BAD_PATH if pcPath is the empty string
+             or begins with or ends with a '/'
+             or contains consecutive '/' delimiters
+*/
+int PathView_init(struct PathView *psView, const char *pcPath);
+
+/* Returns the string described by psView. */
+const char *PathView_getPathname(const struct PathView *psView);
+
+/*
+  Returns the length (not including trailing '\0') of the string
+  described by psView.
+*/
+size_t PathView_getStrLength(const struct PathView *psView);
+
+/* Returns the number of components in psView, as Path_getDepth. */
+size_t PathView_getDepth(const struct PathView *psView);
+
+/*
+  Returns a pointer to the component of psView that starts at offset
+  *pulOffset in its string, and stores that component's length in
+  *pulLength. Advances *pulOffset to the start of the next component.
+  Returns NULL, leaving *pulLength unchanged, once *pulOffset is past
+  the final component. The returned component is not '\0'-terminated.
+  Iterate from the root by starting with *pulOffset set to 0.
+*/
+const char *PathView_nextComponent(const struct PathView *psView,
+                                   size_t *pulOffset,
+                                   size_t *pulLength);
+
 #endif